@@ -309,6 +309,7 @@ void xine_engine_set_param(xine_t *self, int param, int value) XINE_PROTECTED;
 int xine_engine_get_param(xine_t *self, int param) XINE_PROTECTED;
 
 #define XINE_ENGINE_PARAM_VERBOSITY        1
+#define XINE_ENGINE_PARAM_FREE_RUN         2 /* bool, no wall time pacing, all streams */
 
 /*
  * set/get xine stream parameters
@@ -353,6 +354,7 @@ int  xine_get_param (xine_stream_t *stream, int param) XINE_PROTECTED;
 #define XINE_PARAM_EARLY_FINISHED_EVENT   31 /* send event when demux finish*/
 #define XINE_PARAM_GAPLESS_SWITCH         32 /* next stream only gapless swi*/
 #define XINE_PARAM_DELAY_FINISHED_EVENT   33 /* 1/10sec,0=>disable,-1=>forev*/
+#define XINE_PARAM_LATENCY_TRACE          34 /* bool, xine_get_latency_stats*/
 
 /*
  * speed values for XINE_PARAM_SPEED parameter.
@@ -997,6 +999,57 @@ int  xine_get_pos_length (xine_stream_t *stream,
 			  int *length_time) /* milliseconds */
   XINE_PROTECTED;
 
+/*
+ * get pipeline latency statistics
+ *
+ * with XINE_PARAM_LATENCY_TRACE enabled, the engine stamps buffers
+ * and frames when they are handed over between threads, and
+ * collects the time spent in each stage as a histogram.
+ * the drop stages count all dropped video frames and audio bufs.
+ *
+ * returns 1 on success, 0 if stage is unknown.
+ * reset != 0 clears the stage after reading.
+ */
+#define XINE_LATENCY_VIDEO_INPUT           0 /* buf allocated (input read) -> put to fifo */
+#define XINE_LATENCY_VIDEO_FIFO            1 /* put to fifo -> got by decoder             */
+#define XINE_LATENCY_VIDEO_DECODE          2 /* decode start -> end                       */
+#define XINE_LATENCY_AUDIO_INPUT           3
+#define XINE_LATENCY_AUDIO_FIFO            4
+#define XINE_LATENCY_AUDIO_DECODE          5
+#define XINE_LATENCY_FRAME_QUEUE           6 /* vo_frame_draw () -> display               */
+#define XINE_LATENCY_FRAME_LATE            7 /* frame due (vpts) -> display               */
+#define XINE_LATENCY_VIDEO_DROP            8 /* frame skipped (0) or discarded: late by   */
+#define XINE_LATENCY_AUDIO_DROP            9 /* audio buf dropped: late by                */
+#define XINE_LATENCY_STAGES               10
+
+/* bin n counts latencies of 2^(n-1) .. 2^n - 1 microseconds,
+ * the last bin counts all longer ones. */
+#define XINE_LATENCY_BINS                 24
+
+typedef struct {
+  uint32_t count;
+  uint32_t min_us;
+  uint32_t max_us;
+  uint64_t sum_us;
+  uint32_t bins[XINE_LATENCY_BINS];
+} xine_latency_stats_t;
+
+int  xine_get_latency_stats (xine_stream_t *stream, int stage,
+			     xine_latency_stats_t *stats, int reset) XINE_PROTECTED;
+
+/*
+ * get the current fill of the demux -> decoder fifos, in buffers.
+ * returns 1 on success.
+ */
+typedef struct {
+  int video_bufs;
+  int video_capacity;
+  int audio_bufs;
+  int audio_capacity;
+} xine_fifo_fill_t;
+
+int  xine_get_fifo_fill (xine_stream_t *stream, xine_fifo_fill_t *fill) XINE_PROTECTED;
+
 /*
  * get information about the stream such as
  * video width/height, codecs, audio format, title, author...
@@ -706,6 +706,44 @@ fifo_buffer_t *_x_fifo_buffer_new (int num_buffers, uint32_t buf_size) XINE_PROT
  */
 fifo_buffer_t *_x_dummy_fifo_buffer_new (int num_buffers, uint32_t buf_size) XINE_PROTECTED;
 
+/**
+ * @brief Allocate and initialise new (empty) single producer / single consumer FIFO buffers.
+ * @param num_buffer Number of buffers to allocate.
+ * @param buf_size Size of each buffer.
+ * @note Same API as _x_fifo_buffer_new (), but put and get dont wait for each
+ *       other unless the fifo runs empty or full. They only take the fifo mutex
+ *       shortly to update fifo_size and fifo_data_size. Dont use the first and
+ *       last members for anything but a NULL check there.
+ * @internal Only used by video and audio decoder loops.
+ */
+fifo_buffer_t *_x_spsc_fifo_buffer_new (int num_buffers, uint32_t buf_size) XINE_PROTECTED;
+
+/**
+ * @brief Statistics of a large buffer size class.
+ * buffer_pool_size_alloc () serves large requests from a few lazily allocated
+ * contiguous buffers of fixed sizes, instead of chaining pool buffers.
+ */
+#define FIFO_SLAB_CLASSES 4
+typedef struct {
+  uint32_t size;      /**< payload bytes per buffer */
+  uint32_t max_bufs;  /**< allocation limit */
+  uint32_t num_bufs;  /**< currently allocated */
+  uint32_t num_free;  /**< of these, unused */
+  uint32_t peak_used; /**< max ever in use at the same time */
+  uint32_t hits;      /**< requests served from the free list */
+  uint32_t misses;    /**< requests served by a new allocation */
+  uint32_t fails;     /**< requests this class could not serve */
+} fifo_slab_stats_t;
+
+/**
+ * @brief Get large buffer statistics of a FIFO.
+ * @param fifo The FIFO.
+ * @param stats Array to fill, smallest size class first.
+ * @param max_classes Size of that array.
+ * @return Number of entries filled in.
+ */
+int _x_fifo_buffer_slab_stats (fifo_buffer_t *fifo, fifo_slab_stats_t *stats, int max_classes) XINE_PROTECTED;
+
 /**
  * @brief Free chained list of buffer elements.
  * @param head List to free. May be NULL.
@@ -301,6 +301,9 @@ metronom_clock_t *_x_metronom_clock_init(xine_t *xine) XINE_MALLOC XINE_PROTECTE
  */
 
 #define CLOCK_SCR_ADJUSTABLE   1
+/* free running clock (1) for batch processing: outputs do not wait for wall time,
+ * but release frames as soon as they are decoded, still in vpts order. */
+#define CLOCK_FREE_RUN         2
 
 /*
  * SCR (system clock reference) plugins
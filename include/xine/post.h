@@ -227,6 +227,14 @@ struct post_video_port_s {
   /* you can fill this to your liking */
   void                     *user_data;
 
+  /* set this while your plugin would pass frames on unchanged anyway,
+   * eg with neutral settings; get_frame() then hands out the original
+   * frames undecorated, and they will bypass this port completely
+   * (in pipelined mode, they still line up behind earlier frames);
+   * you may change this any time; frames already handed out keep their
+   * decoration, so your draw() still needs to pass those on itself */
+  int                       bypass;
+
 #ifdef POST_INTERNAL
   /* some of the above members are to be directly included here, but
    * adding the structures would mean that post_video_port_t becomes
@@ -244,6 +252,9 @@ struct post_video_port_s {
   /* this is used to keep a linked list of free vo_frame_t's */
   vo_frame_t               *free_frame_slots;
   pthread_mutex_t           free_frames_lock;
+
+  /* the stage thread running draw() in pipelined mode, or NULL */
+  struct post_pipe_s       *pipe;
 #endif
 };
 
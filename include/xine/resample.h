@@ -62,4 +62,46 @@ void _x_audio_out_resample_monotostereo(int16_t* input_samples,
 void _x_audio_out_resample_stereotomono(int16_t* input_samples,
 					int16_t* output_samples, uint32_t frames) XINE_PROTECTED;
 
+/* 32 bit float samples, nominal range -1.0 ... 1.0. */
+void _x_audio_out_resample_s16tofloat (const int16_t *input_samples,
+                                       float *output_samples, uint32_t samples) XINE_PROTECTED;
+/* with clipping. */
+void _x_audio_out_resample_floattos16 (const float *input_samples,
+                                       int16_t *output_samples, uint32_t samples) XINE_PROTECTED;
+/* packed 3 byte samples, native byte order. */
+void _x_audio_out_resample_floattos24 (const float *input_samples,
+                                       uint8_t *output_samples, uint32_t samples) XINE_PROTECTED;
+void _x_audio_out_resample_monotostereo_float (const float *input_samples,
+                                               float *output_samples, uint32_t frames) XINE_PROTECTED;
+void _x_audio_out_resample_stereotomono_float (const float *input_samples,
+                                               float *output_samples, uint32_t frames) XINE_PROTECTED;
+
+/*
+ * band limited polyphase resampler.
+ * unlike the functions above, it keeps some frames of history, and delays
+ * the signal by (taps / 2) frames. it works for any number of channels.
+ * in_frames / out_frames may change from call to call, eg for clock drift
+ * compensation. out_frames == 0 just feeds history.
+ */
+
+typedef struct xine_resampler_s xine_resampler_t;
+
+#define XINE_RESAMPLE_QUALITY_FAST 1 /* 16 taps */
+#define XINE_RESAMPLE_QUALITY_GOOD 2 /* 32 taps */
+#define XINE_RESAMPLE_QUALITY_BEST 3 /* 64 taps */
+
+xine_resampler_t *_x_audio_out_resampler_new (int channels, int quality) XINE_PROTECTED;
+void _x_audio_out_resampler_delete (xine_resampler_t **resampler) XINE_PROTECTED;
+/* nominal rates, for the anti aliasing filter. */
+void _x_audio_out_resampler_set_rates (xine_resampler_t *resampler,
+                                       uint32_t in_rate, uint32_t out_rate) XINE_PROTECTED;
+/* forget history. */
+void _x_audio_out_resampler_reset (xine_resampler_t *resampler) XINE_PROTECTED;
+void _x_audio_out_resampler_s16 (xine_resampler_t *resampler,
+                                 const int16_t *input_samples, uint32_t in_frames,
+                                 int16_t *output_samples, uint32_t out_frames) XINE_PROTECTED;
+void _x_audio_out_resampler_float (xine_resampler_t *resampler,
+                                   const float *input_samples, uint32_t in_frames,
+                                   float *output_samples, uint32_t out_frames) XINE_PROTECTED;
+
 #endif
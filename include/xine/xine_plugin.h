@@ -50,7 +50,13 @@
  */
 #define PLUGIN_NO_UNLOAD      (1 << 6)
 
-#define PLUGIN_TYPE_MASK      ((1 << 6) - 1)
+/* input plugins only: this flag may be or'ed with type to say that
+ * special_info is an input_info_t with a valid mrl_prefixes field.
+ * plugins built with an older, shorter input_info_t dont set it.
+ */
+#define PLUGIN_INPUT_MRL_PREFIXES (1 << 5)
+
+#define PLUGIN_TYPE_MASK      ((1 << 5) - 1)
 
 typedef struct {
   uint8_t                  type;                    /* one of the PLUGIN_* constants above     */
@@ -92,6 +98,11 @@ typedef struct {
 /* special info for an input plugin */
 typedef struct {
   int                      priority;
+  /* with PLUGIN_INPUT_MRL_PREFIXES: space separated list of all mrl beginnings
+   * this plugin may accept (case insensitive), eg "rtp:// udp://".
+   * this is kept in the plugin catalog, and lets xine skip loading the plugin
+   * for other mrls. NULL means: ask for any mrl. */
+  const char              *mrl_prefixes;
 } input_info_t;
 
 
@@ -171,6 +171,9 @@ typedef struct {
 #define MM_ACCEL_X86_SSE4       0x01000000
 #define MM_ACCEL_X86_SSE42      0x00800000
 #define MM_ACCEL_X86_AVX        0x00400000
+#define MM_ACCEL_X86_AVX2       0x00200000
+#define MM_ACCEL_X86_ERMS       0x00100000
+#define MM_ACCEL_X86_AVX512     0x00080000
 
 /* powerpc accelerations and features */
 #define MM_ACCEL_PPC_ALTIVEC    0x04000000
@@ -543,6 +546,12 @@ void _x_yuy2_to_nv12(const uint8_t *src_yuy2_map, int yuy2_pitch,
                      uint8_t *uv_dst, int uv_dst_pitch,
                      int width, int height) XINE_PROTECTED;
 
+/* run func (data, 0 ... num_slices - 1), spread over shared helper threads
+ * where available. returns when all slices are done. */
+void xine_slices_run (void (*func) (void *data, int slice, int num_slices), void *data, int num_slices) XINE_PROTECTED;
+/* how many slices can run in parallel, 1 if there are no helpers. */
+int xine_slices_max (void) XINE_PROTECTED;
+
 
 /* print a hexdump of the given data */
 void xine_hexdump (const void *buf, int length) XINE_PROTECTED;
@@ -0,0 +1,426 @@
+/*
+ * Copyright (C) 2026 the xine project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ *
+ * xine-bench: headless decode path throughput benchmark.
+ * Plays MRLs through the "none" output drivers as fast as the engine lets
+ * us, and prints the results as JSON to stdout. Without MRL arguments, the
+ * generated test:// streams are used, so this runs without media files.
+ * With --audio-filters, each MRL is played once per audio filter method
+ * (engine.performance.audio_filter_method), with equalizer, compressor and
+ * amp turned on, to compare the C and SIMD filters.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <getopt.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+#include <xine.h>
+
+static const char * const default_mrls[] = {
+  "test://color_circle.y4m",
+  "test://rgb_levels.y4m",
+  "test://uv_square.y4m",
+  NULL
+};
+
+/* per thread cpu time, from /proc where available. */
+#define MAX_THREADS 256
+
+typedef struct {
+  int    tid;
+  char   name[32];
+  double user, system;
+} thread_time_t;
+
+static int get_thread_times (thread_time_t *t, int max) {
+#ifdef __linux__
+  DIR *dir = opendir ("/proc/self/task");
+  struct dirent *d;
+  double tick = sysconf (_SC_CLK_TCK);
+  int n = 0;
+
+  if (!dir)
+    return 0;
+  while ((n < max) && (d = readdir (dir))) {
+    char path[300], buf[512], *p;
+    unsigned long utime, stime;
+    FILE *f;
+    if (d->d_name[0] < '0' || d->d_name[0] > '9')
+      continue;
+    snprintf (path, sizeof (path), "/proc/self/task/%s/stat", d->d_name);
+    f = fopen (path, "r");
+    if (!f)
+      continue;
+    p = fgets (buf, sizeof (buf), f);
+    fclose (f);
+    if (!p)
+      continue;
+    /* pid (comm) state ppid ... utime is field 14, stime 15. */
+    p = strrchr (buf, ')');
+    if (!p || (sscanf (p + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu", &utime, &stime) != 2))
+      continue;
+    t[n].tid = atoi (d->d_name);
+    {
+      char *s = strchr (buf, '(');
+      size_t l = s ? (size_t)(p - s - 1) : 0;
+      if (l >= sizeof (t[n].name))
+        l = sizeof (t[n].name) - 1;
+      memcpy (t[n].name, s ? s + 1 : "", l);
+      t[n].name[l] = 0;
+    }
+    t[n].user = utime / tick;
+    t[n].system = stime / tick;
+    n++;
+  }
+  closedir (dir);
+  return n;
+#else
+  (void)t;
+  (void)max;
+  return 0;
+#endif
+}
+
+static double now_seconds (void) {
+#if defined(HAVE_POSIX_TIMERS) && defined(CLOCK_MONOTONIC)
+  struct timespec ts;
+  if (!clock_gettime (CLOCK_MONOTONIC, &ts))
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+#endif
+  {
+    struct timeval tv;
+    gettimeofday (&tv, NULL);
+    return tv.tv_sec + tv.tv_usec * 1e-6;
+  }
+}
+
+static void print_json_string (const char *s) {
+  putchar ('"');
+  for (; *s; s++) {
+    unsigned char c = *s;
+    if (c == '"' || c == '\\')
+      printf ("\\%c", c);
+    else if (c < 0x20)
+      printf ("\\u%04x", c);
+    else
+      putchar (c);
+  }
+  putchar ('"');
+}
+
+typedef struct {
+  int      capacity;
+  int      max;
+  uint64_t sum;
+} fifo_fill_t;
+
+static void fifo_sample (fifo_fill_t *fill, int n, int capacity) {
+  fill->capacity = capacity;
+  fill->sum += n;
+  if (n > fill->max)
+    fill->max = n;
+}
+
+static void print_fifo (const char *name, const fifo_fill_t *fill, unsigned int samples) {
+  printf ("\"%s\": {\"capacity\": %d, \"avg\": %.1f, \"max\": %d}",
+    name, fill->capacity, samples ? (double)fill->sum / samples : 0.0, fill->max);
+}
+
+#define AUDIO_FILTER_KEY "engine.performance.audio_filter_method"
+
+/* turn on all audio filters, with some work for each equalizer band. */
+static void enable_audio_filters (xine_stream_t *stream) {
+  int i;
+
+  for (i = XINE_PARAM_EQ_30HZ; i <= XINE_PARAM_EQ_16000HZ; i++)
+    xine_set_param (stream, i, 100 - 5 * (i - XINE_PARAM_EQ_30HZ));
+  xine_set_param (stream, XINE_PARAM_AUDIO_COMPR_LEVEL, 200);
+  xine_set_param (stream, XINE_PARAM_AUDIO_AMP_LEVEL, 90);
+}
+
+static int bench_mrl (xine_t *xine, xine_video_port_t *vo, xine_audio_port_t *ao,
+  const char *mrl, double max_seconds, int speed, const char *audio_filter, int first) {
+  xine_stream_t        *stream;
+  xine_event_queue_t   *queue;
+  xine_latency_stats_t  vdec, adec, frames, late, vdrop, adrop;
+  xine_fifo_fill_t      fill;
+  fifo_fill_t           vfill = {0, 0, 0}, afill = {0, 0, 0};
+  thread_time_t         t0[MAX_THREADS], t1[MAX_THREADS];
+  struct rusage         r0, r1;
+  double                start, seconds;
+  unsigned int          samples = 0;
+  int                   finished = 0, n0, n1, i, j;
+
+  stream = xine_stream_new (xine, ao, vo);
+  if (!stream)
+    return 0;
+  queue = xine_event_new_queue (stream);
+  xine_set_param (stream, XINE_PARAM_LATENCY_TRACE, 1);
+
+  if (!xine_open (stream, mrl)) {
+    fprintf (stderr, "xine-bench: cannot open %s\n", mrl);
+    xine_event_dispose_queue (queue);
+    xine_dispose (stream);
+    return 0;
+  }
+  if (audio_filter)
+    enable_audio_filters (stream);
+
+  n0 = get_thread_times (t0, MAX_THREADS);
+  getrusage (RUSAGE_SELF, &r0);
+  start = now_seconds ();
+
+  xine_play (stream, 0, 0);
+  if (speed > 0)
+    xine_set_param (stream, XINE_PARAM_FINE_SPEED, speed);
+
+  do {
+    xine_event_t *event;
+    while ((event = xine_event_get (queue))) {
+      if (event->type == XINE_EVENT_UI_PLAYBACK_FINISHED)
+        finished = 1;
+      xine_event_free (event);
+    }
+    if (xine_get_fifo_fill (stream, &fill)) {
+      fifo_sample (&vfill, fill.video_bufs, fill.video_capacity);
+      fifo_sample (&afill, fill.audio_bufs, fill.audio_capacity);
+      samples++;
+    }
+    if (finished)
+      break;
+    usleep (10000);
+  } while (now_seconds () - start < max_seconds);
+
+  seconds = now_seconds () - start;
+  getrusage (RUSAGE_SELF, &r1);
+  n1 = get_thread_times (t1, MAX_THREADS);
+
+  xine_get_latency_stats (stream, XINE_LATENCY_VIDEO_DECODE, &vdec, 0);
+  xine_get_latency_stats (stream, XINE_LATENCY_AUDIO_DECODE, &adec, 0);
+  xine_get_latency_stats (stream, XINE_LATENCY_FRAME_QUEUE, &frames, 0);
+  xine_get_latency_stats (stream, XINE_LATENCY_FRAME_LATE, &late, 0);
+  /* absolute counts, XINE_STREAM_INFO_SKIPPED_FRAMES is per mille. */
+  xine_get_latency_stats (stream, XINE_LATENCY_VIDEO_DROP, &vdrop, 0);
+  xine_get_latency_stats (stream, XINE_LATENCY_AUDIO_DROP, &adrop, 0);
+
+  xine_stop (stream);
+  xine_close (stream);
+  xine_event_dispose_queue (queue);
+  xine_dispose (stream);
+
+  printf ("%s\n    {\"mrl\": ", first ? "" : ",");
+  print_json_string (mrl);
+  if (audio_filter) {
+    printf (", \"audio_filter\": ");
+    print_json_string (audio_filter);
+  }
+  printf (", \"seconds\": %.3f, \"finished\": %s,\n", seconds, finished ? "true" : "false");
+  printf ("     \"video\": {\"frames\": %u, \"fps\": %.2f, \"decode_calls\": %u, \"decode_us\": %llu, "
+    "\"dropped\": %u, \"late_avg_us\": %u, \"late_max_us\": %u, ",
+    frames.count, seconds > 0 ? frames.count / seconds : 0.0, vdec.count,
+    (unsigned long long)vdec.sum_us, vdrop.count,
+    late.count ? (unsigned int)(late.sum_us / late.count) : 0, late.max_us);
+  print_fifo ("fifo", &vfill, samples);
+  printf ("},\n     \"audio\": {\"decode_calls\": %u, \"decode_us\": %llu, \"dropped\": %u, ",
+    adec.count, (unsigned long long)adec.sum_us, adrop.count);
+  print_fifo ("fifo", &afill, samples);
+  printf ("},\n     \"cpu\": {\"user\": %.3f, \"system\": %.3f, \"threads\": [",
+    (r1.ru_utime.tv_sec - r0.ru_utime.tv_sec) + (r1.ru_utime.tv_usec - r0.ru_utime.tv_usec) * 1e-6,
+    (r1.ru_stime.tv_sec - r0.ru_stime.tv_sec) + (r1.ru_stime.tv_usec - r0.ru_stime.tv_usec) * 1e-6);
+  for (i = j = 0; i < n1; i++) {
+    double user = t1[i].user, system = t1[i].system;
+    int k;
+    for (k = 0; k < n0; k++) {
+      if (t0[k].tid == t1[i].tid) {
+        user -= t0[k].user;
+        system -= t0[k].system;
+        break;
+      }
+    }
+    if (user + system <= 0.0)
+      continue;
+    printf ("%s\n       {\"tid\": %d, \"name\": ", j++ ? "," : "", t1[i].tid);
+    print_json_string (t1[i].name);
+    printf (", \"user\": %.3f, \"system\": %.3f}", user, system);
+  }
+  printf ("]}}");
+  fflush (stdout);
+
+  return 1;
+}
+
+int main (int argc, char *argv[])
+{
+  const char * const *mrls = default_mrls;
+  const char *vo_name = "none", *ao_name = "none";
+  double max_seconds = 10.0, speed = 0.0;
+  int optstate = 0, audio_filters = 0, i, ok = 0;
+
+  for (;;)
+  {
+#define OPTS "hvt:s:V:A:F"
+#ifdef HAVE_GETOPT_LONG
+    static const struct option longopts[] = {
+      { "help", no_argument, NULL, 'h' },
+      { "version", no_argument, NULL, 'v' },
+      { "time", required_argument, NULL, 't' },
+      { "speed", required_argument, NULL, 's' },
+      { "video-driver", required_argument, NULL, 'V' },
+      { "audio-driver", required_argument, NULL, 'A' },
+      { "audio-filters", no_argument, NULL, 'F' },
+      { NULL, no_argument, NULL, 0 }
+    };
+    int index = 0;
+    int opt = getopt_long (argc, argv, OPTS, longopts, &index);
+#else
+    int opt = getopt(argc, argv, OPTS);
+#endif
+    if (opt == -1)
+      break;
+
+    switch (opt)
+    {
+    case 'h':
+      optstate |= 1;
+      break;
+    case 'v':
+      optstate |= 4;
+      break;
+    case 't':
+      max_seconds = atof (optarg);
+      break;
+    case 's':
+      speed = atof (optarg);
+      break;
+    case 'V':
+      vo_name = optarg;
+      break;
+    case 'A':
+      ao_name = optarg;
+      break;
+    case 'F':
+      audio_filters = 1;
+      break;
+    default:
+      optstate |= 2;
+      break;
+    }
+  }
+
+  if (optstate & 1)
+    printf ("\
+xine-bench %s\n\
+using xine-lib %s\n\
+usage: %s [options] [MRL...]\n\
+options:\n\
+  -h, --help			this help text\n\
+  -t, --time <seconds>		max run time per MRL (default 10)\n\
+  -s, --speed <factor>		playback speed (default: free running clock)\n\
+  -V, --video-driver <name>	video output driver (default none)\n\
+  -A, --audio-driver <name>	audio output driver (default none)\n\
+  -F, --audio-filters		compare audio filter methods, needs MRLs with audio\n\
+without MRLs, generated test:// streams are used.\n\
+\n", XINE_VERSION, xine_get_version_string (), argv[0]);
+  else if (optstate & 4)
+    printf ("\
+xine-bench %s\n\
+using xine-lib %s\n\
+(c) 2026 the xine project team\n\
+This is free software; see the source for copying conditions.  There is NO\n\
+warranty; not even for MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE,\n\
+to the extent permitted by law.\n",
+	     XINE_VERSION, xine_get_version_string ());
+
+  if (optstate & 2)
+  {
+    fputs ("xine-bench: invalid option (try -h or --help)\n", stderr);
+    return 1;
+  }
+
+  if (optstate)
+    return 0;
+
+  if (optind < argc)
+    mrls = (const char * const *)argv + optind;
+  else if (audio_filters) {
+    fputs ("xine-bench: --audio-filters needs MRLs with audio\n", stderr);
+    return 1;
+  }
+  if (max_seconds <= 0.0)
+    max_seconds = 10.0;
+  if (speed < 0.0)
+    speed = 0.0;
+
+  xine_t *xine = xine_new ();
+  xine_set_flags (xine, XINE_FLAG_NO_WRITE_CACHE);
+  xine_init (xine);
+
+  xine_video_port_t *vo = xine_open_video_driver (xine, vo_name, XINE_VISUAL_TYPE_NONE, NULL);
+  xine_audio_port_t *ao = xine_open_audio_driver (xine, ao_name, NULL);
+  if (!vo || !ao)
+  {
+    fputs ("xine-bench: cannot open output drivers\n", stderr);
+    if (vo)
+      xine_close_video_driver (xine, vo);
+    if (ao)
+      xine_close_audio_driver (xine, ao);
+    xine_exit (xine);
+    return 1;
+  }
+  xine_engine_set_param (xine, XINE_ENGINE_PARAM_FREE_RUN, speed <= 0.0);
+
+  printf ("{\"xine_version\": \"%s\", \"free_run\": %s, \"speed\": %.2f, \"max_seconds\": %.2f,\n  \"runs\": [",
+    xine_get_version_string (), speed > 0.0 ? "false" : "true", speed, max_seconds);
+  if (audio_filters) {
+    xine_cfg_entry_t entry;
+    int m;
+    if (xine_config_lookup_entry (xine, AUDIO_FILTER_KEY, &entry) && (entry.type == XINE_CONFIG_TYPE_ENUM)) {
+      /* skip "probe". the audio port switches filters from the config callback. */
+      for (m = 1; entry.enum_values[m]; m++) {
+        entry.num_value = m;
+        xine_config_update_entry (xine, &entry);
+        for (i = 0; mrls[i]; i++)
+          ok += bench_mrl (xine, vo, ao, mrls[i], max_seconds, speed * XINE_FINE_SPEED_NORMAL,
+            entry.enum_values[m], !ok);
+      }
+    } else {
+      fputs ("xine-bench: no " AUDIO_FILTER_KEY " setting\n", stderr);
+    }
+  } else {
+    for (i = 0; mrls[i]; i++)
+      ok += bench_mrl (xine, vo, ao, mrls[i], max_seconds, speed * XINE_FINE_SPEED_NORMAL, NULL, !ok);
+  }
+  printf ("\n  ]\n}\n");
+
+  xine_close_video_driver (xine, vo);
+  xine_close_audio_driver (xine, ao);
+  xine_exit (xine);
+
+  return ok ? 0 : 1;
+}
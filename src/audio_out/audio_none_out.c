@@ -44,6 +44,9 @@
 
 #define AON_GAP_TOLERANCE        AO_MAX_GAP
 
+/* pretend to have a sound card buffer of this size (microseconds). */
+#define AON_BUFFER_TIME          250000
+
 typedef struct ao_none_driver_s {
 
   ao_driver_t    ao_driver;
@@ -60,6 +63,11 @@ typedef struct ao_none_driver_s {
 
   uint32_t       latency;
 
+  /* monotonic time when our pretended buffer runs empty, or
+   * the time still left in it while paused. */
+  int64_t        end_time;
+  int            paused;
+
 } ao_none_driver_t;
 
 typedef struct {
@@ -81,6 +89,8 @@ static int ao_none_open(ao_driver_t *this_gen, uint32_t bits, uint32_t rate, int
   this->mode                   = mode;
   this->sample_rate            = rate;
   this->bits_per_sample        = bits;
+  this->end_time               = 0;
+  this->paused                 = 0;
 
   switch (mode) {
   case AO_CAP_MODE_MONO:
@@ -113,17 +123,39 @@ static int ao_none_get_gap_tolerance (ao_driver_t *this_gen)
   return AON_GAP_TOLERANCE;
 }
 
+static int64_t ao_none_now (void) {
+  struct timeval tv = {0, 0};
+  xine_monotonic_clock (&tv, NULL);
+  return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
 static int ao_none_write(ao_driver_t *this_gen, int16_t *data,
                          uint32_t num_frames)
 {
   ao_none_driver_t *this = (ao_none_driver_t *) this_gen;
+  int64_t now, fill;
   (void)data;
 
-  /* take some time to pretend we are doing something.
-   * avoids burning cpu.
+  /* play in real time like a sound card would, so delay () tells the engine
+   * when we want more. block only when our pretended buffer is full.
+   * not when running as fast as possible, though.
    */
-  if( (1000 * num_frames / this->sample_rate) > 10 )
-    xine_usec_sleep ((1000 * num_frames / this->sample_rate)*1000/2);
+  if (this->xine->clock->get_option (this->xine->clock, CLOCK_FREE_RUN))
+    return 1;
+  if (this->sample_rate <= 0)
+    return 1;
+
+  now = ao_none_now ();
+  if (this->paused) {
+    this->end_time += now;
+    this->paused = 0;
+  }
+  if (this->end_time < now)
+    this->end_time = now;
+  this->end_time += (int64_t)num_frames * 1000000 / this->sample_rate;
+  fill = this->end_time - now;
+  if (fill > AON_BUFFER_TIME)
+    xine_usec_sleep (fill - AON_BUFFER_TIME);
 
   return 1;
 }
@@ -131,13 +163,21 @@ static int ao_none_write(ao_driver_t *this_gen, int16_t *data,
 
 static int ao_none_delay (ao_driver_t *this_gen)
 {
-  (void)this_gen;
-  return 0;
+  ao_none_driver_t *this = (ao_none_driver_t *) this_gen;
+  int64_t left;
+
+  if (this->sample_rate <= 0)
+    return 0;
+  left = this->paused ? this->end_time : this->end_time - ao_none_now ();
+  return left > 0 ? left * this->sample_rate / 1000000 : 0;
 }
 
 static void ao_none_close(ao_driver_t *this_gen)
 {
-  (void)this_gen;
+  ao_none_driver_t *this = (ao_none_driver_t *) this_gen;
+
+  this->end_time = 0;
+  this->paused   = 0;
 }
 
 static uint32_t ao_none_get_capabilities (ao_driver_t *this_gen) {
@@ -169,18 +209,28 @@ static int ao_none_set_property (ao_driver_t *this_gen, int property, int value)
 }
 
 static int ao_none_ctrl(ao_driver_t *this_gen, int cmd, ...) {
-  /*ao_none_driver_t *this = (ao_none_driver_t *) this_gen;*/
+  ao_none_driver_t *this = (ao_none_driver_t *) this_gen;
 
-  (void)this_gen;
   switch (cmd) {
 
   case AO_CTRL_PLAY_PAUSE:
+    if (!this->paused) {
+      int64_t left = this->end_time - ao_none_now ();
+      this->end_time = left > 0 ? left : 0;
+      this->paused = 1;
+    }
     break;
 
   case AO_CTRL_PLAY_RESUME:
+    if (this->paused) {
+      this->end_time += ao_none_now ();
+      this->paused = 0;
+    }
     break;
 
   case AO_CTRL_FLUSH_BUFFERS:
+    this->end_time = 0;
+    this->paused   = 0;
     break;
   }
 
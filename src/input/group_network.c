@@ -37,16 +37,36 @@ static const input_info_t input_hls_info = {
   .priority = 1
 };
 
+static const input_info_t input_net_info = {
+  .priority = 0,
+  .mrl_prefixes = "tcp:// gopher:// tls:// slave://"
+};
+
+static const input_info_t input_rtsp_info = {
+  .priority = 0,
+  .mrl_prefixes = "rtsp:/"
+};
+
+static const input_info_t input_pnm_info = {
+  .priority = 0,
+  .mrl_prefixes = "pnm://"
+};
+
+static const input_info_t input_ftp_info = {
+  .priority = 0,
+  .mrl_prefixes = "ftp:// ftpes://"
+};
+
 const plugin_info_t xine_plugin_info[] EXPORTED = {
   /* type, API, "name", version, special_info, init_function */
-  { PLUGIN_INPUT,                       18, "tcp",  XINE_VERSION_CODE, NULL, input_net_init_class },
-  { PLUGIN_INPUT,                       18, "tls",  XINE_VERSION_CODE, NULL, input_tls_init_class },
-  { PLUGIN_INPUT,                       18, "gopher", XINE_VERSION_CODE, NULL, input_gopher_init_class },
+  { PLUGIN_INPUT | PLUGIN_INPUT_MRL_PREFIXES, 18, "tcp",  XINE_VERSION_CODE, &input_net_info, input_net_init_class },
+  { PLUGIN_INPUT | PLUGIN_INPUT_MRL_PREFIXES, 18, "tls",  XINE_VERSION_CODE, &input_net_info, input_tls_init_class },
+  { PLUGIN_INPUT | PLUGIN_INPUT_MRL_PREFIXES, 18, "gopher", XINE_VERSION_CODE, &input_net_info, input_gopher_init_class },
   { PLUGIN_INPUT | PLUGIN_MUST_PRELOAD, 18, "http", XINE_VERSION_CODE, NULL, input_http_init_class },
-  { PLUGIN_INPUT,                       18, "rtsp", XINE_VERSION_CODE, NULL, input_rtsp_init_class },
-  { PLUGIN_INPUT,                       18, "pnm",  XINE_VERSION_CODE, NULL, input_pnm_init_class },
-  { PLUGIN_INPUT,                       18, "ftp",  XINE_VERSION_CODE, NULL, input_ftp_init_class },
-  { PLUGIN_INPUT,                       18, "ftpes", XINE_VERSION_CODE, NULL, input_ftpes_init_class },
+  { PLUGIN_INPUT | PLUGIN_INPUT_MRL_PREFIXES, 18, "rtsp", XINE_VERSION_CODE, &input_rtsp_info, input_rtsp_init_class },
+  { PLUGIN_INPUT | PLUGIN_INPUT_MRL_PREFIXES, 18, "pnm",  XINE_VERSION_CODE, &input_pnm_info, input_pnm_init_class },
+  { PLUGIN_INPUT | PLUGIN_INPUT_MRL_PREFIXES, 18, "ftp",  XINE_VERSION_CODE, &input_ftp_info, input_ftp_init_class },
+  { PLUGIN_INPUT | PLUGIN_INPUT_MRL_PREFIXES, 18, "ftpes", XINE_VERSION_CODE, &input_ftp_info, input_ftpes_init_class },
   { PLUGIN_INPUT | PLUGIN_MUST_PRELOAD, 18, "hls",  XINE_VERSION_CODE, &input_hls_info, input_hls_init_class },
   { PLUGIN_INPUT,                       18, "mpegdash", XINE_VERSION_CODE, &input_hls_info, input_mpegdash_init_class },
   { PLUGIN_NONE, 0, NULL, 0, NULL, NULL }
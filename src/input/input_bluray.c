@@ -2033,9 +2033,14 @@ static void *bd_init_plugin (xine_t *xine, const void *data)
  * exported plugin catalog entry
  */
 
+static const input_info_t input_info_bluray = {
+  .priority = 0,
+  .mrl_prefixes = "bluray: bd:"
+};
+
 const plugin_info_t xine_plugin_info[] EXPORTED = {
   /* type, API, "name", version, special_info, init_function */
-  { PLUGIN_INPUT, 18, "BLURAY", XINE_VERSION_CODE, NULL, bluray_init_plugin },
-  { PLUGIN_INPUT, 18, "BD",     XINE_VERSION_CODE, NULL, bd_init_plugin },
+  { PLUGIN_INPUT | PLUGIN_INPUT_MRL_PREFIXES, 18, "BLURAY", XINE_VERSION_CODE, &input_info_bluray, bluray_init_plugin },
+  { PLUGIN_INPUT | PLUGIN_INPUT_MRL_PREFIXES, 18, "BD",     XINE_VERSION_CODE, &input_info_bluray, bd_init_plugin },
   { PLUGIN_NONE, 0, NULL, 0, NULL, NULL }
 };
@@ -2914,8 +2914,13 @@ static void *init_plugin (xine_t *xine, const void *data) {
   return this;
 }
 
+static const input_info_t input_info_cdda = {
+  .priority = 0,
+  .mrl_prefixes = "cdda:/"
+};
+
 const plugin_info_t xine_plugin_info[] EXPORTED = {
   /* type, API, "name", version, special_info, init_function */
-  { PLUGIN_INPUT | PLUGIN_MUST_PRELOAD, 18, "CD", XINE_VERSION_CODE, NULL, init_plugin },
+  { PLUGIN_INPUT | PLUGIN_MUST_PRELOAD | PLUGIN_INPUT_MRL_PREFIXES, 18, "CD", XINE_VERSION_CODE, &input_info_cdda, init_plugin },
   { PLUGIN_NONE, 0, NULL, 0, NULL, NULL }
 };
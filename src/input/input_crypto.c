@@ -457,8 +457,13 @@ static void *input_crypto_init_class (xine_t *xine, const void *data)
  * exported plugin catalog entry
  */
 
+static const input_info_t input_info_crypto = {
+  .priority = 0,
+  .mrl_prefixes = "crypto:"
+};
+
 const plugin_info_t xine_plugin_info[] EXPORTED = {
   /* type, API, "name", version, special_info, init_function */
-  { PLUGIN_INPUT, 18, "crypto", XINE_VERSION_CODE, NULL, input_crypto_init_class },
+  { PLUGIN_INPUT | PLUGIN_INPUT_MRL_PREFIXES, 18, "crypto", XINE_VERSION_CODE, &input_info_crypto, input_crypto_init_class },
   { PLUGIN_NONE, 0, NULL, 0, NULL, NULL }
 };
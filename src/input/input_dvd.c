@@ -1961,9 +1961,14 @@ static void *init_class (xine_t *xine, const void *data) {
 }
 
 
+static const input_info_t input_info_dvd = {
+  .priority = 0,
+  .mrl_prefixes = "dvd:/"
+};
+
 const plugin_info_t xine_plugin_info[] EXPORTED = {
   /* type, API, "name", version, special_info, init_function */
-  { PLUGIN_INPUT | PLUGIN_MUST_PRELOAD, 18, "DVD", XINE_VERSION_CODE, NULL, init_class },
+  { PLUGIN_INPUT | PLUGIN_MUST_PRELOAD | PLUGIN_INPUT_MRL_PREFIXES, 18, "DVD", XINE_VERSION_CODE, &input_info_dvd, init_class },
   { PLUGIN_NONE, 0, NULL, 0, NULL, NULL }
 };
 
@@ -588,10 +588,11 @@ static void *nfs_init_class(xine_t *xine, const void *data)
 
 static const input_info_t input_info_nfs = {
   .priority = 10,
+  .mrl_prefixes = "nfs://"
 };
 
 const plugin_info_t xine_plugin_info[] EXPORTED = {
   /* type, API, "name", version, special_info, init_function */
-  { PLUGIN_INPUT, 18, "NFS", XINE_VERSION_CODE, &input_info_nfs, nfs_init_class },
+  { PLUGIN_INPUT | PLUGIN_INPUT_MRL_PREFIXES, 18, "NFS", XINE_VERSION_CODE, &input_info_nfs, nfs_init_class },
   { PLUGIN_NONE, 0, NULL, 0, NULL, NULL }
 };
@@ -1597,9 +1597,14 @@ static void *init_plugin (xine_t *xine, const void *data) {
  * exported plugin catalog entry
  */
 
+static const input_info_t input_info_pvr = {
+  .priority = 0,
+  .mrl_prefixes = "pvr:/"
+};
+
 const plugin_info_t xine_plugin_info[] EXPORTED = {
   /* type, API, "name", version, special_info, init_function */
-  { PLUGIN_INPUT | PLUGIN_MUST_PRELOAD, 18, "pvr", XINE_VERSION_CODE, NULL, init_plugin },
+  { PLUGIN_INPUT | PLUGIN_MUST_PRELOAD | PLUGIN_INPUT_MRL_PREFIXES, 18, "pvr", XINE_VERSION_CODE, &input_info_pvr, init_plugin },
   { PLUGIN_NONE, 0, NULL, 0, NULL, NULL }
 };
 
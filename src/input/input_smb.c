@@ -547,10 +547,11 @@ static void
 
 static const input_info_t input_info_smb = {
   .priority = 0,
+  .mrl_prefixes = "smb://"
 };
 
 const plugin_info_t xine_plugin_info[] EXPORTED = {
-	{ PLUGIN_INPUT, 18, "smb", XINE_VERSION_CODE, &input_info_smb,
+	{ PLUGIN_INPUT | PLUGIN_INPUT_MRL_PREFIXES, 18, "smb", XINE_VERSION_CODE, &input_info_smb,
 		init_input_class },
 	{ PLUGIN_NONE, 0, NULL, 0, NULL, NULL }
 };
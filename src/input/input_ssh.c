@@ -921,15 +921,17 @@ static void *sftp_init_class(xine_t *xine, const void *data)
 
 const input_info_t input_info_sftp = {
   .priority = 100,
+  .mrl_prefixes = "sftp:// scp://"
 };
 
 const input_info_t input_info_scp = {
   .priority = 100,
+  .mrl_prefixes = "sftp:// scp://"
 };
 
 const plugin_info_t xine_plugin_info[] EXPORTED = {
   /* type, API, "name", version, special_info, init_function */
-  { PLUGIN_INPUT, 18, "SFTP", XINE_VERSION_CODE, &input_info_sftp, sftp_init_class },
-  { PLUGIN_INPUT, 18, "SCP",  XINE_VERSION_CODE, &input_info_scp,  scp_init_class },
+  { PLUGIN_INPUT | PLUGIN_INPUT_MRL_PREFIXES, 18, "SFTP", XINE_VERSION_CODE, &input_info_sftp, sftp_init_class },
+  { PLUGIN_INPUT | PLUGIN_INPUT_MRL_PREFIXES, 18, "SCP",  XINE_VERSION_CODE, &input_info_scp,  scp_init_class },
   { PLUGIN_NONE, 0, NULL, 0, NULL, NULL }
 };
@@ -505,7 +505,12 @@ static void *stdin_plugin_init_class (xine_t *xine, const void *data) {
  * exported plugin catalog entry
  */
 
-#define INPUT_STDIN_CATALOG { PLUGIN_INPUT, 18, "stdin", XINE_VERSION_CODE, NULL, stdin_plugin_init_class }
+static const input_info_t input_info_stdin = {
+  .priority = 0,
+  .mrl_prefixes = "stdin:/ - fd://0 fifo:/"
+};
+
+#define INPUT_STDIN_CATALOG { PLUGIN_INPUT | PLUGIN_INPUT_MRL_PREFIXES, 18, "stdin", XINE_VERSION_CODE, &input_info_stdin, stdin_plugin_init_class }
 
 #ifndef XINE_MAKE_BUILTINS
 const plugin_info_t xine_plugin_info[] EXPORTED = {
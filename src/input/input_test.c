@@ -737,14 +737,15 @@ static void *test_init_plugin (xine_t *xine, const void *data) {
 }
 
 static const input_info_t input_info_test = {
-  .priority = 110
+  .priority = 110,
+  .mrl_prefixes = "test://"
 };
 
 /*
  * exported plugin catalog entry
  */
 
-#define INPUT_TEST_CATALOG  { PLUGIN_INPUT | PLUGIN_MUST_PRELOAD, 18, "TEST", XINE_VERSION_CODE, &input_info_test, test_init_plugin }
+#define INPUT_TEST_CATALOG  { PLUGIN_INPUT | PLUGIN_MUST_PRELOAD | PLUGIN_INPUT_MRL_PREFIXES, 18, "TEST", XINE_VERSION_CODE, &input_info_test, test_init_plugin }
 
 #ifndef XINE_MAKE_BUILTINS
 const plugin_info_t xine_plugin_info[] EXPORTED = {
@@ -1972,10 +1972,15 @@ static void *init_radio_class (xine_t *xine, const void *data)
  * exported plugin catalog entry
  */
 
+static const input_info_t input_info_v4l = {
+  .priority = 0,
+  .mrl_prefixes = "v4l:/"
+};
+
 const plugin_info_t xine_plugin_info[] EXPORTED = {
   /* type, API, "name", version, special_info, init_function */
-  { PLUGIN_INPUT | PLUGIN_MUST_PRELOAD, 18, "v4l_radio", XINE_VERSION_CODE, NULL, init_radio_class },
-  { PLUGIN_INPUT | PLUGIN_MUST_PRELOAD, 18, "v4l_tv", XINE_VERSION_CODE, NULL, init_video_class },
+  { PLUGIN_INPUT | PLUGIN_MUST_PRELOAD | PLUGIN_INPUT_MRL_PREFIXES, 18, "v4l_radio", XINE_VERSION_CODE, &input_info_v4l, init_radio_class },
+  { PLUGIN_INPUT | PLUGIN_MUST_PRELOAD | PLUGIN_INPUT_MRL_PREFIXES, 18, "v4l_tv", XINE_VERSION_CODE, &input_info_v4l, init_video_class },
   { PLUGIN_NONE, 0, NULL, 0, NULL, NULL }
 };
 
@@ -455,11 +455,12 @@ static void *v4l2_init_class(xine_t *xine, const void *data) {
 }
 
 const input_info_t input_info_v4l2 = {
-    4000
+    .priority = 4000,
+    .mrl_prefixes = "v4l2:/"
 };
 
 const plugin_info_t xine_plugin_info[] EXPORTED = {
     /* type, API, "name", version, special_info, init_function */
-    { PLUGIN_INPUT, 18, "v4l2", XINE_VERSION_CODE, &input_info_v4l2, v4l2_init_class },
+    { PLUGIN_INPUT | PLUGIN_INPUT_MRL_PREFIXES, 18, "v4l2", XINE_VERSION_CODE, &input_info_v4l2, v4l2_init_class },
     { PLUGIN_NONE, 0, NULL, 0, NULL, NULL }
 };
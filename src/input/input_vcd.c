@@ -1096,8 +1096,13 @@ static void *init_class (xine_t *xine, const void *data) {
  * exported plugin catalog entry
  */
 
+static const input_info_t input_info_vcdo = {
+  .priority = 0,
+  .mrl_prefixes = "vcdo:/"
+};
+
 const plugin_info_t xine_plugin_info[] EXPORTED = {
   /* type, API, "name", version, special_info, init_function */
-  { PLUGIN_INPUT | PLUGIN_MUST_PRELOAD, 18, "VCDO", XINE_VERSION_CODE, NULL, init_class },
+  { PLUGIN_INPUT | PLUGIN_MUST_PRELOAD | PLUGIN_INPUT_MRL_PREFIXES, 18, "VCDO", XINE_VERSION_CODE, &input_info_vcdo, init_class },
   { PLUGIN_NONE, 0, NULL, 0, NULL, NULL }
 };
@@ -2088,10 +2088,15 @@ _("For tracking down bugs in the VCD plugin. Mask values are:\n"
    the next API number since in both cases the plugin is broken.
  */
 
+static const input_info_t input_info_vcd = {
+  .priority = 0,
+  .mrl_prefixes = MRL_PREFIX
+};
+
 const plugin_info_t xine_plugin_info[] EXPORTED = {
   /* type, API, "name", version, special_info, init_function */
-  { PLUGIN_INPUT | PLUGIN_MUST_PRELOAD, 18, SHORT_PLUGIN_NAME,
-    XINE_VERSION_CODE, NULL, vcd_init },
+  { PLUGIN_INPUT | PLUGIN_MUST_PRELOAD | PLUGIN_INPUT_MRL_PREFIXES, 18, SHORT_PLUGIN_NAME,
+    XINE_VERSION_CODE, &input_info_vcd, vcd_init },
   { PLUGIN_NONE, 0, NULL, 0, NULL, NULL }
 };
 
@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2024 the xine project
+ *
+ * This file is part of xine, a free video player.
+ *
+ * xine is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ *
+ * deinterlace self test: the sse2 and avx2 versions of greedyh and
+ * tomsmocomp must give bit exact the same output as the mmxext ones.
+ * the plugin sources are built into this program with xine_mm_accel ()
+ * renamed to deinterlace_check_accel (), so we can force each path.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <xine/xineutils.h>
+#include "deinterlace.h"
+#include "plugins.h"
+
+/* the real one, see Makefile.am. */
+#undef xine_mm_accel
+uint32_t xine_mm_accel (void);
+
+#define ACCEL_MMXEXT (MM_ACCEL_X86_MMX | MM_ACCEL_X86_MMXEXT)
+#define ACCEL_SSE2   (ACCEL_MMXEXT | MM_ACCEL_X86_SSE | MM_ACCEL_X86_SSE2)
+#define ACCEL_AVX2   (ACCEL_SSE2 | MM_ACCEL_X86_AVX | MM_ACCEL_X86_AVX2)
+
+static uint32_t accel_mask = 0;
+
+uint32_t deinterlace_check_accel (void) {
+  return xine_mm_accel () & accel_mask;
+}
+
+typedef struct {
+  const char *name;
+  uint32_t    mask;
+} check_path_t;
+
+static const check_path_t paths[] = {
+  { "mmxext", ACCEL_MMXEXT },
+  { "sse2",   ACCEL_SSE2 },
+  { "avx2",   ACCEL_AVX2 }
+};
+
+/* all widths the sse2/avx2 code takes, plus odd ones falling back. */
+static const int sizes[][2] = {
+  {  32,   16}, {  36,   20}, {  40,   24}, {  48,   18}, { 360,  288},
+  { 704,  576}, { 720,  480}, { 720,  576}, { 724,  576}, {1280,  720},
+  {1440, 1080}, {1920, 1080}
+};
+
+/* some smooth motion for the search code, plus random noise blocks. */
+static void check_fill (uint8_t *p, int stride, int height, int field) {
+  int x, y;
+
+  for (y = 0; y < height; y++) {
+    for (x = 0; x < stride; x++) {
+      int v = ((x + field * 6 * ((y >> 4) & 1)) * 3 + y * 5) & 255;
+      if (((x >> 5) + (y >> 5) + field) % 3 == 0)
+        v = rand () & 255;
+      p[y * stride + x] = v;
+    }
+  }
+}
+
+static int check_method (const deinterlace_method_t *method, int npaths) {
+  int fails = 0;
+  unsigned int s;
+
+  for (s = 0; s < sizeof (sizes) / sizeof (sizes[0]); s++) {
+    int width = sizes[s][0], height = sizes[s][1], stride = width * 2;
+    size_t size = (size_t)stride * height;
+    uint8_t *fields[3], *out[3];
+    int i, bottom, second;
+
+    for (i = 0; i < 3; i++) {
+      /* the asm may read a little past the last line. */
+      fields[i] = xine_malloc_aligned (size + 64);
+      out[i] = xine_malloc_aligned (size);
+      if (!fields[i] || !out[i]) {
+        fprintf (stderr, "deinterlace_check: out of memory\n");
+        exit (1);
+      }
+      check_fill (fields[i], stride, height, i);
+    }
+
+    for (bottom = 0; bottom < 2; bottom++) {
+      for (second = 0; second < 2; second++) {
+        deinterlace_frame_data_t data = { fields[0], fields[1], fields[2], NULL };
+
+        for (i = 0; i < npaths; i++) {
+          accel_mask = paths[i].mask;
+          memset (out[i], i * 77 + 1, size);
+          method->deinterlace_frame (out[i], stride, &data, bottom, second, width, height);
+          if (i && memcmp (out[0], out[i], size)) {
+            size_t n = 0;
+            while (out[0][n] == out[i][n])
+              n++;
+            printf ("FAIL: %s %s %dx%d bottom %d second %d: line %d byte %d (%d != %d)\n",
+              method->short_name, paths[i].name, width, height, bottom, second,
+              (int)(n / stride), (int)(n % stride), out[i][n], out[0][n]);
+            fails++;
+          }
+        }
+      }
+    }
+
+    for (i = 0; i < 3; i++) {
+      xine_free_aligned (fields[i]);
+      xine_free_aligned (out[i]);
+    }
+  }
+  return fails;
+}
+
+int main (void) {
+  uint32_t accel = xine_mm_accel ();
+  int npaths, fails;
+
+  if ((accel & ACCEL_SSE2) != ACCEL_SSE2) {
+    printf ("SKIP: no sse2\n");
+    return 77;
+  }
+  npaths = 2;
+#ifdef HAVE_AVX2
+  if ((accel & ACCEL_AVX2) == ACCEL_AVX2)
+    npaths = 3;
+#endif
+
+  /* tomsmocomp copies the first lines with this. */
+  if (!xine_fast_memcpy)
+    xine_fast_memcpy = memcpy;
+
+  srand (1);
+  fails  = check_method (dscaler_greedyh_get_method (), npaths);
+  fails += check_method (dscaler_tomsmocomp_get_method (), npaths);
+
+  printf ("%s: greedyh, tomsmocomp: mmxext vs sse2%s\n", fails ? "FAIL" : "PASS", npaths > 2 ? ", avx2" : "");
+  return fails ? 1 : 0;
+}
@@ -26,11 +26,6 @@ static const int64_t __attribute__((__used__)) UVMask       = 0xff00ff00ff00ff00
 static const int64_t __attribute__((__used__)) ShiftMask    = 0xfefffefffefffeffull; // to avoid shifting chroma to luma
 static const int64_t __attribute__((__used__)) QW256        = 0x0100010001000100ull; // 4 256's
 
-static int64_t MaxComb;
-static int64_t MotionThreshold;
-static int64_t MotionSense;
-static int64_t QW256B;
-
 #endif
 
 static void FUNCT_NAME(uint8_t *output, int outstride,
@@ -56,6 +51,12 @@ static void FUNCT_NAME(uint8_t *output, int outstride,
 
     int64_t LastAvg=0;			//interp value from left qword
 
+    // per call, as bands of a frame may run in parallel
+    int64_t MaxComb;
+    int64_t MotionThreshold;
+    int64_t MotionSense;
+    int64_t QW256B;
+
     // Set up our two parms that are actually evaluated for each pixel
     i=GreedyMaxComb;
     MaxComb = i << 56 | i << 48 | i << 40 | i << 32 | i << 24 | i << 16 | i << 8 | i;
@@ -0,0 +1,258 @@
+// -*- c++ -*-
+/////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2001 Tom Barry.  All rights reserved.
+/////////////////////////////////////////////////////////////////////////////
+//
+//	This file is subject to the terms of the GNU General Public License as
+//	published by the Free Software Foundation.  A copy of this license is
+//	included with this software distribution in the file COPYING.  If you
+//	do not have a copy, you may obtain a copy by writing to the Free
+//	Software Foundation, 51 Franklin St, Fifth Floor, Boston, MA 
+//  02110-1301, USA.
+//
+//	This software is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//	GNU General Public License for more details
+//
+/////////////////////////////////////////////////////////////////////////////
+
+// SSE2 and AVX2 versions of greedyh.asm, x86-64 only. They do 16 or 32 bytes
+// a time, and give exactly the same results as the MMXEXT one.
+//
+// BEFORE INCLUDING THIS, SET:
+// #define FUNCT_NAME greedyh_filter_sse2   (or ..._avx2 along with IS_AVX2)
+//
+// The line length (width * 2) must be a multiple of the block size.
+
+#define GH_CAT2(a,b) a##b
+#define GH_CAT(a,b)  GH_CAT2(a,b)
+#define GH_BLOCK_FUN GH_CAT(FUNCT_NAME,_block)
+
+#ifdef IS_AVX2
+#define GH_BLOCK   32
+#define GH_R(n)    "%%ymm" #n
+#define GH_OP(op,a,b)  "v" #op " " a ", " b ", " b "\n\t"
+#define GH_MOV(a,b)    "vmovdqa " a ", " b "\n\t"
+#define GH_LOAD(m,r)   "vmovdqu " m ", " r "\n\t"
+#define GH_STORE(r,m)  "vmovdqu " r ", " m "\n\t"
+// the left and right neighbour pixels cross the 128bit lanes.
+#define GH_NEIGHBOURS \
+    "vmovdqu    192(%[c]), %%ymm4\n\t"            /* the bob value from prev block in row */ \
+    "vmovdqu    %%ymm6, 192(%[c])\n\t"            /* save for next pass */ \
+    "vperm2i128 $0x21, %%ymm6, %%ymm4, %%ymm4\n\t" \
+    "vpalignr   $14, %%ymm4, %%ymm6, %%ymm4\n\t"  /* left neighbours */ \
+    "vmovd      (%[n]), %%xmm5\n\t"               /* next pixel from L1 */ \
+    "vmovd      (%[n],%[p]), %%xmm7\n\t"          /* next pixel from L3 */ \
+    "vpavgb     %%ymm7, %%ymm5, %%ymm5\n\t" \
+    "vperm2i128 $0x21, %%ymm5, %%ymm6, %%ymm5\n\t" \
+    "vpalignr   $2, %%ymm6, %%ymm5, %%ymm5\n\t"   /* right neighbours */
+#else
+#define GH_BLOCK   16
+#define GH_R(n)    "%%xmm" #n
+#define GH_OP(op,a,b)  #op " " a ", " b "\n\t"
+#define GH_MOV(a,b)    "movdqa " a ", " b "\n\t"
+#define GH_LOAD(m,r)   "movdqu " m ", " r "\n\t"
+#define GH_STORE(r,m)  "movdqu " r ", " m "\n\t"
+#define GH_NEIGHBOURS \
+    "movdqa     192(%[c]), %%xmm4\n\t"            /* the bob value from prev block in row */ \
+    "movdqa     %%xmm6, 192(%[c])\n\t"            /* save for next pass */ \
+    "psrldq     $14, %%xmm4\n\t"                  /* right justify 1 pixel */ \
+    "movdqa     %%xmm6, %%xmm7\n\t" \
+    "pslldq     $2, %%xmm7\n\t"                   /* left justify 7 pixels */ \
+    "por        %%xmm7, %%xmm4\n\t"               /* left neighbours */ \
+    "movd       (%[n]), %%xmm5\n\t"               /* next pixel from L1 */ \
+    "movd       (%[n],%[p]), %%xmm7\n\t"          /* next pixel from L3 */ \
+    "pavgb      %%xmm7, %%xmm5\n\t" \
+    "pslldq     $14, %%xmm5\n\t"                  /* left justify 1 pixel */ \
+    "movdqa     %%xmm6, %%xmm7\n\t" \
+    "psrldq     $2, %%xmm7\n\t"                   /* right justify 7 pixels */ \
+    "por        %%xmm7, %%xmm5\n\t"               /* right neighbours */
+#endif
+
+// c: MaxComb, MotionThreshold, MotionSense, QW256, YMask, UVMask, LastAvg.
+// n: the next pixel, or the first one of the last 8 bytes at the line end
+// as with the MMX version.
+static void GH_BLOCK_FUN (uint8_t *d, const uint8_t *l1, const uint8_t *n, const uint8_t *l2,
+                          const uint8_t *l2p, long p, uint64_t *c)
+{
+    __asm__ __volatile__ (
+        GH_LOAD ("(%[l2])", GH_R(0))               // L2 - the newest weave pixel value
+        GH_LOAD ("(%[l1])", GH_R(1))               // L1 - the top pixel
+        GH_LOAD ("(%[l2p])", GH_R(2))              // L2P - the prev weave pixel
+        GH_LOAD ("(%[l1],%[p])", GH_R(3))          // L3, next odd row
+        GH_MOV  (GH_R(1), GH_R(6))
+        GH_OP   (pavgb, GH_R(3), GH_R(6))          // simple bob
+
+        // DJR - Diagonal Jaggie Reduction
+        GH_NEIGHBOURS
+        GH_OP   (pavgb, GH_R(5), GH_R(4))          // avg of forward and prev by 1 pixel
+        GH_OP   (pavgb, GH_R(4), GH_R(6))          // avg of center and surround interp vals
+        GH_OP   (pavgb, GH_R(6), GH_R(4))          // 1/4 center, 3/4 adjacent
+        GH_OP   (pavgb, GH_R(4), GH_R(6))          // 3/8 center, 5/8 adjacent
+
+        // get abs value of possible L2 comb
+        GH_MOV  (GH_R(6), GH_R(4))
+        GH_MOV  (GH_R(2), GH_R(7))
+        GH_OP   (psubusb, GH_R(4), GH_R(7))
+        GH_MOV  (GH_R(4), GH_R(5))
+        GH_OP   (psubusb, GH_R(2), GH_R(5))
+        GH_OP   (por, GH_R(7), GH_R(5))
+
+        // get abs value of possible L2P comb
+        GH_MOV  (GH_R(0), GH_R(7))
+        GH_OP   (psubusb, GH_R(4), GH_R(7))
+        GH_OP   (psubusb, GH_R(0), GH_R(4))
+        GH_OP   (por, GH_R(7), GH_R(4))
+
+        // use L2 or L2P depending upon which makes smaller comb
+        GH_OP   (psubusb, GH_R(5), GH_R(4))
+        GH_OP   (psubusb, GH_R(5), GH_R(5))
+        GH_OP   (pcmpeqb, GH_R(5), GH_R(4))
+        GH_OP   (pcmpeqb, GH_R(4), GH_R(5))
+        GH_OP   (pand, GH_R(2), GH_R(5))
+        GH_OP   (pand, GH_R(0), GH_R(4))
+        GH_OP   (por, GH_R(5), GH_R(4))
+
+        // measure movement
+        GH_MOV  (GH_R(2), GH_R(7))
+        GH_OP   (psubusb, GH_R(0), GH_R(2))
+        GH_OP   (psubusb, GH_R(7), GH_R(0))
+        GH_OP   (por, GH_R(2), GH_R(0))
+
+        // clip to the L1-L3 range, widened by MaxComb
+        GH_MOV  (GH_R(1), GH_R(2))
+        GH_OP   (pmaxub, GH_R(3), GH_R(2))
+        GH_MOV  (GH_R(1), GH_R(5))
+        GH_OP   (pminub, GH_R(3), GH_R(5))
+        GH_OP   (psubusb, "(%[c])", GH_R(5))
+        GH_OP   (paddusb, "(%[c])", GH_R(2))
+        GH_OP   (pmaxub, GH_R(5), GH_R(4))
+        GH_OP   (pminub, GH_R(2), GH_R(4))
+
+        // blend weave pixel with bob pixel, depending on motion
+        GH_OP   (psubusb, "32(%[c])", GH_R(0))
+        GH_OP   (pmullw, "64(%[c])", GH_R(0))
+        GH_LOAD ("96(%[c])", GH_R(7))
+        GH_OP   (pminsw, GH_R(7), GH_R(0))         // max = 256
+        GH_OP   (psubusw, GH_R(0), GH_R(7))        // so the 2 sum to 256
+        GH_MOV  (GH_R(4), GH_R(2))
+        GH_OP   (pand, "128(%[c])", GH_R(4))
+        GH_OP   (pmullw, GH_R(7), GH_R(4))
+        GH_OP   (pand, "128(%[c])", GH_R(6))
+        GH_OP   (pmullw, GH_R(0), GH_R(6))
+        GH_OP   (paddusw, GH_R(6), GH_R(4))
+        GH_OP   (psrlw, "$8", GH_R(4))
+
+        // chroma comes from weave pixel
+        GH_OP   (pand, "160(%[c])", GH_R(2))
+        GH_OP   (por, GH_R(4), GH_R(2))
+        GH_STORE (GH_R(2), "(%[d])")
+        :
+        : [d] "r" (d), [l1] "r" (l1), [n] "r" (n), [l2] "r" (l2), [l2p] "r" (l2p), [p] "r" (p), [c] "r" (c)
+        : "xmm0", "xmm1", "xmm2", "xmm3", "xmm4", "xmm5", "xmm6", "xmm7", "memory");
+}
+
+static void FUNCT_NAME(uint8_t *output, int outstride,
+                  deinterlace_frame_data_t *data,
+                  int bottom_field, int second_field, int width, int height )
+{
+    uint64_t c[7 * 4] ATTR_ALIGN(32);
+    uint64_t i;
+    int stride = (width*2);
+    int InfoIsOdd = bottom_field;
+
+    int Line, x;
+    long Pitch = stride*2;
+    int FieldHeight = height / 2;
+
+    unsigned char* L1;					// ptr to Line1, of 3
+    unsigned char* L2;					// ptr to Line2, the weave line
+    unsigned char* L3;					// ptr to Line3
+
+    unsigned char* L2P;					// ptr to prev Line2
+    unsigned char* Dest = output;
+
+    // Set up our parms that are actually evaluated for each pixel
+    for (x = 0; x < 4; x++) {
+        i = GreedyMaxComb;
+        c[x] = i << 56 | i << 48 | i << 40 | i << 32 | i << 24 | i << 16 | i << 8 | i;
+        i = GreedyMotionThreshold;
+        c[4 + x] = i << 48 | i << 32 | i << 16 | i | 0xff00ff00ff00ff00ull;
+        i = GreedyMotionSense;
+        c[8 + x] = i << 48 | i << 32 | i << 16 | i;
+        c[12 + x] = 0x0100010001000100ull;
+        c[16 + x] = 0x00ff00ff00ff00ffull;
+        c[20 + x] = 0xff00ff00ff00ff00ull;
+        c[24 + x] = 0;
+    }
+
+    // copy first even line no matter what, and the first odd line if we're
+    // processing an EVEN field. (note diff from other deint rtns.)
+    if( second_field ) {
+        L1 = data->f0;
+        L2 = data->f0;
+        L2P = data->f1;
+    } else {
+        L1 = data->f1;
+        L2 = data->f0;
+        L2P = data->f1;
+    }
+
+    if( InfoIsOdd ) {
+        L2 += stride;
+        L3 = L1 + Pitch;
+        L2P += stride;
+
+        // copy first even line
+        xine_fast_memcpy(Dest, L1, stride);
+        Dest += outstride;
+    } else {
+        // copy first even line
+        xine_fast_memcpy(Dest, L2, stride);
+        Dest += outstride;
+
+        L1 += stride;
+        L2 += Pitch;
+        L3 = L1 + Pitch;
+        L2P += Pitch;
+
+        // then first odd line
+        xine_fast_memcpy(Dest, L1, stride);
+        Dest += outstride;
+    }
+
+    for (Line = 0; Line < (FieldHeight - 1); ++Line) {
+        for (x = 0; x < stride - GH_BLOCK; x += GH_BLOCK)
+            GH_BLOCK_FUN (Dest + x, L1 + x, L1 + x + GH_BLOCK, L2 + x, L2P + x, Pitch, c);
+        GH_BLOCK_FUN (Dest + x, L1 + x, L1 + x + GH_BLOCK - 8, L2 + x, L2P + x, Pitch, c);
+
+        Dest += outstride;
+        xine_fast_memcpy(Dest, L3, stride);
+        Dest += outstride;
+
+        L1  += Pitch;
+        L2  += Pitch;
+        L3  += Pitch;
+        L2P += Pitch;
+    }
+
+    if (InfoIsOdd) {
+        xine_fast_memcpy(Dest, L2, stride);
+    }
+
+#ifdef IS_AVX2
+    __asm__ __volatile__ ("vzeroupper");
+#endif
+}
+
+#undef GH_CAT2
+#undef GH_CAT
+#undef GH_BLOCK_FUN
+#undef GH_BLOCK
+#undef GH_R
+#undef GH_OP
+#undef GH_MOV
+#undef GH_LOAD
+#undef GH_STORE
+#undef GH_NEIGHBOURS
@@ -75,6 +75,20 @@ static unsigned int GreedyMotionSense = MOTIONSENSE_DEFAULT;
 #undef IS_MMX
 #undef FUNCT_NAME
 
+#if defined(ARCH_X86_64) && !defined(_MSC_VER)
+#define FUNCT_NAME greedyh_filter_sse2
+#include "greedyh_sse2.asm"
+#undef FUNCT_NAME
+
+#ifdef HAVE_AVX2
+#define IS_AVX2
+#define FUNCT_NAME greedyh_filter_avx2
+#include "greedyh_sse2.asm"
+#undef FUNCT_NAME
+#undef IS_AVX2
+#endif
+#endif
+
 #endif
 
 static void deinterlace_frame_di_greedyh( uint8_t *output, int outstride,
@@ -83,6 +97,22 @@ static void deinterlace_frame_di_greedyh( uint8_t *output, int outstride,
                                           int width, int height )
 {
 #if defined (ARCH_X86)
+#if defined(ARCH_X86_64) && !defined(_MSC_VER)
+# ifdef HAVE_AVX2
+    if( (xine_mm_accel() & MM_ACCEL_X86_AVX2) && !(width & 15) ) {
+        greedyh_filter_avx2( output, outstride, data,
+                             bottom_field, second_field,
+                             width, height );
+        return;
+    }
+# endif
+    if( (xine_mm_accel() & MM_ACCEL_X86_SSE2) && !(width & 7) ) {
+        greedyh_filter_sse2( output, outstride, data,
+                             bottom_field, second_field,
+                             width, height );
+        return;
+    }
+#endif
     if( xine_mm_accel() & MM_ACCEL_X86_MMXEXT ) {
         greedyh_filter_sse( output, outstride, data,
                             bottom_field, second_field,
@@ -90,6 +90,20 @@ static int UseStrangeBob=UseStrangeBobDefault;
 #undef  SSE_TYPE
 #undef  FUNCT_NAME
 
+#if defined(ARCH_X86_64) && !defined(_MSC_VER)
+#define FUNCT_NAME tomsmocomp_filter_sse2
+#include "tomsmocomp/TomsMoCompSSE2.inc"
+#undef  FUNCT_NAME
+
+#ifdef HAVE_AVX2
+#define IS_AVX2
+#define FUNCT_NAME tomsmocomp_filter_avx2
+#include "tomsmocomp/TomsMoCompSSE2.inc"
+#undef  FUNCT_NAME
+#undef  IS_AVX2
+#endif
+#endif
+
 #endif
 
 static void deinterlace_frame_di_tomsmocomp( uint8_t *output, int outstride,
@@ -99,6 +113,26 @@ static void deinterlace_frame_di_tomsmocomp( uint8_t *output, int outstride,
 {
 #if defined (ARCH_X86)
 
+#if defined(ARCH_X86_64) && !defined(_MSC_VER)
+    if( !UseStrangeBob && (SearchEffort > 3) && (SearchEffort <= 5)
+        && !(width & 3) && (width >= 32) ) {
+# ifdef HAVE_AVX2
+        if( xine_mm_accel() & MM_ACCEL_X86_AVX2 ) {
+            tomsmocomp_filter_avx2( output, outstride, data,
+                                    bottom_field, second_field,
+                                    width, height );
+            return;
+        }
+# endif
+        if( xine_mm_accel() & MM_ACCEL_X86_SSE2 ) {
+            tomsmocomp_filter_sse2( output, outstride, data,
+                                    bottom_field, second_field,
+                                    width, height );
+            return;
+        }
+    }
+#endif
+
     if( xine_mm_accel() & MM_ACCEL_X86_MMXEXT ) {
         tomsmocomp_filter_sse( output, outstride, data,
                                bottom_field, second_field,
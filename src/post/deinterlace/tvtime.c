@@ -32,6 +32,8 @@
 #include <stdint.h>
 #endif
 
+#include <xine/xineutils.h>
+
 #include "speedy.h"
 #include "deinterlace.h"
 #include "pulldown.h"
@@ -149,6 +151,139 @@ static void calculate_pulldown_score_vektor( tvtime_t *tvtime,
 }
 
 
+/**
+ * The middle scanlines of a field. Each pass only reads the input frames
+ * and writes its own 2 output lines, so any part of this may run on its own.
+ */
+static void tvtime_scanline_loop( const deinterlace_method_t *method,
+                                  uint8_t *output,
+                                  uint8_t *curframe,
+                                  uint8_t *lastframe,
+                                  uint8_t *f3, uint8_t *f4,
+                                  int bottom_field, int width,
+                                  int loop_size, int bytes_left,
+                                  int instride, int outstride )
+{
+    while (loop_size-- > 0) {
+        deinterlace_scanline_data_t data;
+
+        data.bottom_field = bottom_field;
+        data.bytes_left = bytes_left;
+        data.t0  = curframe;
+        data.b0  = curframe + instride * 2;
+        data.tt1 = f3 - instride;
+        data.m1  = f3 + instride;
+        data.bb1 = f3 + instride * 3;
+        data.t2  = lastframe;
+        data.b2  = lastframe + instride * 2;
+        data.tt3 = f4 - instride;
+        data.m3  = f4 + instride;
+        data.bb3 = f4 + instride * 3;
+        method->interpolate_scanline (output, &data, width);
+        output += outstride;
+
+        data.tt0 = curframe;
+        data.m0  = curframe + instride * 2;
+        data.bb0 = curframe + instride * 4;
+        data.t1  = f3 + instride;
+        data.b1  = f3 + instride * 3;
+        data.tt2 = lastframe;
+        data.t2  = f4 + instride;
+        data.m2  = lastframe + instride * 2;
+        data.b2  = f4 + instride * 3;
+        data.bb2 = lastframe + instride * 4;
+        method->copy_scanline (output, &data, width);
+        curframe += instride * 2;
+        lastframe += instride * 2;
+        f3 += instride * 2;
+        f4 += instride * 2;
+        bytes_left -= instride * 2;
+        output += outstride;
+    }
+}
+
+/**
+ * Big frames are split into row bands that run on the shared slice helpers.
+ * A band shall be at least this many bytes of output.
+ */
+#define TVTIME_BAND_SIZE (1 << 18)
+#define TVTIME_MAX_BANDS 8
+
+/**
+ * Frame methods handle the first and last lines of whatever they get in a
+ * special way, and look 1 field line up and down elsewhere. Thus, a band is
+ * rendered to a scratch buffer with this many extra rows of context on
+ * either side, and only its own rows are copied to the output.
+ */
+#define TVTIME_BAND_MARGIN 8
+
+typedef struct {
+    const deinterlace_method_t *method;
+    uint8_t *output;
+    uint8_t *curframe, *lastframe, *secondlastframe;
+    uint8_t *f3, *f4;
+    uint8_t *buf;
+    int bottom_field, second_field;
+    int width, frame_height;
+    int loop_size, bytes_left;
+    int instride, outstride, bufstride;
+} tvtime_bands_t;
+
+static int tvtime_num_bands( int width, int frame_height )
+{
+    int n, max;
+
+    n = width * 2 * frame_height / TVTIME_BAND_SIZE;
+    if( n > frame_height / 32 ) n = frame_height / 32;
+    if( n > TVTIME_MAX_BANDS ) n = TVTIME_MAX_BANDS;
+    if( n < 2 ) return 1;
+    max = xine_slices_max();
+    return n < max ? n : max;
+}
+
+static void tvtime_scanline_band( void *data, int slice, int num_slices )
+{
+    tvtime_bands_t *b = (tvtime_bands_t *)data;
+    int first = b->loop_size * slice / num_slices;
+    int last = b->loop_size * (slice + 1) / num_slices;
+    int skip = first * b->instride * 2;
+
+    tvtime_scanline_loop( b->method, b->output + first * 2 * b->outstride,
+                          b->curframe + skip, b->lastframe + skip,
+                          b->f3 + skip, b->f4 + skip,
+                          b->bottom_field, b->width,
+                          last - first, b->bytes_left - skip,
+                          b->instride, b->outstride );
+}
+
+static void tvtime_frame_band( void *data, int slice, int num_slices )
+{
+    tvtime_bands_t *b = (tvtime_bands_t *)data;
+    deinterlace_frame_data_t fd;
+    /* frame methods assume unpadded input. */
+    int stride = b->width * 2;
+    int y0 = (b->frame_height * slice / num_slices) & ~7;
+    int y1 = (slice + 1 < num_slices) ? (b->frame_height * (slice + 1) / num_slices) & ~7 : b->frame_height;
+    int top = slice ? y0 - TVTIME_BAND_MARGIN : 0;
+    int bot = (slice + 1 < num_slices) ? y1 + TVTIME_BAND_MARGIN : b->frame_height;
+    uint8_t *buf = b->buf + (top + 2 * TVTIME_BAND_MARGIN * slice) * b->bufstride;
+    uint8_t *out = b->output + y0 * b->outstride;
+
+    fd.f0 = b->curframe + top * stride;
+    fd.f1 = b->lastframe + top * stride;
+    fd.f2 = b->secondlastframe + top * stride;
+    fd.f3 = NULL;
+    b->method->deinterlace_frame( buf, b->bufstride, &fd, b->bottom_field, b->second_field,
+                                  b->width, bot - top );
+
+    buf += (y0 - top) * b->bufstride;
+    for( ; y0 < y1; y0++ ) {
+        xine_fast_memcpy( out, buf, stride );
+        out += b->outstride;
+        buf += b->bufstride;
+    }
+}
+
 int tvtime_build_deinterlaced_frame( tvtime_t *tvtime, uint8_t *output,
                                              uint8_t *curframe,
                                              uint8_t *lastframe,
@@ -244,17 +379,47 @@ int tvtime_build_deinterlaced_frame( tvtime_t *tvtime, uint8_t *output,
     }
 
     if( !tvtime->curmethod->scanlinemode ) {
-        deinterlace_frame_data_t data;
+        int n = tvtime_num_bands( width, frame_height );
+        int bufstride = (width * 2 + 31) & ~31;
+        size_t bufsize = (size_t)(frame_height + 2 * TVTIME_BAND_MARGIN * n) * bufstride;
+
+        if( (n > 1) && (bufsize > tvtime->band_buf_size) ) {
+            xine_free_aligned( tvtime->band_buf );
+            tvtime->band_buf = xine_malloc_aligned( bufsize );
+            tvtime->band_buf_size = tvtime->band_buf ? bufsize : 0;
+            if( !tvtime->band_buf )
+                n = 1;
+        }
 
-        data.f0 = curframe;
-        data.f1 = lastframe;
-        data.f2 = secondlastframe;
+        if( n > 1 ) {
+            tvtime_bands_t bands;
+
+            bands.method = tvtime->curmethod;
+            bands.output = output;
+            bands.curframe = curframe;
+            bands.lastframe = lastframe;
+            bands.secondlastframe = secondlastframe;
+            bands.buf = tvtime->band_buf;
+            bands.bottom_field = bottom_field;
+            bands.second_field = second_field;
+            bands.width = width;
+            bands.frame_height = frame_height;
+            bands.outstride = outstride;
+            bands.bufstride = bufstride;
+            xine_slices_run( tvtime_frame_band, &bands, n );
+        } else {
+            deinterlace_frame_data_t data;
+
+            data.f0 = curframe;
+            data.f1 = lastframe;
+            data.f2 = secondlastframe;
 
-        tvtime->curmethod->deinterlace_frame( output, outstride, &data, bottom_field, second_field,
-                                      width, frame_height );
+            tvtime->curmethod->deinterlace_frame( output, outstride, &data, bottom_field, second_field,
+                                          width, frame_height );
+        }
 
     } else {
-        int loop_size, bytes_left;
+        int loop_size, bytes_left, n;
         uint8_t *f3, *f4;
 
         if (frame_height < 8) {
@@ -329,42 +494,34 @@ int tvtime_build_deinterlaced_frame( tvtime_t *tvtime, uint8_t *output,
                 output += outstride;
             }
 
-            while (loop_size-- > 0) {
-                deinterlace_scanline_data_t data;
-
-                data.bottom_field = bottom_field;
-                data.bytes_left = bytes_left;
-                data.t0  = curframe;
-                data.b0  = curframe + instride * 2;
-                data.tt1 = f3 - instride;
-                data.m1  = f3 + instride;
-                data.bb1 = f3 + instride * 3;
-                data.t2  = lastframe;
-                data.b2  = lastframe + instride * 2;
-                data.tt3 = f4 - instride;
-                data.m3  = f4 + instride;
-                data.bb3 = f4 + instride * 3;
-                tvtime->curmethod->interpolate_scanline (output, &data, width);
-                output += outstride;
-
-                data.tt0 = curframe;
-                data.m0  = curframe + instride * 2;
-                data.bb0 = curframe + instride * 4;
-                data.t1  = f3 + instride;
-                data.b1  = f3 + instride * 3;
-                data.tt2 = lastframe;
-                data.t2  = f4 + instride;
-                data.m2  = lastframe + instride * 2;
-                data.b2  = f4 + instride * 3;
-                data.bb2 = lastframe + instride * 4;
-                tvtime->curmethod->copy_scanline (output, &data, width);
-                curframe += instride * 2;
-                lastframe += instride * 2;
-                f3 += instride * 2;
-                f4 += instride * 2;
-                bytes_left -= instride * 2;
-                output += outstride;
+            n = tvtime_num_bands( width, frame_height );
+            if( n > 1 ) {
+                tvtime_bands_t bands;
+
+                bands.method = tvtime->curmethod;
+                bands.output = output;
+                bands.curframe = curframe;
+                bands.lastframe = lastframe;
+                bands.f3 = f3;
+                bands.f4 = f4;
+                bands.bottom_field = bottom_field;
+                bands.width = width;
+                bands.loop_size = loop_size;
+                bands.bytes_left = bytes_left;
+                bands.instride = instride;
+                bands.outstride = outstride;
+                xine_slices_run( tvtime_scanline_band, &bands, n );
+            } else {
+                tvtime_scanline_loop( tvtime->curmethod, output, curframe, lastframe, f3, f4,
+                                      bottom_field, width, loop_size, bytes_left,
+                                      instride, outstride );
             }
+            curframe += loop_size * instride * 2;
+            lastframe += loop_size * instride * 2;
+            f3 += loop_size * instride * 2;
+            f4 += loop_size * instride * 2;
+            bytes_left -= loop_size * instride * 2;
+            output += loop_size * 2 * outstride;
 
             {
                 deinterlace_scanline_data_t data;
@@ -470,11 +627,22 @@ tvtime_t *tvtime_new_context(void)
 
   tvtime->curmethod = NULL;
 
+  tvtime->band_buf = NULL;
+  tvtime->band_buf_size = 0;
+
   tvtime_reset_context(tvtime);
 
   return tvtime;
 }
 
+void tvtime_delete_context( tvtime_t *tvtime )
+{
+  if (!tvtime)
+    return;
+  xine_free_aligned(tvtime->band_buf);
+  free(tvtime);
+}
+
 void tvtime_reset_context( tvtime_t *tvtime )
 {
   tvtime->last_topdiff = 0;
@@ -24,6 +24,7 @@
 #else
 #include <stdint.h>
 #endif
+#include <stddef.h>
 
 #include "deinterlace.h"
 
@@ -71,6 +72,9 @@ typedef struct {
   int pdlastbusted;
   int filmmode;
 
+  /* scratch for frame methods running in bands. */
+  uint8_t *band_buf;
+  size_t band_buf_size;
 
 } tvtime_t;
 
@@ -95,6 +99,8 @@ int tvtime_build_copied_field( tvtime_t *this, uint8_t *output,
                                        int outstride );
 tvtime_t *tvtime_new_context(void);
 
+void tvtime_delete_context( tvtime_t *tvtime );
+
 void tvtime_reset_context( tvtime_t *this );
 
 
@@ -448,7 +448,7 @@ static void deinterlace_dispose(post_plugin_t *this_gen)
   if (_x_post_dispose(this_gen)) {
     _flush_frames(this);
     pthread_mutex_destroy(&this->lock);
-    free(this->tvtime);
+    tvtime_delete_context(this->tvtime);
     free(this);
   }
 }
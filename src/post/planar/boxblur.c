@@ -68,6 +68,10 @@ struct post_plugin_boxblur_s {
   /* private data */
   boxblur_parameters_t params;
 
+  /* column passes: running sums for a row, and 2 planes. */
+  uint8_t             *temp;
+  size_t               temp_size;
+
   pthread_mutex_t      lock;
 };
 
@@ -75,11 +79,16 @@ struct post_plugin_boxblur_s {
 static int set_parameters (xine_post_t *this_gen, const void *param_gen) {
   post_plugin_boxblur_t *this = (post_plugin_boxblur_t *)this_gen;
   const boxblur_parameters_t *param = (const boxblur_parameters_t *)param_gen;
+  post_video_port_t *port = (post_video_port_t *)this->post.xine_post.video_input[0];
 
   pthread_mutex_lock (&this->lock);
 
   memcpy( &this->params, param, sizeof(boxblur_parameters_t) );
 
+  /* a radius of 0 leaves frames alone, let them bypass us. */
+  if (port)
+    port->bypass = !param->luma_radius && (!param->chroma_radius || (param->chroma_radius == -1));
+
   pthread_mutex_unlock (&this->lock);
 
   return 1;
@@ -116,6 +125,7 @@ static void boxblur_dispose(post_plugin_t *this_gen)
 
   if (_x_post_dispose(this_gen)) {
     pthread_mutex_destroy(&this->lock);
+    free(this->temp);
     free(this);
   }
 }
@@ -182,21 +192,494 @@ static inline void blur2(uint8_t *dst, uint8_t *src, int w, int radius, int powe
 	}
 }
 
+/*
+ * Planes of at least 2 * radius + 1 pixels take faster ways to the same
+ * results as blur (). Rows are blurred as differences of prefix sums.
+ * Columns keep running sums for a whole row of them, instead of walking
+ * down one column at a time. Both are O(1) per pixel, whatever the radius.
+ * The sums are 16 bit. Prefix sums may wrap, their differences do not.
+ */
+typedef struct {
+  /* p[i + 1] = p[i] + s[i]. */
+  void (*prefix) (uint16_t *p, const uint8_t *s, int n);
+  /* dst[i] = ((hi[i] - lo[i]) * inv + (1 << 15)) >> 16. */
+  void (*diff)   (uint8_t *dst, const uint16_t *hi, const uint16_t *lo, int n, int inv);
+  /* sums[i] += add[i] - sub[i], dst[i] = (sums[i] * inv + (1 << 15)) >> 16. */
+  void (*vrow)   (uint8_t *dst, uint16_t *sums, const uint8_t *add, const uint8_t *sub, int n, int inv);
+} box_funcs_t;
+
+static void box_prefix_c (uint16_t *p, const uint8_t *s, int n) {
+  uint16_t v = p[0];
+  int i;
+
+  for (i = 0; i < n; i++)
+    p[i + 1] = v = v + s[i];
+}
+
+static void box_diff_c (uint8_t *dst, const uint16_t *hi, const uint16_t *lo, int n, int inv) {
+  int i;
+
+  for (i = 0; i < n; i++)
+    dst[i] = ((uint16_t)(hi[i] - lo[i]) * inv + (1 << 15)) >> 16;
+}
+
+static void box_vrow_c (uint8_t *dst, uint16_t *sums, const uint8_t *add, const uint8_t *sub, int n, int inv) {
+  int i;
+
+  for (i = 0; i < n; i++) {
+    sums[i] += add[i] - sub[i];
+    dst[i] = (sums[i] * inv + (1 << 15)) >> 16;
+  }
+}
+
+#if defined(ARCH_X86) && !defined(_MSC_VER)
+/* (sum * inv + (1 << 15)) >> 16 = high word + top bit of low word. */
+static void box_prefix_sse2 (uint16_t *p, const uint8_t *s, int n) {
+  intptr_t k = n & ~15;
+  int start = p[0];
+
+  if (k) {
+    uint16_t *q = p + 1;
+    __asm__ __volatile__ (
+      "movd\t%3, %%xmm6\n\t"
+      "pshuflw\t$0, %%xmm6, %%xmm6\n\t"
+      "punpcklqdq\t%%xmm6, %%xmm6\n\t"
+      "pxor\t%%xmm7, %%xmm7\n"
+      "1:\n\t"
+      "movdqu\t(%1), %%xmm0\n\t"
+      "movdqa\t%%xmm0, %%xmm1\n\t"
+      "punpcklbw\t%%xmm7, %%xmm0\n\t"
+      "punpckhbw\t%%xmm7, %%xmm1\n\t"
+      "movdqa\t%%xmm0, %%xmm2\n\t"
+      "movdqa\t%%xmm1, %%xmm3\n\t"
+      "pslldq\t$2, %%xmm2\n\t"
+      "pslldq\t$2, %%xmm3\n\t"
+      "paddw\t%%xmm2, %%xmm0\n\t"
+      "paddw\t%%xmm3, %%xmm1\n\t"
+      "movdqa\t%%xmm0, %%xmm2\n\t"
+      "movdqa\t%%xmm1, %%xmm3\n\t"
+      "pslldq\t$4, %%xmm2\n\t"
+      "pslldq\t$4, %%xmm3\n\t"
+      "paddw\t%%xmm2, %%xmm0\n\t"
+      "paddw\t%%xmm3, %%xmm1\n\t"
+      "movdqa\t%%xmm0, %%xmm2\n\t"
+      "movdqa\t%%xmm1, %%xmm3\n\t"
+      "pslldq\t$8, %%xmm2\n\t"
+      "pslldq\t$8, %%xmm3\n\t"
+      "paddw\t%%xmm2, %%xmm0\n\t"
+      "paddw\t%%xmm3, %%xmm1\n\t"
+      "paddw\t%%xmm6, %%xmm0\n\t"
+      "pshufhw\t$0xff, %%xmm0, %%xmm6\n\t"
+      "punpckhqdq\t%%xmm6, %%xmm6\n\t"
+      "paddw\t%%xmm6, %%xmm1\n\t"
+      "pshufhw\t$0xff, %%xmm1, %%xmm6\n\t"
+      "punpckhqdq\t%%xmm6, %%xmm6\n\t"
+      "movdqu\t%%xmm0, (%0)\n\t"
+      "movdqu\t%%xmm1, 16(%0)\n\t"
+      "add\t$16, %1\n\t"
+      "add\t$32, %0\n\t"
+      "sub\t$16, %2\n\t"
+      "jnz\t1b"
+      : "+r" (q), "+r" (s), "+r" (k)
+      : "m" (start)
+      : "xmm0", "xmm1", "xmm2", "xmm3", "xmm6", "xmm7", "cc", "memory");
+  }
+  box_prefix_c (p + (n & ~15), s, n & 15);
+}
+
+static void box_diff_sse2 (uint8_t *dst, const uint16_t *hi, const uint16_t *lo, int n, int inv) {
+  intptr_t k = n & ~15;
+
+  if (k) {
+    __asm__ __volatile__ (
+      "movd\t%4, %%xmm5\n\t"
+      "pshuflw\t$0, %%xmm5, %%xmm5\n\t"
+      "punpcklqdq\t%%xmm5, %%xmm5\n"
+      "1:\n\t"
+      "movdqu\t(%1), %%xmm0\n\t"
+      "movdqu\t16(%1), %%xmm1\n\t"
+      "movdqu\t(%2), %%xmm2\n\t"
+      "movdqu\t16(%2), %%xmm3\n\t"
+      "psubw\t%%xmm2, %%xmm0\n\t"
+      "psubw\t%%xmm3, %%xmm1\n\t"
+      "movdqa\t%%xmm0, %%xmm2\n\t"
+      "movdqa\t%%xmm1, %%xmm3\n\t"
+      "pmullw\t%%xmm5, %%xmm2\n\t"
+      "pmullw\t%%xmm5, %%xmm3\n\t"
+      "pmulhuw\t%%xmm5, %%xmm0\n\t"
+      "pmulhuw\t%%xmm5, %%xmm1\n\t"
+      "psrlw\t$15, %%xmm2\n\t"
+      "psrlw\t$15, %%xmm3\n\t"
+      "paddw\t%%xmm2, %%xmm0\n\t"
+      "paddw\t%%xmm3, %%xmm1\n\t"
+      "packuswb\t%%xmm1, %%xmm0\n\t"
+      "movdqu\t%%xmm0, (%0)\n\t"
+      "add\t$32, %1\n\t"
+      "add\t$32, %2\n\t"
+      "add\t$16, %0\n\t"
+      "sub\t$16, %3\n\t"
+      "jnz\t1b"
+      : "+r" (dst), "+r" (hi), "+r" (lo), "+r" (k)
+      : "m" (inv)
+      : "xmm0", "xmm1", "xmm2", "xmm3", "xmm5", "cc", "memory");
+  }
+  box_diff_c (dst, hi, lo, n & 15, inv);
+}
+
+static void box_vrow_sse2 (uint8_t *dst, uint16_t *sums, const uint8_t *add, const uint8_t *sub, int n, int inv) {
+  intptr_t k = n & ~15;
+
+  if (k) {
+    __asm__ __volatile__ (
+      "movd\t%5, %%xmm5\n\t"
+      "pshuflw\t$0, %%xmm5, %%xmm5\n\t"
+      "punpcklqdq\t%%xmm5, %%xmm5\n\t"
+      "pxor\t%%xmm7, %%xmm7\n"
+      "1:\n\t"
+      "movdqu\t(%2), %%xmm0\n\t"
+      "movdqu\t(%3), %%xmm2\n\t"
+      "movdqa\t%%xmm0, %%xmm1\n\t"
+      "movdqa\t%%xmm2, %%xmm3\n\t"
+      "punpcklbw\t%%xmm7, %%xmm0\n\t"
+      "punpckhbw\t%%xmm7, %%xmm1\n\t"
+      "punpcklbw\t%%xmm7, %%xmm2\n\t"
+      "punpckhbw\t%%xmm7, %%xmm3\n\t"
+      "psubw\t%%xmm2, %%xmm0\n\t"
+      "psubw\t%%xmm3, %%xmm1\n\t"
+      "movdqu\t(%1), %%xmm2\n\t"
+      "movdqu\t16(%1), %%xmm3\n\t"
+      "paddw\t%%xmm2, %%xmm0\n\t"
+      "paddw\t%%xmm3, %%xmm1\n\t"
+      "movdqu\t%%xmm0, (%1)\n\t"
+      "movdqu\t%%xmm1, 16(%1)\n\t"
+      "movdqa\t%%xmm0, %%xmm2\n\t"
+      "movdqa\t%%xmm1, %%xmm3\n\t"
+      "pmullw\t%%xmm5, %%xmm2\n\t"
+      "pmullw\t%%xmm5, %%xmm3\n\t"
+      "pmulhuw\t%%xmm5, %%xmm0\n\t"
+      "pmulhuw\t%%xmm5, %%xmm1\n\t"
+      "psrlw\t$15, %%xmm2\n\t"
+      "psrlw\t$15, %%xmm3\n\t"
+      "paddw\t%%xmm2, %%xmm0\n\t"
+      "paddw\t%%xmm3, %%xmm1\n\t"
+      "packuswb\t%%xmm1, %%xmm0\n\t"
+      "movdqu\t%%xmm0, (%0)\n\t"
+      "add\t$16, %2\n\t"
+      "add\t$16, %3\n\t"
+      "add\t$32, %1\n\t"
+      "add\t$16, %0\n\t"
+      "sub\t$16, %4\n\t"
+      "jnz\t1b"
+      : "+r" (dst), "+r" (sums), "+r" (add), "+r" (sub), "+r" (k)
+      : "m" (inv)
+      : "xmm0", "xmm1", "xmm2", "xmm3", "xmm5", "xmm7", "cc", "memory");
+  }
+  box_vrow_c (dst, sums, add, sub, n & 15, inv);
+}
+
+#ifdef HAVE_AVX2
+/* vpslldq, vpshufhw and vpackuswb work inside 128 bit lanes,
+ * thus the vperm*. */
+static void box_prefix_avx2 (uint16_t *p, const uint8_t *s, int n) {
+  intptr_t k = n & ~31;
+  int start = p[0];
+
+  if (k) {
+    uint16_t *q = p + 1;
+    __asm__ __volatile__ (
+      "vpbroadcastw\t%3, %%ymm6\n"
+      "1:\n\t"
+      "vpmovzxbw\t(%1), %%ymm0\n\t"
+      "vpmovzxbw\t16(%1), %%ymm1\n\t"
+      "vpslldq\t$2, %%ymm0, %%ymm2\n\t"
+      "vpslldq\t$2, %%ymm1, %%ymm3\n\t"
+      "vpaddw\t%%ymm2, %%ymm0, %%ymm0\n\t"
+      "vpaddw\t%%ymm3, %%ymm1, %%ymm1\n\t"
+      "vpslldq\t$4, %%ymm0, %%ymm2\n\t"
+      "vpslldq\t$4, %%ymm1, %%ymm3\n\t"
+      "vpaddw\t%%ymm2, %%ymm0, %%ymm0\n\t"
+      "vpaddw\t%%ymm3, %%ymm1, %%ymm1\n\t"
+      "vpslldq\t$8, %%ymm0, %%ymm2\n\t"
+      "vpslldq\t$8, %%ymm1, %%ymm3\n\t"
+      "vpaddw\t%%ymm2, %%ymm0, %%ymm0\n\t"
+      "vpaddw\t%%ymm3, %%ymm1, %%ymm1\n\t"
+      "vpshufhw\t$0xff, %%ymm0, %%ymm2\n\t"
+      "vpshufhw\t$0xff, %%ymm1, %%ymm3\n\t"
+      "vpunpckhqdq\t%%ymm2, %%ymm2, %%ymm2\n\t"
+      "vpunpckhqdq\t%%ymm3, %%ymm3, %%ymm3\n\t"
+      "vperm2i128\t$0x08, %%ymm2, %%ymm2, %%ymm2\n\t"
+      "vperm2i128\t$0x08, %%ymm3, %%ymm3, %%ymm3\n\t"
+      "vpaddw\t%%ymm2, %%ymm0, %%ymm0\n\t"
+      "vpaddw\t%%ymm3, %%ymm1, %%ymm1\n\t"
+      "vpaddw\t%%ymm6, %%ymm0, %%ymm0\n\t"
+      "vpshufhw\t$0xff, %%ymm0, %%ymm6\n\t"
+      "vpunpckhqdq\t%%ymm6, %%ymm6, %%ymm6\n\t"
+      "vpermq\t$0xff, %%ymm6, %%ymm6\n\t"
+      "vpaddw\t%%ymm6, %%ymm1, %%ymm1\n\t"
+      "vpshufhw\t$0xff, %%ymm1, %%ymm6\n\t"
+      "vpunpckhqdq\t%%ymm6, %%ymm6, %%ymm6\n\t"
+      "vpermq\t$0xff, %%ymm6, %%ymm6\n\t"
+      "vmovdqu\t%%ymm0, (%0)\n\t"
+      "vmovdqu\t%%ymm1, 32(%0)\n\t"
+      "add\t$32, %1\n\t"
+      "add\t$64, %0\n\t"
+      "sub\t$32, %2\n\t"
+      "jnz\t1b\n\t"
+      "vzeroupper"
+      : "+r" (q), "+r" (s), "+r" (k)
+      : "m" (start)
+      : "xmm0", "xmm1", "xmm2", "xmm3", "xmm6", "cc", "memory");
+  }
+  box_prefix_c (p + (n & ~31), s, n & 31);
+}
+
+static void box_diff_avx2 (uint8_t *dst, const uint16_t *hi, const uint16_t *lo, int n, int inv) {
+  intptr_t k = n & ~31;
+
+  if (k) {
+    __asm__ __volatile__ (
+      "vpbroadcastw\t%4, %%ymm5\n"
+      "1:\n\t"
+      "vmovdqu\t(%1), %%ymm0\n\t"
+      "vmovdqu\t32(%1), %%ymm1\n\t"
+      "vpsubw\t(%2), %%ymm0, %%ymm0\n\t"
+      "vpsubw\t32(%2), %%ymm1, %%ymm1\n\t"
+      "vpmullw\t%%ymm5, %%ymm0, %%ymm2\n\t"
+      "vpmullw\t%%ymm5, %%ymm1, %%ymm3\n\t"
+      "vpmulhuw\t%%ymm5, %%ymm0, %%ymm0\n\t"
+      "vpmulhuw\t%%ymm5, %%ymm1, %%ymm1\n\t"
+      "vpsrlw\t$15, %%ymm2, %%ymm2\n\t"
+      "vpsrlw\t$15, %%ymm3, %%ymm3\n\t"
+      "vpaddw\t%%ymm2, %%ymm0, %%ymm0\n\t"
+      "vpaddw\t%%ymm3, %%ymm1, %%ymm1\n\t"
+      "vpackuswb\t%%ymm1, %%ymm0, %%ymm0\n\t"
+      "vpermq\t$0xd8, %%ymm0, %%ymm0\n\t"
+      "vmovdqu\t%%ymm0, (%0)\n\t"
+      "add\t$64, %1\n\t"
+      "add\t$64, %2\n\t"
+      "add\t$32, %0\n\t"
+      "sub\t$32, %3\n\t"
+      "jnz\t1b\n\t"
+      "vzeroupper"
+      : "+r" (dst), "+r" (hi), "+r" (lo), "+r" (k)
+      : "m" (inv)
+      : "xmm0", "xmm1", "xmm2", "xmm3", "xmm5", "cc", "memory");
+  }
+  box_diff_c (dst, hi, lo, n & 31, inv);
+}
+
+static void box_vrow_avx2 (uint8_t *dst, uint16_t *sums, const uint8_t *add, const uint8_t *sub, int n, int inv) {
+  intptr_t k = n & ~31;
+
+  if (k) {
+    __asm__ __volatile__ (
+      "vpbroadcastw\t%5, %%ymm5\n"
+      "1:\n\t"
+      "vpmovzxbw\t(%2), %%ymm0\n\t"
+      "vpmovzxbw\t16(%2), %%ymm1\n\t"
+      "vpmovzxbw\t(%3), %%ymm2\n\t"
+      "vpmovzxbw\t16(%3), %%ymm3\n\t"
+      "vpsubw\t%%ymm2, %%ymm0, %%ymm0\n\t"
+      "vpsubw\t%%ymm3, %%ymm1, %%ymm1\n\t"
+      "vpaddw\t(%1), %%ymm0, %%ymm0\n\t"
+      "vpaddw\t32(%1), %%ymm1, %%ymm1\n\t"
+      "vmovdqu\t%%ymm0, (%1)\n\t"
+      "vmovdqu\t%%ymm1, 32(%1)\n\t"
+      "vpmullw\t%%ymm5, %%ymm0, %%ymm2\n\t"
+      "vpmullw\t%%ymm5, %%ymm1, %%ymm3\n\t"
+      "vpmulhuw\t%%ymm5, %%ymm0, %%ymm0\n\t"
+      "vpmulhuw\t%%ymm5, %%ymm1, %%ymm1\n\t"
+      "vpsrlw\t$15, %%ymm2, %%ymm2\n\t"
+      "vpsrlw\t$15, %%ymm3, %%ymm3\n\t"
+      "vpaddw\t%%ymm2, %%ymm0, %%ymm0\n\t"
+      "vpaddw\t%%ymm3, %%ymm1, %%ymm1\n\t"
+      "vpackuswb\t%%ymm1, %%ymm0, %%ymm0\n\t"
+      "vpermq\t$0xd8, %%ymm0, %%ymm0\n\t"
+      "vmovdqu\t%%ymm0, (%0)\n\t"
+      "add\t$32, %2\n\t"
+      "add\t$32, %3\n\t"
+      "add\t$64, %1\n\t"
+      "add\t$32, %0\n\t"
+      "sub\t$32, %4\n\t"
+      "jnz\t1b\n\t"
+      "vzeroupper"
+      : "+r" (dst), "+r" (sums), "+r" (add), "+r" (sub), "+r" (k)
+      : "m" (inv)
+      : "xmm0", "xmm1", "xmm2", "xmm3", "xmm5", "cc", "memory");
+  }
+  box_vrow_c (dst, sums, add, sub, n & 31, inv);
+}
+#endif /* HAVE_AVX2 */
+#endif /* ARCH_X86 */
+
+static box_funcs_t box_funcs = {
+  box_prefix_c, box_diff_c, box_vrow_c
+};
+
+static pthread_once_t box_funcs_once = PTHREAD_ONCE_INIT;
+
+static void box_funcs_init (void) {
+#if defined(ARCH_X86) && !defined(_MSC_VER)
+  uint32_t caps = xine_mm_accel ();
+
+# ifdef HAVE_AVX2
+  if (caps & MM_ACCEL_X86_AVX2) {
+    box_funcs.prefix = box_prefix_avx2;
+    box_funcs.diff   = box_diff_avx2;
+    box_funcs.vrow   = box_vrow_avx2;
+    return;
+  }
+# endif
+  if (caps & MM_ACCEL_X86_SSE2) {
+    box_funcs.prefix = box_prefix_sse2;
+    box_funcs.diff   = box_diff_sse2;
+    box_funcs.vrow   = box_vrow_sse2;
+  }
+#endif
+}
+
+typedef struct {
+  uint8_t  *dst, *src;
+  int       w, h, dstStride, srcStride, radius, power;
+  /* column passes. */
+  uint16_t *sums;
+  uint8_t  *temp[2];
+} box_plane_t;
+
+/* one pass over a row, like blur (). ext and p have room for
+ * w + 2 * radius and w + 2 * radius + 1 entries. */
+static void box_row (uint8_t *dst, const uint8_t *src, int w, int radius, uint8_t *ext, uint16_t *p) {
+  int inv = ((1 << 16) + radius) / (radius * 2 + 1);
+  int i;
+
+  /* mirror the edges, like the 2 end loops of blur (). */
+  for (i = 0; i < radius; i++) {
+    ext[radius - 1 - i] = src[i];
+    ext[radius + w + i] = src[w - 1 - i];
+  }
+  memcpy (ext + radius, src, w);
+  p[0] = 0;
+  box_funcs.prefix (p, ext, w + 2 * radius);
+  box_funcs.diff (dst, p + 2 * radius + 1, p, w, inv);
+}
+
+static void box_hblur_band (void *data, int band, int y0, int y1) {
+  box_plane_t *b = (box_plane_t *)data;
+  int w = b->w, radius = b->radius, n = w + 2 * radius + 1;
+  uint8_t *temp, *ext;
+  uint16_t *p;
+  int y;
+
+  (void)band;
+  p = malloc (n * sizeof (*p) + 3 * n);
+  if (!p) {
+    for (y = y0; y < y1; y++)
+      blur2 (b->dst + y * b->dstStride, b->src + y * b->srcStride, w, radius, b->power, 1, 1);
+    return;
+  }
+  temp = (uint8_t *)(p + n);
+  ext = temp + 2 * n;
+
+  for (y = y0; y < y1; y++) {
+    uint8_t *dst = b->dst + y * b->dstStride, *a = temp, *c = temp + n;
+    int power = b->power;
+
+    box_row (a, b->src + y * b->srcStride, w, radius, ext, p);
+    for (; power > 2; power--) {
+      uint8_t *t;
+      box_row (c, a, w, radius, ext, p);
+      t = a; a = c; c = t;
+    }
+    if (power > 1)
+      box_row (dst, a, w, radius, ext, p);
+    else
+      memcpy (dst, a, w);
+  }
+  free (p);
+}
+
+/* one pass over columns [x0, x0 + n), like blur (). */
+static void box_columns (uint8_t *dst, int dstStride, const uint8_t *src, int srcStride,
+  int n, int h, int radius, uint16_t *sums) {
+  int inv = ((1 << 16) + radius) / (radius * 2 + 1);
+  int x, y;
+
+  for (x = 0; x < n; x++)
+    sums[x] = src[radius * srcStride + x];
+  for (y = 0; y < radius; y++)
+    for (x = 0; x < n; x++)
+      sums[x] += src[y * srcStride + x] << 1;
+
+  for (y = 0; y < h; y++) {
+    int add = y + radius, sub = y - radius - 1;
+
+    if (add >= h)
+      add = 2 * h - 1 - add;
+    if (sub < 0)
+      sub = -sub - 1;
+    box_funcs.vrow (dst + y * dstStride, sums, src + add * srcStride, src + sub * srcStride, n, inv);
+  }
+}
+
+static void box_vblur_band (void *data, int band, int x0, int x1) {
+  box_plane_t *b = (box_plane_t *)data;
+  uint8_t *a = b->temp[0] + x0, *c = b->temp[1] + x0;
+  int power = b->power, n = x1 - x0, y;
+
+  (void)band;
+  box_columns (a, b->w, b->src + x0, b->srcStride, n, b->h, b->radius, b->sums + x0);
+  for (; power > 2; power--) {
+    uint8_t *t;
+    box_columns (c, b->w, a, b->w, n, b->h, b->radius, b->sums + x0);
+    t = a; a = c; c = t;
+  }
+  if (power > 1) {
+    box_columns (b->dst + x0, b->dstStride, a, b->w, n, b->h, b->radius, b->sums + x0);
+  } else {
+    for (y = 0; y < b->h; y++)
+      memcpy (b->dst + y * b->dstStride + x0, a + y * b->w, n);
+  }
+}
+
 static void hBlur(uint8_t *dst, uint8_t *src, int w, int h, int dstStride, int srcStride, int radius, int power){
 	int y;
 
 	if(radius==0 && dst==src) return;
 
+	if(radius && w >= 2*radius + 1){
+		box_plane_t b = {
+			.dst = dst, .src = src, .w = w, .h = h,
+			.dstStride = dstStride, .srcStride = srcStride,
+			.radius = radius, .power = power
+		};
+		planar_run_bands(box_hblur_band, &b, h, 1, planar_num_bands(w, h));
+		return;
+	}
+
 	for(y=0; y<h; y++){
 		blur2(dst + y*dstStride, src + y*srcStride, w, radius, power, 1, 1);
 	}
 }
 
-static void vBlur(uint8_t *dst, uint8_t *src, int w, int h, int dstStride, int srcStride, int radius, int power){
+static void vBlur(uint8_t *dst, uint8_t *src, int w, int h, int dstStride, int srcStride, int radius, int power,
+                  uint8_t *temp){
 	int x;
 
 	if(radius==0 && dst==src) return;
 
+	if(radius && h >= 2*radius + 1 && temp){
+		box_plane_t b = {
+			.dst = dst, .src = src, .w = w, .h = h,
+			.dstStride = dstStride, .srcStride = srcStride,
+			.radius = radius, .power = power,
+			.sums = (uint16_t *)temp,
+			.temp = { temp + 2 * w, temp + 2 * w + w * h }
+		};
+		/* whole cache lines per band. */
+		planar_run_bands(box_vblur_band, &b, w, 64, planar_num_bands(w, h));
+		return;
+	}
+
 	for(x=0; x<w; x++){
 		blur2(dst + x, src + x, h, radius, power, dstStride, srcStride);
 	}
@@ -250,6 +733,17 @@ static int boxblur_draw(vo_frame_t *frame, xine_stream_t *stream)
     cw = yv12_frame->width/2;
     ch = yv12_frame->height/2;
 
+    pthread_once (&box_funcs_once, box_funcs_init);
+    {
+      /* 16 bit sums and 2 planes, enough for luma. */
+      size_t need = 2 * (size_t)yv12_frame->width * yv12_frame->height + 2 * (size_t)yv12_frame->width;
+      if (this->temp_size < need) {
+        free (this->temp);
+        this->temp = malloc (need);
+        this->temp_size = this->temp ? need : 0;
+      }
+    }
+
     hBlur(out_frame->base[0], yv12_frame->base[0], yv12_frame->width, yv12_frame->height,
           out_frame->pitches[0], yv12_frame->pitches[0], this->params.luma_radius, this->params.luma_power);
     hBlur(out_frame->base[1], yv12_frame->base[1], cw,ch,
@@ -258,11 +752,11 @@ static int boxblur_draw(vo_frame_t *frame, xine_stream_t *stream)
           out_frame->pitches[2], yv12_frame->pitches[2], chroma_radius, chroma_power);
 
     vBlur(out_frame->base[0], out_frame->base[0], yv12_frame->width, yv12_frame->height,
-          out_frame->pitches[0], out_frame->pitches[0], this->params.luma_radius, this->params.luma_power);
+          out_frame->pitches[0], out_frame->pitches[0], this->params.luma_radius, this->params.luma_power, this->temp);
     vBlur(out_frame->base[1], out_frame->base[1], cw,ch,
-          out_frame->pitches[1], out_frame->pitches[1], chroma_radius, chroma_power);
+          out_frame->pitches[1], out_frame->pitches[1], chroma_radius, chroma_power, this->temp);
     vBlur(out_frame->base[2], out_frame->base[2], cw,ch,
-          out_frame->pitches[2], out_frame->pitches[2], chroma_radius, chroma_power);
+          out_frame->pitches[2], out_frame->pitches[2], chroma_radius, chroma_power, this->temp);
 
     pthread_mutex_unlock (&this->lock);
 
@@ -36,7 +36,6 @@
 #define PARAM1_DEFAULT 4.0
 #define PARAM2_DEFAULT 3.0
 #define PARAM3_DEFAULT 6.0
-#define MAX_LINE_WIDTH 2048
 
 
 typedef struct post_plugin_denoise3d_s post_plugin_denoise3d_t;
@@ -74,7 +73,8 @@ struct post_plugin_denoise3d_s {
   denoise3d_parameters_t params;
 
   int                    Coefs[4][512];
-  unsigned char          Line[MAX_LINE_WIDTH];
+  unsigned char         *Line;
+  int                    line_size;
   vo_frame_t            *prev_frame;
 
   pthread_mutex_t        lock;
@@ -153,6 +153,7 @@ static void denoise3d_dispose(post_plugin_t *this_gen)
 
   if (_x_post_dispose(this_gen)) {
     pthread_mutex_destroy(&this->lock);
+    free(this->Line);
     free(this);
   }
 }
@@ -181,50 +182,142 @@ static int denoise3d_intercept_frame(post_video_port_t *port, vo_frame_t *frame)
 }
 
 
-#define LowPass(Prev, Curr, Coef) (((Prev)*Coef[Prev - Curr] + (Curr)*(65536-(Coef[Prev - Curr]))) / 65536)
+/* (Prev * Coef + Curr * (65536 - Coef)) / 65536, without the division.
+ * That is the same for PrecalcCoefs () values 0 ... 65536. A strength of 0
+ * yields INT_MIN there, where both still agree on the byte that is stored. */
+#define LowPass(Prev, Curr, Coef) ((Curr) + ((((Prev) - (Curr)) * Coef[(Prev) - (Curr)]) >> 16))
 
-static void deNoise(unsigned char *Frame,
-                    unsigned char *FramePrev,
-                    unsigned char *FrameDest,
-                    unsigned char *LineAnt,
-                    int W, int H, int sStride, int pStride, int dStride,
-                    int *Horizontal, int *Vertical, int *Temporal)
+/*
+ * deNoise () runs in 2 passes that split up well. The horizontal lowpass
+ * of a pixel only depends on its own row. It goes to FrameDest, in bands
+ * of rows. The vertical and temporal lowpasses only depend on their own
+ * column. They then go over FrameDest in place, in bands of columns.
+ */
+typedef struct {
+  const unsigned char *Frame, *FramePrev;
+  unsigned char       *FrameDest, *LineAnt;
+  int                  W, H, sStride, pStride, dStride;
+  const int           *Horizontal, *Vertical, *Temporal;
+} denoise_plane_t;
+
+static void denoise_rows(void *data, int band, int y0, int y1)
 {
+    const denoise_plane_t *p = (const denoise_plane_t *)data;
+    const int *Horizontal = p->Horizontal;
     int X, Y;
-    int sLineOffs = 0, pLineOffs = 0, dLineOffs = 0;
-    unsigned char PixelAnt;
 
-    /* First pixel has no left nor top neightbour. Only previous frame */
-    LineAnt[0] = PixelAnt = Frame[0];
-    FrameDest[0] = LowPass(FramePrev[0], LineAnt[0], Temporal);
+    (void)band;
+    /* 4 rows at a time, their lowpass chains overlap. */
+    for (Y = y0; Y + 4 <= y1; Y += 4)
+    {
+        const unsigned char *F0 = p->Frame + Y * p->sStride, *F1 = F0 + p->sStride;
+        const unsigned char *F2 = F1 + p->sStride, *F3 = F2 + p->sStride;
+        unsigned char *D0 = p->FrameDest + Y * p->dStride, *D1 = D0 + p->dStride;
+        unsigned char *D2 = D1 + p->dStride, *D3 = D2 + p->dStride;
+        unsigned char P0 = F0[0], P1 = F1[0], P2 = F2[0], P3 = F3[0];
+
+        D0[0] = P0;
+        D1[0] = P1;
+        D2[0] = P2;
+        D3[0] = P3;
+        for (X = 1; X < p->W; X++)
+        {
+            P0 = LowPass(P0, F0[X], Horizontal);
+            P1 = LowPass(P1, F1[X], Horizontal);
+            P2 = LowPass(P2, F2[X], Horizontal);
+            P3 = LowPass(P3, F3[X], Horizontal);
+            D0[X] = P0;
+            D1[X] = P1;
+            D2[X] = P2;
+            D3[X] = P3;
+        }
+    }
+    for (; Y < y1; Y++)
+    {
+        const unsigned char *Frame = p->Frame + Y * p->sStride;
+        unsigned char *FrameDest = p->FrameDest + Y * p->dStride;
+        /* First pixel on each line doesn't have previous pixel */
+        unsigned char PixelAnt = Frame[0];
+
+        FrameDest[0] = PixelAnt;
+        for (X = 1; X < p->W; X++)
+        {
+            PixelAnt = LowPass(PixelAnt, Frame[X], Horizontal);
+            FrameDest[X] = PixelAnt;
+        }
+    }
+}
+
+/* vertical and temporal lowpass of n pixels below LineAnt. */
+static void denoise_vt(unsigned char *LineAnt, unsigned char *FrameDest,
+                       const unsigned char *FramePrev, int n,
+                       const int *Vertical, const int *Temporal)
+{
+    int X;
+
+    for (X = 0; X < n; X++)
+    {
+        LineAnt[X] = LowPass(LineAnt[X], FrameDest[X], Vertical);
+        FrameDest[X] = LowPass(FramePrev[X], LineAnt[X], Temporal);
+    }
+}
 
+static void denoise_columns(void *data, int band, int x0, int x1)
+{
+    const denoise_plane_t *p = (const denoise_plane_t *)data;
+    const int *Temporal = p->Temporal;
+    unsigned char *LineAnt = p->LineAnt + x0;
+    unsigned char *FrameDest = p->FrameDest + x0;
+    const unsigned char *FramePrev = p->FramePrev + x0;
+    int X, Y, n = x1 - x0;
+
+    (void)band;
     /* Fist line has no top neightbour. Only left one for each pixel and
      * last frame */
-    for (X = 1; X < W; X++)
+    for (X = 0; X < n; X++)
     {
-        PixelAnt = LowPass(PixelAnt, Frame[X], Horizontal);
-        LineAnt[X] = PixelAnt;
+        LineAnt[X] = FrameDest[X];
         FrameDest[X] = LowPass(FramePrev[X], LineAnt[X], Temporal);
     }
 
-    for (Y = 1; Y < H; Y++)
+    for (Y = 1; Y < p->H; Y++)
     {
-	sLineOffs += sStride, pLineOffs += pStride, dLineOffs += dStride;
-        /* First pixel on each line doesn't have previous pixel */
-        PixelAnt = Frame[sLineOffs];
-        LineAnt[0] = LowPass(LineAnt[0], PixelAnt, Vertical);
-        FrameDest[dLineOffs] = LowPass(FramePrev[pLineOffs], LineAnt[0], Temporal);
-
-        for (X = 1; X < W; X++)
-        {
-            /* The rest are normal */
-            PixelAnt = LowPass(PixelAnt, Frame[sLineOffs+X], Horizontal);
-            LineAnt[X] = LowPass(LineAnt[X], PixelAnt, Vertical);
-            FrameDest[dLineOffs+X] = LowPass(FramePrev[pLineOffs+X], LineAnt[X], Temporal);
-        }
+        FrameDest += p->dStride;
+        FramePrev += p->pStride;
+        denoise_vt(LineAnt, FrameDest, FramePrev, n, p->Vertical, Temporal);
     }
 }
 
+static void deNoise(unsigned char *Frame,
+                    unsigned char *FramePrev,
+                    unsigned char *FrameDest,
+                    unsigned char *LineAnt,
+                    int W, int H, int sStride, int pStride, int dStride,
+                    int *Horizontal, int *Vertical, int *Temporal)
+{
+    denoise_plane_t p = {
+        .Frame = Frame, .FramePrev = FramePrev, .FrameDest = FrameDest, .LineAnt = LineAnt,
+        .W = W, .H = H, .sStride = sStride, .pStride = pStride, .dStride = dStride,
+        .Horizontal = Horizontal, .Vertical = Vertical, .Temporal = Temporal
+    };
+    int bands = planar_num_bands(W, H);
+
+    planar_run_bands(denoise_rows, &p, H, 1, bands);
+    /* whole cache lines per band. */
+    planar_run_bands(denoise_columns, &p, W, 64, bands);
+}
+
+
+/* make room for a line of w pixels. */
+static int denoise3d_line(post_plugin_denoise3d_t *this, int w)
+{
+  if (this->line_size < w) {
+    free(this->Line);
+    this->Line = malloc(w);
+    this->line_size = this->Line ? w : 0;
+  }
+  return this->Line != NULL;
+}
 
 static int denoise3d_draw(vo_frame_t *frame, xine_stream_t *stream)
 {
@@ -236,7 +329,7 @@ static int denoise3d_draw(vo_frame_t *frame, xine_stream_t *stream)
   int cw, ch;
   int skip;
 
-  if( !frame->bad_frame ) {
+  if( !frame->bad_frame && denoise3d_line(this, frame->width) ) {
 
 
     /* convert to YV12 if needed */
@@ -173,6 +173,14 @@ struct post_plugin_eq_s {
 };
 
 
+/* neutral settings leave frames alone, let them bypass us. call with lock held. */
+static void eq_check_bypass (post_plugin_eq_t *this) {
+  post_video_port_t *port = (post_video_port_t *)this->post.xine_post.video_input[0];
+
+  if (port)
+    port->bypass = (this->params.brightness == 0) && (this->params.contrast == 0);
+}
+
 static int set_parameters (xine_post_t *this_gen, const void *param_gen) {
   post_plugin_eq_t *this = (post_plugin_eq_t *)this_gen;
   const eq_parameters_t *param = (const eq_parameters_t *)param_gen;
@@ -180,6 +188,7 @@ static int set_parameters (xine_post_t *this_gen, const void *param_gen) {
   pthread_mutex_lock (&this->lock);
 
   memcpy( &this->params, param, sizeof(eq_parameters_t) );
+  eq_check_bypass (this);
 
   pthread_mutex_unlock (&this->lock);
 
@@ -245,11 +254,13 @@ static int eq_set_property(xine_video_port_t *port_gen, int property, int value)
   if( property == XINE_PARAM_VO_BRIGHTNESS ) {
     pthread_mutex_lock (&this->lock);
     this->params.brightness = (200 * value / 65535) - 100;
+    eq_check_bypass (this);
     pthread_mutex_unlock (&this->lock);
     return value;
   } else if( property == XINE_PARAM_VO_CONTRAST ) {
     pthread_mutex_lock (&this->lock);
     this->params.contrast = (200 * value / 65535) - 100;
+    eq_check_bypass (this);
     pthread_mutex_unlock (&this->lock);
     return value;
   } else
@@ -384,6 +395,7 @@ static post_plugin_t *eq_open_plugin(post_class_t *class_gen, int inputs,
   output->xine_out.name   = "eqd video";
 
   this->post.xine_post.video_input[0] = &port->new_port;
+  eq_check_bypass (this);
 
   this->post.dispose = eq_dispose;
 
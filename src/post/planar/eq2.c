@@ -187,6 +187,123 @@ void affine_1d_MMX (eq2_param_t *par, unsigned char *dst, unsigned char *src,
 
   __asm__ __volatile__ ( "emms \n\t" ::: "memory" );
 }
+
+#if !defined(_MSC_VER)
+/* same math as affine_1d_MMX (), 16 or 32 pixels at a time. */
+static void affine_1d_tail (unsigned char *dst, const unsigned char *src, unsigned n,
+  int contrast, int brightness)
+{
+  while (n-- > 0) {
+    int pel = ((*src++ * contrast) >> 12) + brightness;
+    if (pel & 768) {
+      pel = (-pel) >> 31;
+    }
+    *dst++ = pel;
+  }
+}
+
+static
+void affine_1d_SSE2 (eq2_param_t *par, unsigned char *dst, unsigned char *src,
+  unsigned w, unsigned h, unsigned dstride, unsigned sstride)
+{
+  int contrast, brightness;
+
+  contrast = (int) (par->c * 256 * 16);
+  brightness = ((int) (100.0 * par->b + 100.0) * 511) / 200 - 128 - contrast / 32;
+
+  while (h-- > 0) {
+    intptr_t n = w & ~15u;
+
+    if (n) {
+      const unsigned char *s = src;
+      unsigned char *d = dst;
+      __asm__ __volatile__ (
+        "movd\t%3, %%xmm3\n\t"
+        "movd\t%4, %%xmm4\n\t"
+        "pshuflw\t$0, %%xmm3, %%xmm3\n\t"
+        "pshuflw\t$0, %%xmm4, %%xmm4\n\t"
+        "punpcklqdq\t%%xmm3, %%xmm3\n\t"
+        "punpcklqdq\t%%xmm4, %%xmm4\n\t"
+        "pxor\t%%xmm0, %%xmm0\n"
+        "1:\n\t"
+        "movdqu\t(%1), %%xmm1\n\t"
+        "movdqa\t%%xmm1, %%xmm2\n\t"
+        "punpcklbw\t%%xmm0, %%xmm1\n\t"
+        "punpckhbw\t%%xmm0, %%xmm2\n\t"
+        "psllw\t$4, %%xmm1\n\t"
+        "psllw\t$4, %%xmm2\n\t"
+        "pmulhw\t%%xmm4, %%xmm1\n\t"
+        "pmulhw\t%%xmm4, %%xmm2\n\t"
+        "paddw\t%%xmm3, %%xmm1\n\t"
+        "paddw\t%%xmm3, %%xmm2\n\t"
+        "packuswb\t%%xmm2, %%xmm1\n\t"
+        "movdqu\t%%xmm1, (%0)\n\t"
+        "add\t$16, %1\n\t"
+        "add\t$16, %0\n\t"
+        "sub\t$16, %2\n\t"
+        "jnz\t1b"
+        : "+r" (d), "+r" (s), "+r" (n)
+        : "r" (brightness), "r" (contrast)
+        : "xmm0", "xmm1", "xmm2", "xmm3", "xmm4", "cc", "memory");
+    }
+    affine_1d_tail (dst + (w & ~15u), src + (w & ~15u), w & 15, contrast, brightness);
+
+    src += sstride;
+    dst += dstride;
+  }
+}
+
+#ifdef HAVE_AVX2
+static
+void affine_1d_AVX2 (eq2_param_t *par, unsigned char *dst, unsigned char *src,
+  unsigned w, unsigned h, unsigned dstride, unsigned sstride)
+{
+  int contrast, brightness;
+
+  contrast = (int) (par->c * 256 * 16);
+  brightness = ((int) (100.0 * par->b + 100.0) * 511) / 200 - 128 - contrast / 32;
+
+  while (h-- > 0) {
+    intptr_t n = w & ~31u;
+
+    if (n) {
+      const unsigned char *s = src;
+      unsigned char *d = dst;
+      /* vpackuswb works inside 128 bit lanes, thus the vpermq. */
+      __asm__ __volatile__ (
+        "vmovd\t%3, %%xmm3\n\t"
+        "vmovd\t%4, %%xmm4\n\t"
+        "vpbroadcastw\t%%xmm3, %%ymm3\n\t"
+        "vpbroadcastw\t%%xmm4, %%ymm4\n"
+        "1:\n\t"
+        "vpmovzxbw\t(%1), %%ymm1\n\t"
+        "vpmovzxbw\t16(%1), %%ymm2\n\t"
+        "vpsllw\t$4, %%ymm1, %%ymm1\n\t"
+        "vpsllw\t$4, %%ymm2, %%ymm2\n\t"
+        "vpmulhw\t%%ymm4, %%ymm1, %%ymm1\n\t"
+        "vpmulhw\t%%ymm4, %%ymm2, %%ymm2\n\t"
+        "vpaddw\t%%ymm3, %%ymm1, %%ymm1\n\t"
+        "vpaddw\t%%ymm3, %%ymm2, %%ymm2\n\t"
+        "vpackuswb\t%%ymm2, %%ymm1, %%ymm1\n\t"
+        "vpermq\t$0xd8, %%ymm1, %%ymm1\n\t"
+        "vmovdqu\t%%ymm1, (%0)\n\t"
+        "add\t$32, %1\n\t"
+        "add\t$32, %0\n\t"
+        "sub\t$32, %2\n\t"
+        "jnz\t1b\n\t"
+        "vzeroupper"
+        : "+r" (d), "+r" (s), "+r" (n)
+        : "r" (brightness), "r" (contrast)
+        : "xmm1", "xmm2", "xmm3", "xmm4", "cc", "memory");
+    }
+    affine_1d_tail (dst + (w & ~31u), src + (w & ~31u), w & 31, contrast, brightness);
+
+    src += sstride;
+    dst += dstride;
+  }
+}
+#endif /* HAVE_AVX2 */
+#endif /* !_MSC_VER */
 #endif
 
 static
@@ -221,6 +338,16 @@ void check_values (eq2_param_t *par)
     par->adjust = NULL;
   }
 #if defined(ARCH_X86)
+# if !defined(_MSC_VER)
+#  ifdef HAVE_AVX2
+  else if (par->g == 1.0 && (xine_mm_accel() & MM_ACCEL_X86_AVX2) ) {
+    par->adjust = &affine_1d_AVX2;
+  }
+#  endif
+  else if (par->g == 1.0 && (xine_mm_accel() & MM_ACCEL_X86_SSE2) ) {
+    par->adjust = &affine_1d_SSE2;
+  }
+# endif
   else if (par->g == 1.0 && (xine_mm_accel() & MM_ACCEL_X86_MMX) ) {
     par->adjust = &affine_1d_MMX;
   }
@@ -339,6 +466,7 @@ static int set_parameters (xine_post_t *this_gen, const void *param_gen) {
   post_plugin_eq2_t *this = (post_plugin_eq2_t *)this_gen;
   const eq2_parameters_t *param = (const eq2_parameters_t *)param_gen;
   vf_eq2_t *eq2 = &this->eq2;
+  post_video_port_t *port;
 
   pthread_mutex_lock (&this->lock);
 
@@ -354,6 +482,11 @@ static int set_parameters (xine_post_t *this_gen, const void *param_gen) {
   set_brightness (eq2, param->brightness);
   set_saturation (eq2, param->saturation);
 
+  /* neutral settings leave frames alone, let them bypass us. */
+  port = (post_video_port_t *)this->post.xine_post.video_input[0];
+  if (port)
+    port->bypass = !eq2->param[0].adjust && !eq2->param[1].adjust && !eq2->param[2].adjust;
+
   pthread_mutex_unlock (&this->lock);
 
   return 1;
@@ -451,6 +584,21 @@ static int eq2_intercept_frame(post_video_port_t *port, vo_frame_t *frame)
 }
 
 
+typedef struct {
+  eq2_param_t   *par;
+  unsigned char *dst, *src;
+  unsigned       w, dstride, sstride;
+} eq2_plane_t;
+
+static void eq2_band (void *data, int band, int y0, int y1)
+{
+  eq2_plane_t *p = (eq2_plane_t *)data;
+
+  (void)band;
+  p->par->adjust (p->par, p->dst + y0 * p->dstride, p->src + y0 * p->sstride,
+    p->w, y1 - y0, p->dstride, p->sstride);
+}
+
 static int eq2_draw(vo_frame_t *frame, xine_stream_t *stream)
 {
   post_video_port_t *port = (post_video_port_t *)frame->port;
@@ -495,8 +643,15 @@ static int eq2_draw(vo_frame_t *frame, xine_stream_t *stream)
       height = (i==0) ? frame->height : frame->height/2;
       width = (i==0) ? frame->width : frame->width/2;
       if (eq2->param[i].adjust != NULL) {
-        eq2->param[i].adjust (&eq2->param[i], out_frame->base[i], yv12_frame->base[i],
-          width, height, out_frame->pitches[i], yv12_frame->pitches[i]);
+        eq2_plane_t p = {
+          .par = &eq2->param[i],
+          .dst = out_frame->base[i], .src = yv12_frame->base[i], .w = width,
+          .dstride = out_frame->pitches[i], .sstride = yv12_frame->pitches[i]
+        };
+        /* bands must not race on this. */
+        if (p.par->adjust == apply_lut && !p.par->lut_clean)
+          create_lut (p.par);
+        planar_run_bands (eq2_band, &p, height, 1, planar_num_bands (width, height));
       }
       else {
         xine_fast_memcpy(out_frame->base[i],yv12_frame->base[i],
@@ -248,6 +248,7 @@ static int set_parameters (xine_post_t *this_gen, const void *param_gen)
 {
     post_plugin_noise_t *this = (post_plugin_noise_t *)this_gen;
     const noise_parameters_t *param = (const noise_parameters_t *)param_gen;
+    post_video_port_t *port;
     int i;
 
     pthread_mutex_lock (&this->lock);
@@ -260,6 +261,10 @@ static int set_parameters (xine_post_t *this_gen, const void *param_gen)
     }
     this->params[0].strength = param->luma_strength;
     this->params[1].strength = param->chroma_strength;
+    /* neutral settings leave frames alone, let them bypass us. */
+    port = (post_video_port_t *)this->post.xine_post.video_input[0];
+    if (port)
+        port->bypass = !this->params[0].strength && !this->params[1].strength;
     pthread_mutex_unlock (&this->lock);
     initNoise(&this->params[0]);
     initNoise(&this->params[1]);
@@ -28,6 +28,54 @@
 
 #include <xine/xine_plugin.h>
 #include <xine/post.h>
+#include <xine/xineutils.h>
+
+/* less than that is not worth waking up a helper thread. */
+#define PLANAR_BAND_MIN_PIXELS (1 << 16)
+#define PLANAR_BAND_MAX        8
+
+int planar_num_bands (int w, int h) {
+  int n;
+
+  if (w * h < 2 * PLANAR_BAND_MIN_PIXELS)
+    return 1;
+  n = xine_slices_max ();
+  if (n > PLANAR_BAND_MAX)
+    n = PLANAR_BAND_MAX;
+  if (n > w * h / PLANAR_BAND_MIN_PIXELS)
+    n = w * h / PLANAR_BAND_MIN_PIXELS;
+  return n < 1 ? 1 : n;
+}
+
+typedef struct {
+  void (*func) (void *data, int band, int start, int end);
+  void  *data;
+  int    n, align;
+} planar_bands_t;
+
+static void planar_band (void *data, int band, int num_bands) {
+  planar_bands_t *b = (planar_bands_t *)data;
+  int units = (b->n + b->align - 1) / b->align;
+  int start = units * band / num_bands * b->align;
+  int end   = units * (band + 1) / num_bands * b->align;
+
+  if (end > b->n)
+    end = b->n;
+  if (start < end)
+    b->func (b->data, band, start, end);
+}
+
+void planar_run_bands (void (*func) (void *data, int band, int start, int end),
+                       void *data, int n, int align, int num_bands) {
+  planar_bands_t b = { .func = func, .data = data, .n = n, .align = align < 1 ? 1 : align };
+
+  if (num_bands <= 1) {
+    if (n > 0)
+      func (data, 0, 0, n);
+    return;
+  }
+  xine_slices_run (planar_band, &b, num_bands);
+}
 
 static const post_info_t gen_special_info = {
   .type = XINE_POST_TYPE_VIDEO_FILTER,
@@ -38,4 +38,12 @@ void *pp_init_plugin        (xine_t *xine, const void *);
 #endif
 void *unsharp_init_plugin   (xine_t *xine, const void *);
 
+/* big planes are filtered in bands on the xine_slices_run () threads.
+ * planar_num_bands () tells how many bands a w x h plane is worth.
+ * planar_run_bands () splits [0, n) into num_bands parts with borders on
+ * multiples of align, and runs func (data, band, start, end) for each. */
+int  planar_num_bands (int w, int h);
+void planar_run_bands (void (*func) (void *data, int band, int start, int end),
+                       void *data, int n, int align, int num_bands);
+
 #endif /* XINE_POST_PLANAR_H */
@@ -119,6 +119,362 @@ static void unsharp( uint8_t *dst, uint8_t *src, int dstStride, int srcStride, i
 }
 
 
+/*
+ * The blur above is separable: a binomial filter of 2 * stepsX + 1 taps
+ * along rows, and of 2 * stepsY + 1 taps along columns, repeating edge
+ * pixels. unsharp_fast () does the same sums one whole row at a time, in
+ * 32 bit lanes, in bands of rows that each prime their own state. Its
+ * results are the same.
+ */
+typedef struct {
+  uint32_t half;
+  int      scalebits;
+  int      amount;
+  /* amount = (amount_hi << 16) + amount_lo, with amount_lo signed. */
+  int      amount_hi, amount_lo;
+} unsharp_mix_t;
+
+typedef struct {
+  /* a[i] += a[i + 1]. */
+  void (*pairs) (uint32_t *a, int n);
+  /* v[i] += sc[i], while sc[i] takes the old v[i]. */
+  void (*stage) (uint32_t *v, uint32_t *sc, int n);
+  /* dst = src + (((src - ((v + half) >> scalebits)) * amount) >> 16). */
+  void (*mix)   (uint8_t *dst, const uint8_t *src, const uint32_t *v, int n, const unsharp_mix_t *m);
+} unsharp_funcs_t;
+
+static void unsharp_pairs_c (uint32_t *a, int n) {
+  int i;
+
+  for (i = 0; i < n; i++)
+    a[i] += a[i + 1];
+}
+
+static void unsharp_stage_c (uint32_t *v, uint32_t *sc, int n) {
+  int i;
+
+  for (i = 0; i < n; i++) {
+    uint32_t t = v[i];
+    v[i] = t + sc[i];
+    sc[i] = t;
+  }
+}
+
+static void unsharp_mix_c (uint8_t *dst, const uint8_t *src, const uint32_t *v, int n, const unsharp_mix_t *m) {
+  int i;
+
+  for (i = 0; i < n; i++) {
+    int32_t res = (int32_t)src[i] + ( ( ( (int32_t)src[i] - (int32_t)((v[i] + m->half) >> m->scalebits) ) * m->amount ) >> 16 );
+    dst[i] = res>255 ? 255 : res<0 ? 0 : (uint8_t)res;
+  }
+}
+
+#if defined(ARCH_X86) && !defined(_MSC_VER)
+static void unsharp_pairs_sse2 (uint32_t *a, int n) {
+  intptr_t k = n & ~7;
+
+  if (k) {
+    uint32_t *p = a;
+    __asm__ __volatile__ (
+      "1:\n\t"
+      "movdqu\t(%0), %%xmm0\n\t"
+      "movdqu\t16(%0), %%xmm1\n\t"
+      "movdqu\t4(%0), %%xmm2\n\t"
+      "movdqu\t20(%0), %%xmm3\n\t"
+      "paddd\t%%xmm2, %%xmm0\n\t"
+      "paddd\t%%xmm3, %%xmm1\n\t"
+      "movdqu\t%%xmm0, (%0)\n\t"
+      "movdqu\t%%xmm1, 16(%0)\n\t"
+      "add\t$32, %0\n\t"
+      "sub\t$8, %1\n\t"
+      "jnz\t1b"
+      : "+r" (p), "+r" (k)
+      :
+      : "xmm0", "xmm1", "xmm2", "xmm3", "cc", "memory");
+  }
+  unsharp_pairs_c (a + (n & ~7), n & 7);
+}
+
+static void unsharp_stage_sse2 (uint32_t *v, uint32_t *sc, int n) {
+  intptr_t k = n & ~7;
+
+  if (k) {
+    uint32_t *p = v, *q = sc;
+    __asm__ __volatile__ (
+      "1:\n\t"
+      "movdqu\t(%0), %%xmm0\n\t"
+      "movdqu\t16(%0), %%xmm1\n\t"
+      "movdqu\t(%1), %%xmm2\n\t"
+      "movdqu\t16(%1), %%xmm3\n\t"
+      "movdqu\t%%xmm0, (%1)\n\t"
+      "movdqu\t%%xmm1, 16(%1)\n\t"
+      "paddd\t%%xmm2, %%xmm0\n\t"
+      "paddd\t%%xmm3, %%xmm1\n\t"
+      "movdqu\t%%xmm0, (%0)\n\t"
+      "movdqu\t%%xmm1, 16(%0)\n\t"
+      "add\t$32, %0\n\t"
+      "add\t$32, %1\n\t"
+      "sub\t$8, %2\n\t"
+      "jnz\t1b"
+      : "+r" (p), "+r" (q), "+r" (k)
+      :
+      : "xmm0", "xmm1", "xmm2", "xmm3", "cc", "memory");
+  }
+  unsharp_stage_c (v + (n & ~7), sc + (n & ~7), n & 7);
+}
+
+/* the blur fits a signed word, and so does the result before packuswb.
+ * (d * amount) >> 16 = d * amount_hi + pmulhw (d, amount_lo). */
+static void unsharp_mix_sse2 (uint8_t *dst, const uint8_t *src, const uint32_t *v, int n, const unsharp_mix_t *m) {
+  intptr_t k = n & ~7;
+
+  if (k) {
+    uint8_t *d = dst;
+    const uint8_t *s = src;
+    const uint32_t *p = v;
+    __asm__ __volatile__ (
+      "movd\t%4, %%xmm4\n\t"
+      "pshufd\t$0, %%xmm4, %%xmm4\n\t"
+      "movd\t%5, %%xmm5\n\t"
+      "movd\t%6, %%xmm6\n\t"
+      "pshuflw\t$0, %%xmm6, %%xmm6\n\t"
+      "punpcklqdq\t%%xmm6, %%xmm6\n\t"
+      "movd\t%7, %%xmm7\n\t"
+      "pshuflw\t$0, %%xmm7, %%xmm7\n\t"
+      "punpcklqdq\t%%xmm7, %%xmm7\n"
+      "1:\n\t"
+      "movdqu\t(%2), %%xmm0\n\t"
+      "movdqu\t16(%2), %%xmm1\n\t"
+      "paddd\t%%xmm4, %%xmm0\n\t"
+      "paddd\t%%xmm4, %%xmm1\n\t"
+      "psrld\t%%xmm5, %%xmm0\n\t"
+      "psrld\t%%xmm5, %%xmm1\n\t"
+      "packssdw\t%%xmm1, %%xmm0\n\t"
+      "movq\t(%1), %%xmm2\n\t"
+      "pxor\t%%xmm3, %%xmm3\n\t"
+      "punpcklbw\t%%xmm3, %%xmm2\n\t"
+      "movdqa\t%%xmm2, %%xmm1\n\t"
+      "psubw\t%%xmm0, %%xmm1\n\t"
+      "movdqa\t%%xmm1, %%xmm0\n\t"
+      "pmullw\t%%xmm6, %%xmm0\n\t"
+      "pmulhw\t%%xmm7, %%xmm1\n\t"
+      "paddw\t%%xmm0, %%xmm2\n\t"
+      "paddw\t%%xmm1, %%xmm2\n\t"
+      "packuswb\t%%xmm2, %%xmm2\n\t"
+      "movq\t%%xmm2, (%0)\n\t"
+      "add\t$32, %2\n\t"
+      "add\t$8, %1\n\t"
+      "add\t$8, %0\n\t"
+      "sub\t$8, %3\n\t"
+      "jnz\t1b"
+      : "+r" (d), "+r" (s), "+r" (p), "+r" (k)
+      : "m" (m->half), "m" (m->scalebits), "m" (m->amount_hi), "m" (m->amount_lo)
+      : "xmm0", "xmm1", "xmm2", "xmm3", "xmm4", "xmm5", "xmm6", "xmm7", "cc", "memory");
+  }
+  unsharp_mix_c (dst + (n & ~7), src + (n & ~7), v + (n & ~7), n & 7, m);
+}
+
+#ifdef HAVE_AVX2
+static void unsharp_pairs_avx2 (uint32_t *a, int n) {
+  intptr_t k = n & ~15;
+
+  if (k) {
+    uint32_t *p = a;
+    __asm__ __volatile__ (
+      "1:\n\t"
+      "vmovdqu\t(%0), %%ymm0\n\t"
+      "vmovdqu\t32(%0), %%ymm1\n\t"
+      "vpaddd\t4(%0), %%ymm0, %%ymm0\n\t"
+      "vpaddd\t36(%0), %%ymm1, %%ymm1\n\t"
+      "vmovdqu\t%%ymm0, (%0)\n\t"
+      "vmovdqu\t%%ymm1, 32(%0)\n\t"
+      "add\t$64, %0\n\t"
+      "sub\t$16, %1\n\t"
+      "jnz\t1b\n\t"
+      "vzeroupper"
+      : "+r" (p), "+r" (k)
+      :
+      : "xmm0", "xmm1", "cc", "memory");
+  }
+  unsharp_pairs_c (a + (n & ~15), n & 15);
+}
+
+static void unsharp_stage_avx2 (uint32_t *v, uint32_t *sc, int n) {
+  intptr_t k = n & ~15;
+
+  if (k) {
+    uint32_t *p = v, *q = sc;
+    __asm__ __volatile__ (
+      "1:\n\t"
+      "vmovdqu\t(%0), %%ymm0\n\t"
+      "vmovdqu\t32(%0), %%ymm1\n\t"
+      "vpaddd\t(%1), %%ymm0, %%ymm2\n\t"
+      "vpaddd\t32(%1), %%ymm1, %%ymm3\n\t"
+      "vmovdqu\t%%ymm0, (%1)\n\t"
+      "vmovdqu\t%%ymm1, 32(%1)\n\t"
+      "vmovdqu\t%%ymm2, (%0)\n\t"
+      "vmovdqu\t%%ymm3, 32(%0)\n\t"
+      "add\t$64, %0\n\t"
+      "add\t$64, %1\n\t"
+      "sub\t$16, %2\n\t"
+      "jnz\t1b\n\t"
+      "vzeroupper"
+      : "+r" (p), "+r" (q), "+r" (k)
+      :
+      : "xmm0", "xmm1", "xmm2", "xmm3", "cc", "memory");
+  }
+  unsharp_stage_c (v + (n & ~15), sc + (n & ~15), n & 15);
+}
+
+/* vpackssdw and vpackuswb work inside 128 bit lanes, thus the vpermq. */
+static void unsharp_mix_avx2 (uint8_t *dst, const uint8_t *src, const uint32_t *v, int n, const unsharp_mix_t *m) {
+  intptr_t k = n & ~15;
+
+  if (k) {
+    uint8_t *d = dst;
+    const uint8_t *s = src;
+    const uint32_t *p = v;
+    __asm__ __volatile__ (
+      "vpbroadcastd\t%4, %%ymm4\n\t"
+      "vmovd\t%5, %%xmm5\n\t"
+      "vpbroadcastw\t%6, %%ymm6\n\t"
+      "vpbroadcastw\t%7, %%ymm7\n"
+      "1:\n\t"
+      "vpaddd\t(%2), %%ymm4, %%ymm0\n\t"
+      "vpaddd\t32(%2), %%ymm4, %%ymm1\n\t"
+      "vpsrld\t%%xmm5, %%ymm0, %%ymm0\n\t"
+      "vpsrld\t%%xmm5, %%ymm1, %%ymm1\n\t"
+      "vpackssdw\t%%ymm1, %%ymm0, %%ymm0\n\t"
+      "vpermq\t$0xd8, %%ymm0, %%ymm0\n\t"
+      "vpmovzxbw\t(%1), %%ymm2\n\t"
+      "vpsubw\t%%ymm0, %%ymm2, %%ymm1\n\t"
+      "vpmullw\t%%ymm6, %%ymm1, %%ymm0\n\t"
+      "vpmulhw\t%%ymm7, %%ymm1, %%ymm1\n\t"
+      "vpaddw\t%%ymm0, %%ymm2, %%ymm2\n\t"
+      "vpaddw\t%%ymm1, %%ymm2, %%ymm2\n\t"
+      "vpackuswb\t%%ymm2, %%ymm2, %%ymm2\n\t"
+      "vpermq\t$0x08, %%ymm2, %%ymm2\n\t"
+      "vmovdqu\t%%xmm2, (%0)\n\t"
+      "add\t$64, %2\n\t"
+      "add\t$16, %1\n\t"
+      "add\t$16, %0\n\t"
+      "sub\t$16, %3\n\t"
+      "jnz\t1b\n\t"
+      "vzeroupper"
+      : "+r" (d), "+r" (s), "+r" (p), "+r" (k)
+      : "m" (m->half), "m" (m->scalebits), "m" (m->amount_hi), "m" (m->amount_lo)
+      : "xmm0", "xmm1", "xmm2", "xmm4", "xmm5", "xmm6", "xmm7", "cc", "memory");
+  }
+  unsharp_mix_c (dst + (n & ~15), src + (n & ~15), v + (n & ~15), n & 15, m);
+}
+#endif /* HAVE_AVX2 */
+#endif /* ARCH_X86 */
+
+static unsharp_funcs_t unsharp_funcs = {
+  unsharp_pairs_c, unsharp_stage_c, unsharp_mix_c
+};
+
+static pthread_once_t unsharp_funcs_once = PTHREAD_ONCE_INIT;
+
+static void unsharp_funcs_init (void) {
+#if defined(ARCH_X86) && !defined(_MSC_VER)
+  uint32_t caps = xine_mm_accel ();
+
+# ifdef HAVE_AVX2
+  if (caps & MM_ACCEL_X86_AVX2) {
+    unsharp_funcs.pairs = unsharp_pairs_avx2;
+    unsharp_funcs.stage = unsharp_stage_avx2;
+    unsharp_funcs.mix   = unsharp_mix_avx2;
+    return;
+  }
+# endif
+  if (caps & MM_ACCEL_X86_SSE2) {
+    unsharp_funcs.pairs = unsharp_pairs_sse2;
+    unsharp_funcs.stage = unsharp_stage_sse2;
+    unsharp_funcs.mix   = unsharp_mix_sse2;
+  }
+#endif
+}
+
+typedef struct {
+  uint8_t       *dst, *src;
+  int            dstStride, srcStride, width, height;
+  int            stepsX, stepsY;
+  unsharp_mix_t  mix;
+  /* per band: one row with edges, and 2 * stepsY rows of column state. */
+  uint32_t      *temp;
+  size_t         band_size;
+} unsharp_plane_t;
+
+static void unsharp_band (void *data, int band, int y0, int y1) {
+  unsharp_plane_t *p = (unsharp_plane_t *)data;
+  int w = p->width, sx = p->stepsX, sy = p->stepsY;
+  uint32_t *row = p->temp + band * p->band_size;
+  uint32_t *sc = row + w + 2 * sx;
+  int y, z, fed = 0;
+
+  memset (sc, 0, sizeof (*sc) * 2 * sy * w);
+
+  for (y = y0 - sy; y < y1 + sy; y++) {
+    const uint8_t *src = p->src + (y < 0 ? 0 : y >= p->height ? p->height - 1 : y) * p->srcStride;
+    int x;
+
+    for (x = 0; x < sx; x++) {
+      row[x] = src[0];
+      row[sx + w + x] = src[w - 1];
+    }
+    for (x = 0; x < w; x++)
+      row[sx + x] = src[x];
+    for (z = 0; z < 2 * sx; z++)
+      unsharp_funcs.pairs (row, w + 2 * sx - 1 - z);
+
+    for (z = 0; z < 2 * sy; z++)
+      unsharp_funcs.stage (row, sc + z * w, w);
+
+    if (++fed > 2 * sy)
+      unsharp_funcs.mix (p->dst + (y - sy) * p->dstStride, p->src + (y - sy) * p->srcStride,
+        row, w, &p->mix);
+  }
+}
+
+/* returns 0 for what only unsharp () can do. */
+static int unsharp_fast( uint8_t *dst, uint8_t *src, int dstStride, int srcStride, int width, int height, FilterParam *fp ) {
+  unsharp_plane_t p;
+  int amount = fp->amount * 65536.0;
+  int bands;
+
+  p.stepsX = fp->msizeX/2;
+  p.stepsY = fp->msizeY/2;
+  /* sums must fit 32 bits, results of the mix 16 bits. */
+  if( !fp->amount || width < 1 || src == dst || p.stepsX + p.stepsY > 12 ||
+      amount > (4 << 16) || amount < -(4 << 16) )
+    return 0;
+
+  p.dst = dst;
+  p.src = src;
+  p.dstStride = dstStride;
+  p.srcStride = srcStride;
+  p.width = width;
+  p.height = height;
+  p.mix.scalebits = (p.stepsX + p.stepsY) * 2;
+  p.mix.half = 1 << (p.mix.scalebits - 1);
+  p.mix.amount = amount;
+  p.mix.amount_hi = (amount + (1 << 15)) >> 16;
+  p.mix.amount_lo = amount - p.mix.amount_hi * (1 << 16);
+
+  bands = planar_num_bands (width, height);
+  p.band_size = (width + 2 * p.stepsX) + 2 * p.stepsY * width;
+  p.temp = malloc (sizeof (*p.temp) * p.band_size * bands);
+  if (!p.temp)
+    return 0;
+
+  pthread_once (&unsharp_funcs_once, unsharp_funcs_init);
+  planar_run_bands (unsharp_band, &p, height, 1, bands);
+  free (p.temp);
+  return 1;
+}
+
+
 typedef struct post_plugin_unsharp_s post_plugin_unsharp_t;
 
 /*
@@ -170,6 +526,7 @@ struct post_plugin_unsharp_s {
 static int set_parameters (xine_post_t *this_gen, const void *param_gen) {
   post_plugin_unsharp_t *this = (post_plugin_unsharp_t *)this_gen;
   const unsharp_parameters_t *param = (const unsharp_parameters_t *)param_gen;
+  post_video_port_t *port;
   FilterParam *fp;
 
   pthread_mutex_lock (&this->lock);
@@ -189,6 +546,11 @@ static int set_parameters (xine_post_t *this_gen, const void *param_gen) {
 
   this->priv.width = this->priv.height = 0;
 
+  /* neutral settings leave frames alone, let them bypass us. */
+  port = (post_video_port_t *)this->post.xine_post.video_input[0];
+  if (port)
+    port->bypass = !this->priv.lumaParam.amount && !this->priv.chromaParam.amount;
+
   pthread_mutex_unlock (&this->lock);
 
   return 1;
@@ -337,9 +699,12 @@ static int unsharp_draw(vo_frame_t *frame, xine_stream_t *stream)
          fp->SC[z] = malloc( sizeof(*(fp->SC[z])) * (frame->width+2*stepsX) );
     }
 
-    unsharp( out_frame->base[0], yv12_frame->base[0], out_frame->pitches[0], yv12_frame->pitches[0], yv12_frame->width,   yv12_frame->height,   &this->priv.lumaParam );
-    unsharp( out_frame->base[1], yv12_frame->base[1], out_frame->pitches[1], yv12_frame->pitches[1], yv12_frame->width/2, yv12_frame->height/2, &this->priv.chromaParam );
-    unsharp( out_frame->base[2], yv12_frame->base[2], out_frame->pitches[2], yv12_frame->pitches[2], yv12_frame->width/2, yv12_frame->height/2, &this->priv.chromaParam );
+    if (!unsharp_fast( out_frame->base[0], yv12_frame->base[0], out_frame->pitches[0], yv12_frame->pitches[0], yv12_frame->width,   yv12_frame->height,   &this->priv.lumaParam ))
+      unsharp( out_frame->base[0], yv12_frame->base[0], out_frame->pitches[0], yv12_frame->pitches[0], yv12_frame->width,   yv12_frame->height,   &this->priv.lumaParam );
+    if (!unsharp_fast( out_frame->base[1], yv12_frame->base[1], out_frame->pitches[1], yv12_frame->pitches[1], yv12_frame->width/2, yv12_frame->height/2, &this->priv.chromaParam ))
+      unsharp( out_frame->base[1], yv12_frame->base[1], out_frame->pitches[1], yv12_frame->pitches[1], yv12_frame->width/2, yv12_frame->height/2, &this->priv.chromaParam );
+    if (!unsharp_fast( out_frame->base[2], yv12_frame->base[2], out_frame->pitches[2], yv12_frame->pitches[2], yv12_frame->width/2, yv12_frame->height/2, &this->priv.chromaParam ))
+      unsharp( out_frame->base[2], yv12_frame->base[2], out_frame->pitches[2], yv12_frame->pitches[2], yv12_frame->width/2, yv12_frame->height/2, &this->priv.chromaParam );
 
     pthread_mutex_unlock (&this->lock);
 
@@ -35,11 +35,17 @@
 static const post_info_t vdr_video_special_info = { XINE_POST_TYPE_VIDEO_FILTER };
 static const post_info_t vdr_audio_special_info = { XINE_POST_TYPE_AUDIO_FILTER };
 
+static const input_info_t vdr_input_special_info = {
+  .priority = 0,
+  .mrl_prefixes = "vdr:/ netvd"
+};
+
 /* exported plugin catalog entry */
 const plugin_info_t xine_plugin_info[] EXPORTED =
 {
   /* type       , API, "name"     , version          , special_info           , init_function */
-  { PLUGIN_INPUT,  18, "VDR"      , XINE_VERSION_CODE, NULL                   , &vdr_input_init_plugin },
+  { PLUGIN_INPUT | PLUGIN_INPUT_MRL_PREFIXES,
+                   18, "VDR"      , XINE_VERSION_CODE, &vdr_input_special_info, &vdr_input_init_plugin },
   { PLUGIN_POST ,  10, "vdr"      , XINE_VERSION_CODE, &vdr_video_special_info, &vdr_video_init_plugin },
   { PLUGIN_POST ,  10, "vdr_video", XINE_VERSION_CODE, &vdr_video_special_info, &vdr_video_init_plugin },
   { PLUGIN_POST ,  10, "vdr_audio", XINE_VERSION_CODE, &vdr_audio_special_info, &vdr_audio_init_plugin },
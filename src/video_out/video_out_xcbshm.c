@@ -68,6 +68,11 @@
 
 #include "xine_mmx.h"
 
+/* big frames are converted in up to that many row bands in parallel. */
+#define XSHM_MAX_BANDS 8
+/* min source pixels per band. */
+#define XSHM_BAND_SIZE (1 << 18)
+
 typedef struct {
   vo_frame_t         vo_frame;
 
@@ -87,6 +92,10 @@ typedef struct {
 
   int                state, offs0, offs1; /* crop helpers */
   uint8_t            *crop_start, *crop_flush, *crop_stop;
+
+  /* extra converters for parallel row bands, [0] is unused. */
+  yuv2rgb_t         *bands[XSHM_MAX_BANDS];
+  int                bands_ok; /* converters set up like yuv2rgb */
 } xshm_frame_t;
 
 /* frame.state */
@@ -403,6 +412,7 @@ static void xshm_frame_proc_setup (vo_frame_t *vo_img) {
           frame->bytes_per_line);
       break;
     }
+    frame->bands_ok = 1;
   }
 
   frame->state |= FS_FLAGS | FS_DONE;
@@ -476,9 +486,92 @@ static void xshm_frame_proc_slice (vo_frame_t *vo_img, uint8_t **src) {
   lprintf ("copy...done\n");
 }
 
+static void xshm_frame_band (void *data, int band, int num_bands) {
+  xshm_frame_t *frame = (xshm_frame_t *)data;
+  vo_frame_t   *vo_img = &frame->vo_frame;
+  yuv2rgb_t    *yuv2rgb = band ? frame->bands[band] : frame->yuv2rgb;
+  int           slices = (frame->sc.delivered_height - frame->sc.crop_top - frame->sc.crop_bottom + 15) >> 4;
+  int           s = band * slices / num_bands;
+  int           e = (band + 1) * slices / num_bands;
+  int           y = frame->sc.crop_top + (s << 4);
+
+  yuv2rgb->start_slice (yuv2rgb, s << 4);
+  if (frame->format == XINE_IMGFMT_YV12) {
+    const uint8_t *py = vo_img->base[0] + y * vo_img->pitches[0] + frame->sc.crop_left;
+    const uint8_t *pu = vo_img->base[1] + (y >> 1) * vo_img->pitches[1] + (frame->sc.crop_left >> 1);
+    const uint8_t *pv = vo_img->base[2] + (y >> 1) * vo_img->pitches[2] + (frame->sc.crop_left >> 1);
+    for (; s < e; s++) {
+      yuv2rgb->yuv2rgb_fun (yuv2rgb, frame->rgb_dst, py, pu, pv);
+      py += 16 * vo_img->pitches[0];
+      pu +=  8 * vo_img->pitches[1];
+      pv +=  8 * vo_img->pitches[2];
+    }
+  } else {
+    const uint8_t *p = vo_img->base[0] + y * vo_img->pitches[0] + frame->sc.crop_left * 2;
+    for (; s < e; s++) {
+      yuv2rgb->yuy22rgb_fun (yuv2rgb, frame->rgb_dst, p);
+      p += 16 * vo_img->pitches[0];
+    }
+  }
+}
+
+/* convert big frames in row bands on the xine_slices_run () threads.
+ * smaller ones, and those already sent through proc_slice () by the
+ * decoder, go the usual 16 line slice way. */
+static void xshm_frame_proc_frame (vo_frame_t *vo_img) {
+  xshm_frame_t  *frame = (xshm_frame_t *) vo_img;
+  xshm_driver_t *this  = (xshm_driver_t *) vo_img->driver;
+  int n, i;
+
+  if (vo_img->proc_called
+    || ((vo_img->format != XINE_IMGFMT_YV12) && (vo_img->format != XINE_IMGFMT_YUY2))
+    || ((vo_img->flags & VO_BOTH_FIELDS) != VO_BOTH_FIELDS))
+    return;
+  /* frame->sc is not set up yet. */
+  n = (vo_img->width * vo_img->height) / XSHM_BAND_SIZE;
+  if (n < 2)
+    return;
+  i = xine_slices_max ();
+  if (n > i)
+    n = i;
+  if (n > XSHM_MAX_BANDS)
+    n = XSHM_MAX_BANDS;
+  if (n < 2)
+    return;
+
+  xshm_frame_proc_setup (vo_img);
+  vo_img->proc_called = 1;
+
+  i = (frame->sc.delivered_height - frame->sc.crop_top - frame->sc.crop_bottom + 15) >> 4;
+  if (n > i)
+    n = i;
+  /* set up band converters like the main one. */
+  for (i = frame->bands_ok; i < n; i++) {
+    if (!frame->bands[i]) {
+      frame->bands[i] = this->yuv2rgb_factory->create_converter (this->yuv2rgb_factory);
+      if (!frame->bands[i])
+        break;
+    }
+    if (!frame->bands[i]->configure (frame->bands[i],
+      frame->sc.delivered_width - frame->sc.crop_left - frame->sc.crop_right,
+      frame->sc.delivered_height - frame->sc.crop_top - frame->sc.crop_bottom,
+      vo_img->pitches[0], vo_img->pitches[1],
+      frame->sc.output_width, frame->sc.output_height,
+      frame->bytes_per_line))
+      break;
+  }
+  if (i > frame->bands_ok)
+    frame->bands_ok = i;
+  if (n > frame->bands_ok)
+    n = frame->bands_ok;
+
+  xine_slices_run (xshm_frame_band, frame, n);
+}
+
 static void xshm_frame_dispose (vo_frame_t *vo_img) {
   xshm_frame_t  *frame = (xshm_frame_t *) vo_img ;
   xshm_driver_t *this  = (xshm_driver_t *) vo_img->driver;
+  int i;
 
   if (frame->image) {
     pthread_mutex_lock(&this->main_mutex);
@@ -487,6 +580,10 @@ static void xshm_frame_dispose (vo_frame_t *vo_img) {
   }
 
   frame->yuv2rgb->dispose (frame->yuv2rgb);
+  for (i = 1; i < XSHM_MAX_BANDS; i++) {
+    if (frame->bands[i])
+      frame->bands[i]->dispose (frame->bands[i]);
+  }
 
   xine_free_aligned (frame->vo_frame.base[0]);
   xine_free_aligned (frame->vo_frame.base[1]);
@@ -523,7 +620,7 @@ static vo_frame_t *xshm_alloc_frame (vo_driver_t *this_gen) {
    */
 
   frame->vo_frame.proc_slice = xshm_frame_proc_slice;
-  frame->vo_frame.proc_frame = NULL;
+  frame->vo_frame.proc_frame = xshm_frame_proc_frame;
   frame->vo_frame.field      = xshm_frame_field;
   frame->vo_frame.dispose    = xshm_frame_dispose;
   frame->vo_frame.driver     = this_gen;
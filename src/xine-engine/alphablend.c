@@ -46,9 +46,85 @@
 
 #define BLEND_BYTE(dst, src, o) (((((src)-(dst))*(o*0x1111+1))>>16)+(dst))
 
+#if defined(ARCH_X86) && !defined(_MSC_VER)
+static int blend_sse2 = 0;
+static pthread_once_t blend_once = PTHREAD_ONCE_INIT;
+
+static void blend_init (void) {
+  blend_sse2 = !!(xine_mm_accel () & MM_ACCEL_X86_SSE2);
+}
+
+/* BLEND_BYTE () on n bytes, n a multiple of 16. k[0] holds the target
+ * values, k[1] the factors (o * 0x1111 + 1), and k[2] is 0xffff where
+ * a factor does not fit a signed word. pmulhw then gets (v - d) * (m - 0x10000),
+ * and the missing (v - d) is added back. a factor of 0 leaves that byte alone. */
+static void mem_blend_sse2 (uint8_t *mem, intptr_t n, const uint16_t (*k)[8]) {
+  __asm__ __volatile__ (
+    "movdqu\t(%2), %%xmm5\n\t"
+    "movdqu\t16(%2), %%xmm6\n\t"
+    "movdqu\t32(%2), %%xmm7\n"
+    "1:\n\t"
+    "movdqu\t(%0), %%xmm0\n\t"
+    "movdqa\t%%xmm0, %%xmm1\n\t"
+    "punpcklbw\t%%xmm0, %%xmm0\n\t"
+    "punpckhbw\t%%xmm1, %%xmm1\n\t"
+    "psrlw\t$8, %%xmm0\n\t"
+    "psrlw\t$8, %%xmm1\n\t"
+    "movdqa\t%%xmm5, %%xmm2\n\t"
+    "movdqa\t%%xmm5, %%xmm3\n\t"
+    "psubw\t%%xmm0, %%xmm2\n\t"
+    "psubw\t%%xmm1, %%xmm3\n\t"
+    "movdqa\t%%xmm2, %%xmm4\n\t"
+    "pand\t%%xmm7, %%xmm4\n\t"
+    "paddw\t%%xmm4, %%xmm0\n\t"
+    "movdqa\t%%xmm3, %%xmm4\n\t"
+    "pand\t%%xmm7, %%xmm4\n\t"
+    "paddw\t%%xmm4, %%xmm1\n\t"
+    "pmulhw\t%%xmm6, %%xmm2\n\t"
+    "pmulhw\t%%xmm6, %%xmm3\n\t"
+    "paddw\t%%xmm2, %%xmm0\n\t"
+    "paddw\t%%xmm3, %%xmm1\n\t"
+    "packuswb\t%%xmm1, %%xmm0\n\t"
+    "movdqu\t%%xmm0, (%0)\n\t"
+    "add\t$16, %0\n\t"
+    "sub\t$16, %1\n\t"
+    "jnz\t1b"
+    : "+r" (mem), "+r" (n)
+    : "r" (k)
+    : "xmm0", "xmm1", "xmm2", "xmm3", "xmm4", "xmm5", "xmm6", "xmm7", "cc", "memory");
+}
+
+/* set up mem_blend_sse2 () for a value pattern repeating every period bytes.
+ * with skip, every second byte is left alone. */
+static void mem_blend_sse2_init (uint16_t (*k)[8], const uint8_t *v, int period, int skip, uint8_t o) {
+  uint16_t m = o * 0x1111 + 1;
+  int i;
+
+  for (i = 0; i < 8; i++) {
+    int keep = skip && (i & 1);
+    k[0][i] = v[i % period];
+    k[1][i] = keep ? 0 : m;
+    k[2][i] = (keep || (m < 0x8000)) ? 0 : 0xffff;
+  }
+}
+#endif
+
 static void mem_blend8(uint8_t *mem, uint8_t val, uint8_t o, size_t sz)
 {
-  uint8_t *limit = mem + sz;
+  uint8_t *limit;
+
+#if defined(ARCH_X86) && !defined(_MSC_VER)
+  if (blend_sse2 && (o < 15) && (sz >= 16)) {
+    uint16_t k[3][8];
+    size_t n = sz & ~(size_t)15;
+
+    mem_blend_sse2_init (k, &val, 1, 0, o);
+    mem_blend_sse2 (mem, n, (const uint16_t (*)[8])k);
+    mem += n;
+    sz -= n;
+  }
+#endif
+  limit = mem + sz;
   while (mem < limit) {
     *mem = BLEND_BYTE(*mem, val, o);
     mem++;
@@ -80,7 +156,30 @@ static void mem_blend24(uint8_t *mem, uint8_t r, uint8_t g, uint8_t b,
 }
 
 static void mem_blend32(uint8_t *mem, const uint8_t *src, uint8_t o, int len) {
-  uint8_t *limit = mem + len*4;
+  uint8_t *limit;
+
+#if defined(ARCH_X86) && !defined(_MSC_VER)
+  if (blend_sse2 && (o < 15) && (len >= 4)) {
+    uint16_t k[3][8];
+    int n = len & ~3;
+
+    mem_blend_sse2_init (k, src, 4, 0, o);
+    mem_blend_sse2 (mem, n * 4, (const uint16_t (*)[8])k);
+    mem += n * 4;
+    len -= n;
+  }
+#endif
+  if (o == 15) {
+    /* BLEND_BYTE () yields src exactly. */
+    uint32_t v;
+    memcpy (&v, src, 4);
+    while (len-- > 0) {
+      memcpy (mem, &v, 4);
+      mem += 4;
+    }
+    return;
+  }
+  limit = mem + len*4;
   while (mem < limit) {
     *mem = BLEND_BYTE(*mem, src[0], o);
     mem++;
@@ -93,6 +192,26 @@ static void mem_blend32(uint8_t *mem, const uint8_t *src, uint8_t o, int len) {
   }
 }
 
+/* like mem_blend8 (), but on every second byte only. */
+static void mem_blend8_2(uint8_t *mem, uint8_t val, uint8_t o, int len)
+{
+#if defined(ARCH_X86) && !defined(_MSC_VER)
+  if (blend_sse2 && (o < 15) && (len >= 8)) {
+    uint16_t k[3][8];
+    int n = len & ~7;
+
+    mem_blend_sse2_init (k, &val, 1, 1, o);
+    mem_blend_sse2 (mem, n * 2, (const uint16_t (*)[8])k);
+    mem += n * 2;
+    len -= n;
+  }
+#endif
+  while (len-- > 0) {
+    *mem = BLEND_BYTE(*mem, val, o);
+    mem += 2;
+  }
+}
+
 /*
  * Some macros for fixed point arithmetic.
  *
@@ -1061,12 +1180,94 @@ void _x_blend_rgb32 (uint8_t * img, vo_overlay_t * img_overl,
   }
 }
 
-static void blend_yuv_exact(uint8_t *dst_cr, uint8_t *dst_cb, int src_width,
+#if defined(ARCH_X86) && !defined(_MSC_VER)
+/* 8 chroma samples of blend_yuv_exact (). opacities are at most 0xf, thus
+ * the sums stay below 0x10000, and the 3 cases there all come out as
+ * ((dst * t4 + sum (chroma * o)) * 0x1112) >> 18.
+ * line buffers are at p + n * stride, in blend_yuv_grow_extra_data () order. */
+static void blend_yuv_exact_sse2 (uint8_t *dst_cr, uint8_t *dst_cb, const uint8_t *p, intptr_t stride)
+{
+  static const uint16_t k[3][8] = {
+    {0x00ff, 0x00ff, 0x00ff, 0x00ff, 0x00ff, 0x00ff, 0x00ff, 0x00ff},
+    {4*0xf, 4*0xf, 4*0xf, 4*0xf, 4*0xf, 4*0xf, 4*0xf, 4*0xf},
+    {0x1112, 0x1112, 0x1112, 0x1112, 0x1112, 0x1112, 0x1112, 0x1112}
+  };
+  const uint8_t *q = p + 3 * stride;
+
+#define BLEND_YUV_EXACT_SSE2_CHROMA(src0,src1,dst) \
+    "movdqu\t" src0 ", %%xmm4\n\t" \
+    "pand\t%%xmm7, %%xmm4\n\t" \
+    "pmullw\t%%xmm0, %%xmm4\n\t" \
+    "movdqu\t" src0 ", %%xmm6\n\t" \
+    "psrlw\t$8, %%xmm6\n\t" \
+    "pmullw\t%%xmm1, %%xmm6\n\t" \
+    "paddw\t%%xmm6, %%xmm4\n\t" \
+    "movdqu\t" src1 ", %%xmm6\n\t" \
+    "pand\t%%xmm7, %%xmm6\n\t" \
+    "pmullw\t%%xmm2, %%xmm6\n\t" \
+    "paddw\t%%xmm6, %%xmm4\n\t" \
+    "movdqu\t" src1 ", %%xmm6\n\t" \
+    "psrlw\t$8, %%xmm6\n\t" \
+    "pmullw\t%%xmm3, %%xmm6\n\t" \
+    "paddw\t%%xmm6, %%xmm4\n\t" \
+    "movq\t" dst ", %%xmm6\n\t" \
+    "punpcklbw\t%%xmm6, %%xmm6\n\t" \
+    "psrlw\t$8, %%xmm6\n\t" \
+    "pmullw\t%%xmm5, %%xmm6\n\t" \
+    "paddw\t%%xmm4, %%xmm6\n\t" \
+    "movdqu\t%7, %%xmm4\n\t" \
+    "pmulhuw\t%%xmm4, %%xmm6\n\t" \
+    "psrlw\t$2, %%xmm6\n\t" \
+    "packuswb\t%%xmm6, %%xmm6\n\t" \
+    "movq\t%%xmm6, " dst "\n\t"
+
+  __asm__ __volatile__ (
+    "movdqu\t%5, %%xmm7\n\t"
+    /* opacities */
+    "movdqu\t(%2), %%xmm0\n\t"
+    "movdqa\t%%xmm0, %%xmm1\n\t"
+    "pand\t%%xmm7, %%xmm0\n\t"
+    "psrlw\t$8, %%xmm1\n\t"
+    "movdqu\t(%2,%4), %%xmm2\n\t"
+    "movdqa\t%%xmm2, %%xmm3\n\t"
+    "pand\t%%xmm7, %%xmm2\n\t"
+    "psrlw\t$8, %%xmm3\n\t"
+    /* transparency */
+    "movdqu\t%6, %%xmm5\n\t"
+    "psubw\t%%xmm0, %%xmm5\n\t"
+    "psubw\t%%xmm1, %%xmm5\n\t"
+    "psubw\t%%xmm2, %%xmm5\n\t"
+    "psubw\t%%xmm3, %%xmm5\n\t"
+    BLEND_YUV_EXACT_SSE2_CHROMA ("(%2,%4,2)", "(%3)", "(%0)")
+    BLEND_YUV_EXACT_SSE2_CHROMA ("(%3,%4)", "(%3,%4,2)", "(%1)")
+    :
+    : "r" (dst_cr), "r" (dst_cb), "r" (p), "r" (q), "r" (stride), "m" (k[0]), "m" (k[1]), "m" (k[2])
+    : "xmm0", "xmm1", "xmm2", "xmm3", "xmm4", "xmm5", "xmm6", "xmm7", "memory");
+
+#undef BLEND_YUV_EXACT_SSE2_CHROMA
+}
+#endif
+
+/* blend chroma samples x / 2 ... (x_end - 1) / 2 from the 2 buffered lines. */
+static void blend_yuv_exact(uint8_t *dst_cr, uint8_t *dst_cb, int x, int x_end,
                             uint8_t *(*blend_yuv_data)[ 3 ][ 2 ])
 {
-  int x;
+  dst_cr += x >> 1;
+  dst_cb += x >> 1;
 
-  for (x = 0; x < src_width; x += 2) {
+#if defined(ARCH_X86) && !defined(_MSC_VER)
+  if (blend_sse2) {
+    intptr_t stride = (*blend_yuv_data)[ 0 ][ 1 ] - (*blend_yuv_data)[ 0 ][ 0 ];
+
+    for (; x + 16 <= x_end; x += 16) {
+      blend_yuv_exact_sse2 (dst_cr, dst_cb, (*blend_yuv_data)[ 0 ][ 0 ] + x, stride);
+      dst_cr += 8;
+      dst_cb += 8;
+    }
+  }
+#endif
+
+  for (; x < x_end; x += 2) {
     /* get opacity of the 4 pixels that share chroma */
     int o00 = (*blend_yuv_data)[ 0 ][ 0 ][ x + 0 ];
     int o01 = (*blend_yuv_data)[ 0 ][ 0 ][ x + 1 ];
@@ -1111,6 +1312,27 @@ static void blend_yuv_exact(uint8_t *dst_cr, uint8_t *dst_cb, int src_width,
   }
 }
 
+/* blend where the buffered lines are not transparent, and clear them again. */
+static void blend_yuv_flush(uint8_t *dst_cr, uint8_t *dst_cb, int exact_blend_width,
+                            int *dirty_left, int *dirty_right,
+                            uint8_t *(*blend_yuv_data)[ 3 ][ 2 ])
+{
+  int x = *dirty_left & ~1;
+  int x_end = (*dirty_right + 1) & ~1;
+
+  if (*dirty_right <= *dirty_left)
+    return;
+
+  if (x_end > exact_blend_width)
+    x_end = exact_blend_width;
+  blend_yuv_exact(dst_cr, dst_cb, x, x_end, blend_yuv_data);
+
+  memset(&(*blend_yuv_data)[ 0 ][ 0 ][ *dirty_left ], 0, *dirty_right - *dirty_left);
+  memset(&(*blend_yuv_data)[ 0 ][ 1 ][ *dirty_left ], 0, *dirty_right - *dirty_left);
+  *dirty_left = exact_blend_width + 1;
+  *dirty_right = 0;
+}
+
 static uint8_t *(*blend_yuv_grow_extra_data(alphablend_t *extra_data, int osd_width))[ 3 ][ 2 ]
 {
   struct header_s {
@@ -1177,9 +1399,10 @@ void _x_blend_yuv (uint8_t *dst_base[3], vo_overlay_t * img_overl,
   int clip_right, clip_left, clip_top;
   uint8_t clr=0;
 
-  int any_line_buffered = 0;
   int exact_blend_width = ((src_width <= (dst_width - x_off)) ? src_width : (dst_width - x_off));
   int exact_blend_width_m2 = (x_odd + exact_blend_width + 1) & ~1; /* make it a (larger) multiple of 2 */
+  /* the not transparent part of the buffered lines */
+  int dirty_left = exact_blend_width + 1, dirty_right = 0;
   uint8_t *(*blend_yuv_data)[ 3 ][ 2 ] = 0;
 
   uint8_t *dst_y = dst_base[0] + dst_pitches[0] * y_off + x_off;
@@ -1395,10 +1618,13 @@ void _x_blend_yuv (uint8_t *dst_base[3], vo_overlay_t * img_overl,
           rlelen += toClip;
         }
 
-        if (enable_exact_blending) {
+        if (enable_exact_blending && o) {
           /* remember opacity of current line */
-          memset(&(*blend_yuv_data)[ 0 ][ (y + y_odd) & 1 ][ x + x_odd ], o, rle_this_bite);
-          any_line_buffered |= ((y + y_odd) & 1) ? 2 : 1;
+          memset(&(*blend_yuv_data)[ 0 ][ (y + y_odd) & 1 ][ x + x_odd ], o > 0xf ? 0xf : o, rle_this_bite);
+          if (x + x_odd < dirty_left)
+            dirty_left = x + x_odd;
+          if (x + x_odd + rle_this_bite > dirty_right)
+            dirty_right = x + x_odd + rle_this_bite;
         }
 
         if (o && !clipped) {
@@ -1442,16 +1668,7 @@ void _x_blend_yuv (uint8_t *dst_base[3], vo_overlay_t * img_overl,
     if ((y + y_odd) & 1) {
       if (enable_exact_blending) {
         /* blend buffered lines */
-        if (any_line_buffered) {
-          if (!(any_line_buffered & 2)) {
-            /* make second line transparent */
-            memset(&(*blend_yuv_data)[ 0 ][ 1 ][ 0 ], 0, exact_blend_width_m2);
-          }
-
-          blend_yuv_exact(dst_cr, dst_cb, exact_blend_width, blend_yuv_data);
-
-          any_line_buffered = 0;
-        }
+        blend_yuv_flush(dst_cr, dst_cb, exact_blend_width, &dirty_left, &dirty_right, blend_yuv_data);
       }
 
       dst_cr += dst_pitches[2];
@@ -1463,14 +1680,7 @@ void _x_blend_yuv (uint8_t *dst_base[3], vo_overlay_t * img_overl,
 
   if (enable_exact_blending) {
     /* blend buffered lines */
-    if (any_line_buffered) {
-      if (!(any_line_buffered & 2)) {
-        /* make second line transparent */
-        memset(&(*blend_yuv_data)[ 0 ][ 1 ][ 0 ], 0, exact_blend_width_m2);
-      }
-
-      blend_yuv_exact(dst_cr, dst_cb, exact_blend_width, blend_yuv_data);
-    }
+    blend_yuv_flush(dst_cr, dst_cb, exact_blend_width, &dirty_left, &dirty_right, blend_yuv_data);
   }
 
 #ifdef LOG_BLEND_YUV
@@ -1879,11 +2089,8 @@ void _x_blend_yuy2 (uint8_t * dst_img, vo_overlay_t * img_overl,
                 dst++;
               }
             } else {
-              l = rle_this_bite;
-              while (l--) {
-                *dst = BLEND_BYTE(*dst, color.c.y, o);
-                dst += 2;
-              }
+              mem_blend8_2(dst, color.c.y, o, rle_this_bite);
+              dst += rle_this_bite * 2;
             }
           }
 
@@ -2162,6 +2369,10 @@ void _x_alphablend_init(alphablend_t *extra_data, xine_t *xine)
 {
   config_values_t *config = xine->config;
 
+#if defined(ARCH_X86) && !defined(_MSC_VER)
+  pthread_once (&blend_once, blend_init);
+#endif
+
   extra_data->buffer = NULL;
   extra_data->buffer_size = 0;
   extra_data->offset_x = 0;
@@ -184,6 +184,20 @@ static const sIIRCoefficients iir_cf[] = {
   { EQ_REAL(2.4201241845e-01), EQ_REAL(3.7899379077e-01), EQ_REAL(-8.0847117831e-01) },
 };
 
+/* float equalizer, bands padded for SIMD. all bands see the same input,
+ * so input history is per channel only. */
+#define EQ_VBANDS 12
+
+typedef struct {
+  float alpha[EQ_VBANDS], gamma[EQ_VBANDS], beta[EQ_VBANDS], gain[EQ_VBANDS];
+  struct {
+    float y1[EQ_VBANDS], y2[EQ_VBANDS];
+    float x1, x2, pad[2];
+  } ch[EQ_CHANNELS];
+} ao_eq_float_t;
+
+typedef struct ao_filter_method_s ao_filter_method_t;
+
 /* XXX: Apart from the typedef in include/xine/audio_out.h, this is used nowhere in xine. */
 struct audio_fifo_s {
   audio_buffer_t    *first;
@@ -262,6 +276,10 @@ typedef struct {
 
   int             resample_conf;
   uint32_t        force_rate;           /* force audio output rate to this value if non-zero */
+  int             resample_quality;     /* 0 (linear), XINE_RESAMPLE_QUALITY_* */
+  uint32_t        resample_in_rate;     /* nominal input rate, for the anti aliasing filter */
+  xine_resampler_t *resampler;          /* audio thread only */
+  int             resampler_channels, resampler_quality;
 
   struct {
     pthread_mutex_t  mutex;
@@ -311,6 +329,10 @@ typedef struct {
     int              gr_pos;
     int              gr_sum;
     int              gr_gaps[GAP_RING_SIZE];
+    /* free running clock client id. */
+    int              freerun_client;
+    /* topping up driver buffer from half to full driver_buffer. */
+    int              driver_fill;
   } rp;
 
   int64_t         last_audio_vpts;
@@ -320,6 +342,8 @@ typedef struct {
   int16_t        *zero_space;
 
   int             passthrough_offset, ptoffs;
+  /* keep driver buffer filled up to this (pts), 0 = let driver write () block. */
+  int             driver_buffer;
 
   int             dropped;
   int             step;
@@ -339,6 +363,10 @@ typedef struct {
   int             eq_gain[EQ_BANDS];
   /* Coefficient history for the IIR filter */
   int             eq_data_history[EQ_CHANNELS][EQ_BANDS][4];
+  ao_eq_float_t  *eq_float;             /* aligned */
+  /* C or SIMD filters, see engine.performance.audio_filter_method */
+  const ao_filter_method_t *filters;
+  int             filter_probe;         /* fastest method, -1 if not probed yet */
 
   int             last_gap;
   int             last_sgap;
@@ -762,16 +790,23 @@ static audio_buffer_t *ao_out_fifo_pop_int (aos_t *this) {
   return buf;
 }
 
+/* wake the loop from a free running clock wait. */
+static void ao_freerun_kick (aos_t *this) {
+  if (this->rp.freerun_client >= 0)
+    xine_freerun_kick (this->clock, this->rp.freerun_client);
+}
+
 static void ao_out_fifo_signal (aos_t *this) {
   pthread_mutex_lock (&this->out_fifo.mutex);
   this->out_fifo.wake_now = 1;
   if (this->out_fifo.num_waiters)
     pthread_cond_signal (&this->out_fifo.not_empty);
   pthread_mutex_unlock (&this->out_fifo.mutex);
+  ao_freerun_kick (this);
 }
 
 static audio_buffer_t *ao_out_fifo_get (aos_t *this, audio_buffer_t *buf) {
-  int dry = 0;
+  int dry = 0, idle = 0;
 
   pthread_mutex_lock (&this->out_fifo.mutex);
   /* this is 1 buf late, make it consistent at least. */
@@ -858,7 +893,14 @@ static audio_buffer_t *ao_out_fifo_get (aos_t *this, audio_buffer_t *buf) {
     if (this->out_fifo.wake_now || !this->audio_loop_running)
       break;
 
-    /* no more bufs for now... */
+    /* no more bufs for now, let the free running clock go on without us. */
+    if (!buf && !idle) {
+      idle = 1;
+      pthread_mutex_unlock (&this->out_fifo.mutex);
+      xine_freerun_want (this->clock, this->rp.freerun_client, XINE_FREERUN_IDLE, 0);
+      pthread_mutex_lock (&this->out_fifo.mutex);
+      continue;
+    }
     if (!this->out_fifo.use_wake_time) {
       pthread_mutex_lock (&this->driver.mutex);
       if ((this->driver.open > 1) && (this->driver.speed > 0)) {
@@ -972,7 +1014,10 @@ static audio_buffer_t *ao_free_fifo_get (aos_t *this) {
       xine_gettime (&ts);
       ts.tv_sec += 1;
       this->free_fifo.num_waiters++;
+      /* dont hold up other streams on a shared decoder thread. */
+      xine_dpool_blocking (1);
       pthread_cond_timedwait (&this->free_fifo.not_empty, &this->free_fifo.mutex, &ts);
+      xine_dpool_blocking (0);
       this->free_fifo.num_waiters--;
     }
   }
@@ -1028,6 +1073,7 @@ static void ao_out_fifo_loop_flush (aos_t *this) {
   int n;
   pthread_mutex_lock (&this->out_fifo.mutex);
   this->out_fifo.discard_buffers++;
+  ao_freerun_kick (this);
   while (this->out_fifo.first) {
     /* i think it's strange to send not_empty signal here (beside the enqueue
      * function), but it should do no harm. [MF]
@@ -1285,6 +1331,15 @@ int _x_ao_channels2mode (int channels) {
   return modes[(channels >= 0) && (channels < 9) ? channels : 0];
 }
 
+/* follow the peak level of the current buffer. */
+static void audio_filter_compress_update (aos_t *this, double f_max) {
+  this->compression_factor = this->compression_factor * 0.999 + f_max * 0.001;
+  if (this->compression_factor > f_max)
+    this->compression_factor = f_max;
+  if (this->compression_factor > this->compression_factor_max)
+    this->compression_factor = this->compression_factor_max;
+}
+
 static void audio_filter_compress (aos_t *this, int16_t *mem, int num_frames) {
 
   int    i, maxs;
@@ -1309,12 +1364,7 @@ static void audio_filter_compress (aos_t *this, int16_t *mem, int num_frames) {
 
   if (maxs>0) {
     f_max = 32767.0 / maxs;
-    this->compression_factor = this->compression_factor * 0.999 + f_max * 0.001;
-    if (this->compression_factor > f_max)
-      this->compression_factor = f_max;
-
-    if (this->compression_factor > this->compression_factor_max)
-      this->compression_factor = this->compression_factor_max;
+    audio_filter_compress_update (this, f_max);
   } else
     f_max = 1.0;
 
@@ -1359,6 +1409,22 @@ static void audio_filter_amp (aos_t *this, void *buf, int num_frames) {
       }
       mem[i] = test;
     }
+  } else if (this->input.bits == 32) {
+    float test, *mem = (float *)buf;
+
+    for (i = 0; i < total_frames; i++) {
+      test = mem[i] * amp_factor;
+      /* Force limit on amp_factor to prevent clipping */
+      if (test < -1.0f) {
+        this->amp_factor = amp_factor = -amp_factor / test;
+        test = -1.0f;
+      }
+      if (test > 1.0f) {
+        this->amp_factor = amp_factor = amp_factor / test;
+        test = 1.0f;
+      }
+      mem[i] = test;
+    }
   } else if (this->input.bits == 16) {
     int32_t test;
     int16_t *mem = (int16_t *) buf;
@@ -1379,6 +1445,30 @@ static void audio_filter_amp (aos_t *this, void *buf, int num_frames) {
   }
 }
 
+static void audio_filter_compress_float (aos_t *this, float *mem, int num_frames) {
+  int    i, n;
+  float  maxs, f;
+
+  n = num_frames * this->in_channels;
+  if (n <= 0)
+    return;
+
+  maxs = 0.0f;
+  for (i = 0; i < n; i++) {
+    float sample = fabsf (mem[i]);
+    if (sample > maxs)
+      maxs = sample;
+  }
+
+  if (maxs > 0.0f)
+    audio_filter_compress_update (this, 1.0 / maxs);
+
+  /* same as the 16 bit version. */
+  f = 0.98 * this->compression_factor * this->amp_factor;
+  for (i = 0; i < n; i++)
+    mem[i] *= f;
+}
+
 static void ao_eq_update (aos_t *this) {
   /* TJ. gxine assumes a setting range of 0..100, with 100 being the default.
      Lets try to fix that very broken api like this:
@@ -1426,6 +1516,10 @@ static void ao_eq_update (aos_t *this) {
         this->eq_gain[i] = this->eq_gain[i + 1];
       this->eq_gain[EQ_BANDS - 1] = EQ_REAL (1.0);
     }
+    if (this->eq_float) {
+      for (i = 0; i < EQ_BANDS; i++)
+        this->eq_float->gain[i] = (float)this->eq_gain[i] * (1.0f / (float)(1 << FP_FRBITS));
+    }
     this->do_equ = 1;
   }
 }
@@ -1474,9 +1568,565 @@ static void audio_filter_equalize (aos_t *this,
 
 }
 
+/* number of output frames (after resampling) for num_frames input frames. */
+static int ao_output_frames (aos_t *this, int num_frames) {
+  double acc_output_frames;
+  int    num_output_frames;
+
+  acc_output_frames = (double) num_frames * this->frame_rate_factor
+    * this->resample_sync_factor + this->output_frame_excess;
+
+  /* Truncate to an integer */
+  num_output_frames = acc_output_frames;
+
+  /* Keep track of the amount truncated */
+  this->output_frame_excess = acc_output_frames - (double) num_output_frames;
+  if ( this->output_frame_excess != 0 &&
+       !this->do_resample && !this->resample_sync_method)
+    this->output_frame_excess = 0;
+
+  lprintf ("outputting %d frames\n", num_output_frames);
+  return num_output_frames;
+}
+
+/* polyphase resampler for current input, or NULL. */
+static xine_resampler_t *ao_get_resampler (aos_t *this, int quality) {
+  if (!quality) {
+    if (this->resampler)
+      _x_audio_out_resampler_delete (&this->resampler);
+    return NULL;
+  }
+  if (!this->in_channels)
+    return NULL;
+  if (this->resampler && ((this->resampler_channels != this->in_channels)
+    || (this->resampler_quality != quality)))
+    _x_audio_out_resampler_delete (&this->resampler);
+  if (!this->resampler && (this->resample_sync_method || this->do_resample)) {
+    this->resampler = _x_audio_out_resampler_new (this->in_channels, quality);
+    this->resampler_channels = this->in_channels;
+    this->resampler_quality = quality;
+  }
+  if (this->resampler) {
+    if (this->do_resample)
+      _x_audio_out_resampler_set_rates (this->resampler, this->resample_in_rate, this->output.rate);
+    else
+      _x_audio_out_resampler_set_rates (this->resampler, 1, 1);
+  }
+  return this->resampler;
+}
+
+static void audio_filter_equalize_float (aos_t *this, float *data, int num_frames) {
+  ao_eq_float_t *eq = this->eq_float;
+  int num_channels, channel;
+
+  num_channels = this->in_channels;
+  if ((num_channels <= 0) || !eq)
+    return;
+  if (num_channels > EQ_CHANNELS)
+    num_channels = EQ_CHANNELS;
+
+  for (channel = 0; channel < num_channels; channel++) {
+    float *y1 = eq->ch[channel].y1, *y2 = eq->ch[channel].y2;
+    float x1 = eq->ch[channel].x1, x2 = eq->ch[channel].x2;
+    float *d = data + channel;
+    int    i, band;
+
+    for (i = 0; i < num_frames; i++) {
+      float in = *d, dx = in - x2, out = 0.0f;
+      x2 = x1;
+      x1 = in;
+      for (band = 0; band < EQ_BANDS; band++) {
+        float v = eq->alpha[band] * dx + eq->gamma[band] * y1[band] - eq->beta[band] * y2[band];
+        y2[band] = y1[band];
+        y1[band] = v;
+        out += v * eq->gain[band];
+      }
+      *d = out;
+      d += this->in_channels;
+    }
+    eq->ch[channel].x1 = x1;
+    eq->ch[channel].x2 = x2;
+  }
+}
+
+#if defined(ARCH_X86) && !defined(_MSC_VER)
+/*
+ * SSE2 filters. the equalizer runs all bands of a sample in parallel,
+ * and works in float for 16 bit input as well.
+ */
+
+static int ao_s16_absmax_sse2 (const int16_t *mem, int n) {
+  int i, m = 0;
+
+  if (n >= 8) {
+    intptr_t k = n & ~7;
+    uint32_t r;
+    __asm__ __volatile__ (
+      "pxor\t%%xmm7, %%xmm7\n"
+      "1:\n\t"
+      "movdqu\t(%1), %%xmm0\n\t"
+      "pxor\t%%xmm1, %%xmm1\n\t"
+      "psubsw\t%%xmm0, %%xmm1\n\t"
+      "pmaxsw\t%%xmm1, %%xmm0\n\t"
+      "pmaxsw\t%%xmm0, %%xmm7\n\t"
+      "add\t$16, %1\n\t"
+      "sub\t$8, %2\n\t"
+      "jnz\t1b\n\t"
+      "pshufd\t$0x4e, %%xmm7, %%xmm0\n\t"
+      "pmaxsw\t%%xmm0, %%xmm7\n\t"
+      "pshufd\t$0xb1, %%xmm7, %%xmm0\n\t"
+      "pmaxsw\t%%xmm0, %%xmm7\n\t"
+      "pshuflw\t$0xb1, %%xmm7, %%xmm0\n\t"
+      "pmaxsw\t%%xmm0, %%xmm7\n\t"
+      "movd\t%%xmm7, %0"
+      : "=r" (r), "+r" (mem), "+r" (k)
+      :
+      : "xmm0", "xmm1", "xmm7", "cc", "memory");
+    m = r & 0x7fff;
+  }
+  for (i = 0; i < (n & 7); i++) {
+    int v = abs (mem[i]);
+    if (v > m)
+      m = v;
+  }
+  return m;
+}
+
+/* mem[i] = (int)(mem[i] * f), saturated. */
+static void ao_s16_scale_sse2 (int16_t *mem, int n, float f) {
+  int i;
+
+  if (n >= 8) {
+    intptr_t k = n & ~7;
+    __asm__ __volatile__ (
+      "movss\t%2, %%xmm7\n\t"
+      "shufps\t$0, %%xmm7, %%xmm7\n"
+      "1:\n\t"
+      "movdqu\t(%0), %%xmm0\n\t"
+      "punpcklwd\t%%xmm0, %%xmm1\n\t"
+      "punpckhwd\t%%xmm0, %%xmm2\n\t"
+      "psrad\t$16, %%xmm1\n\t"
+      "psrad\t$16, %%xmm2\n\t"
+      "cvtdq2ps\t%%xmm1, %%xmm1\n\t"
+      "cvtdq2ps\t%%xmm2, %%xmm2\n\t"
+      "mulps\t%%xmm7, %%xmm1\n\t"
+      "mulps\t%%xmm7, %%xmm2\n\t"
+      "cvttps2dq\t%%xmm1, %%xmm1\n\t"
+      "cvttps2dq\t%%xmm2, %%xmm2\n\t"
+      "packssdw\t%%xmm2, %%xmm1\n\t"
+      "movdqu\t%%xmm1, (%0)\n\t"
+      "add\t$16, %0\n\t"
+      "sub\t$8, %1\n\t"
+      "jnz\t1b"
+      : "+r" (mem), "+r" (k)
+      : "m" (f)
+      : "xmm0", "xmm1", "xmm2", "xmm7", "cc", "memory");
+  }
+  for (i = 0; i < (n & 7); i++) {
+    int v = mem[i] * f;
+    mem[i] = v > INT16_MAX ? INT16_MAX : v < INT16_MIN ? INT16_MIN : v;
+  }
+}
+
+static float ao_float_absmax_sse (const float *mem, int n) {
+  static const uint32_t mask[4] ATTR_ALIGN(16) = {0x7fffffff, 0x7fffffff, 0x7fffffff, 0x7fffffff};
+  float m = 0.0f;
+  int i;
+
+  if (n >= 8) {
+    intptr_t k = n & ~7;
+    __asm__ __volatile__ (
+      "movups\t%3, %%xmm6\n\t"
+      "xorps\t%%xmm7, %%xmm7\n\t"
+      "xorps\t%%xmm5, %%xmm5\n"
+      "1:\n\t"
+      "movups\t(%1), %%xmm0\n\t"
+      "movups\t16(%1), %%xmm1\n\t"
+      "andps\t%%xmm6, %%xmm0\n\t"
+      "andps\t%%xmm6, %%xmm1\n\t"
+      "maxps\t%%xmm0, %%xmm7\n\t"
+      "maxps\t%%xmm1, %%xmm5\n\t"
+      "add\t$32, %1\n\t"
+      "sub\t$8, %2\n\t"
+      "jnz\t1b\n\t"
+      "maxps\t%%xmm5, %%xmm7\n\t"
+      "movhlps\t%%xmm7, %%xmm0\n\t"
+      "maxps\t%%xmm0, %%xmm7\n\t"
+      "movaps\t%%xmm7, %%xmm0\n\t"
+      "shufps\t$0x55, %%xmm0, %%xmm0\n\t"
+      "maxss\t%%xmm0, %%xmm7\n\t"
+      "movss\t%%xmm7, %0"
+      : "=m" (m), "+r" (mem), "+r" (k)
+      : "m" (mask[0])
+      : "xmm0", "xmm1", "xmm5", "xmm6", "xmm7", "cc", "memory");
+  }
+  for (i = 0; i < (n & 7); i++) {
+    float v = fabsf (mem[i]);
+    if (v > m)
+      m = v;
+  }
+  return m;
+}
+
+static void ao_float_scale_sse (float *mem, int n, float f) {
+  int i;
+
+  if (n >= 8) {
+    intptr_t k = n & ~7;
+    __asm__ __volatile__ (
+      "movss\t%2, %%xmm7\n\t"
+      "shufps\t$0, %%xmm7, %%xmm7\n"
+      "1:\n\t"
+      "movups\t(%0), %%xmm0\n\t"
+      "movups\t16(%0), %%xmm1\n\t"
+      "mulps\t%%xmm7, %%xmm0\n\t"
+      "mulps\t%%xmm7, %%xmm1\n\t"
+      "movups\t%%xmm0, (%0)\n\t"
+      "movups\t%%xmm1, 16(%0)\n\t"
+      "add\t$32, %0\n\t"
+      "sub\t$8, %1\n\t"
+      "jnz\t1b"
+      : "+r" (mem), "+r" (k)
+      : "m" (f)
+      : "xmm0", "xmm1", "xmm7", "cc", "memory");
+  }
+  for (i = 0; i < (n & 7); i++)
+    mem[i] *= f;
+}
+
+/* 1 equalizer sample, all bands. y: channel state, dx: x[n] - x[n-2]. */
+static inline float ao_eq_sample_sse (const ao_eq_float_t *eq, float *y, float dx) {
+  float out;
+#define EQ_SSE_VEC(o) \
+    "movaps\t" #o "(%1), %%xmm1\n\t" \
+    "movaps\t" #o "+48(%1), %%xmm2\n\t" \
+    "movaps\t%%xmm1, " #o "+48(%1)\n\t" \
+    "mulps\t" #o "+96(%2), %%xmm2\n\t" \
+    "mulps\t" #o "+48(%2), %%xmm1\n\t" \
+    "movaps\t" #o "(%2), %%xmm3\n\t" \
+    "mulps\t%%xmm0, %%xmm3\n\t" \
+    "addps\t%%xmm1, %%xmm3\n\t" \
+    "subps\t%%xmm2, %%xmm3\n\t" \
+    "movaps\t%%xmm3, " #o "(%1)\n\t" \
+    "mulps\t" #o "+144(%2), %%xmm3\n\t" \
+    "addps\t%%xmm3, %%xmm7\n\t"
+  __asm__ __volatile__ (
+    "movss\t%3, %%xmm0\n\t"
+    "shufps\t$0, %%xmm0, %%xmm0\n\t"
+    "xorps\t%%xmm7, %%xmm7\n\t"
+    EQ_SSE_VEC(0)
+    EQ_SSE_VEC(16)
+    EQ_SSE_VEC(32)
+    "movhlps\t%%xmm7, %%xmm1\n\t"
+    "addps\t%%xmm1, %%xmm7\n\t"
+    "movaps\t%%xmm7, %%xmm1\n\t"
+    "shufps\t$0x55, %%xmm1, %%xmm1\n\t"
+    "addss\t%%xmm1, %%xmm7\n\t"
+    "movss\t%%xmm7, %0"
+    : "=m" (out)
+    : "r" (y), "r" (eq), "m" (dx)
+    : "xmm0", "xmm1", "xmm2", "xmm3", "xmm7", "memory");
+#undef EQ_SSE_VEC
+  return out;
+}
+
+static void audio_filter_equalize_sse2 (aos_t *this, int16_t *data, int num_frames) {
+  ao_eq_float_t *eq = this->eq_float;
+  int num_channels, channel;
+
+  num_channels = this->in_channels;
+  if ((num_channels <= 0) || !eq)
+    return;
+  if (num_channels > EQ_CHANNELS)
+    num_channels = EQ_CHANNELS;
+
+  for (channel = 0; channel < num_channels; channel++) {
+    float x1 = eq->ch[channel].x1, x2 = eq->ch[channel].x2;
+    int16_t *d = data + channel;
+    int i;
+
+    for (i = 0; i < num_frames; i++) {
+      float in = *d;
+      int v = lrintf (ao_eq_sample_sse (eq, eq->ch[channel].y1, in - x2));
+      x2 = x1;
+      x1 = in;
+      *d = v > INT16_MAX ? INT16_MAX : v < INT16_MIN ? INT16_MIN : v;
+      d += this->in_channels;
+    }
+    eq->ch[channel].x1 = x1;
+    eq->ch[channel].x2 = x2;
+  }
+}
+
+static void audio_filter_equalize_float_sse (aos_t *this, float *data, int num_frames) {
+  ao_eq_float_t *eq = this->eq_float;
+  int num_channels, channel;
+
+  num_channels = this->in_channels;
+  if ((num_channels <= 0) || !eq)
+    return;
+  if (num_channels > EQ_CHANNELS)
+    num_channels = EQ_CHANNELS;
+
+  for (channel = 0; channel < num_channels; channel++) {
+    float x1 = eq->ch[channel].x1, x2 = eq->ch[channel].x2;
+    float *d = data + channel;
+    int i;
+
+    for (i = 0; i < num_frames; i++) {
+      float in = *d;
+      *d = ao_eq_sample_sse (eq, eq->ch[channel].y1, in - x2);
+      x2 = x1;
+      x1 = in;
+      d += this->in_channels;
+    }
+    eq->ch[channel].x1 = x1;
+    eq->ch[channel].x2 = x2;
+  }
+}
+
+static void audio_filter_compress_sse2 (aos_t *this, int16_t *mem, int num_frames) {
+  int n = num_frames * this->in_channels, maxs;
+
+  if (n <= 0)
+    return;
+  maxs = ao_s16_absmax_sse2 (mem, n);
+  if (maxs > 0)
+    audio_filter_compress_update (this, 32767.0 / maxs);
+  /* 0.98 to avoid overflow */
+  ao_s16_scale_sse2 (mem, n, 0.98 * this->compression_factor * this->amp_factor);
+}
+
+static void audio_filter_compress_float_sse (aos_t *this, float *mem, int num_frames) {
+  int n = num_frames * this->in_channels;
+  float maxs;
+
+  if (n <= 0)
+    return;
+  maxs = ao_float_absmax_sse (mem, n);
+  if (maxs > 0.0f)
+    audio_filter_compress_update (this, 1.0 / maxs);
+  ao_float_scale_sse (mem, n, 0.98 * this->compression_factor * this->amp_factor);
+}
+
+static void audio_filter_amp_sse2 (aos_t *this, void *buf, int num_frames) {
+  int n = num_frames * this->in_channels;
+
+  /* the C version handles mute, and lowers amp_factor when clipping. */
+  if ((n > 0) && !this->amp_mute && (this->amp_factor != 0)) {
+    if (this->input.bits == 16) {
+      if (ao_s16_absmax_sse2 ((int16_t *)buf, n) * this->amp_factor <= INT16_MAX) {
+        ao_s16_scale_sse2 ((int16_t *)buf, n, this->amp_factor);
+        return;
+      }
+    } else if (this->input.bits == 32) {
+      if (ao_float_absmax_sse ((float *)buf, n) * this->amp_factor <= 1.0) {
+        ao_float_scale_sse ((float *)buf, n, this->amp_factor);
+        return;
+      }
+    }
+  }
+  audio_filter_amp (this, buf, num_frames);
+}
+#endif /* ARCH_X86 */
+
+struct ao_filter_method_s {
+  char      name[8];
+  uint32_t  cpu_require;
+  void    (*equalize) (aos_t *this, int16_t *data, int num_frames);
+  void    (*compress) (aos_t *this, int16_t *mem, int num_frames);
+  void    (*amp) (aos_t *this, void *buf, int num_frames);
+  void    (*equalize_float) (aos_t *this, float *data, int num_frames);
+  void    (*compress_float) (aos_t *this, float *mem, int num_frames);
+};
+
+static const ao_filter_method_t ao_filter_methods[] = {
+  { "C", 0,
+    audio_filter_equalize, audio_filter_compress, audio_filter_amp,
+    audio_filter_equalize_float, audio_filter_compress_float },
+#if defined(ARCH_X86) && !defined(_MSC_VER)
+  { "SSE2", MM_ACCEL_X86_SSE2,
+    audio_filter_equalize_sse2, audio_filter_compress_sse2, audio_filter_amp_sse2,
+    audio_filter_equalize_float_sse, audio_filter_compress_float_sse },
+#endif
+};
+
+#define AO_FILTER_METHODS (sizeof (ao_filter_methods) / sizeof (ao_filter_methods[0]))
+
+/* time all usable filter methods, and return the fastest one.
+ * this runs on a copy of the port with its current filter settings,
+ * so the live equalizer history stays untouched. */
+static int ao_filter_probe (aos_t *this) {
+  aos_t *test;
+  int16_t *s16;
+  float *f32;
+  uint32_t accel = xine_mm_accel ();
+  unsigned int m;
+  int i, j, nbest = 0, tbest = 0;
+
+  if (this->filter_probe >= 0)
+    return this->filter_probe;
+
+  test = malloc (sizeof (*test));
+  s16 = malloc (2 * 4096 * sizeof (*s16));
+  f32 = malloc (2 * 4096 * sizeof (*f32));
+  if (test) {
+    memcpy (test, this, sizeof (*test));
+    test->eq_float = xine_mallocz_aligned (sizeof (*test->eq_float));
+  }
+  if (!test || !test->eq_float || !s16 || !f32) {
+    if (test)
+      xine_free_aligned (test->eq_float);
+    free (test);
+    free (s16);
+    free (f32);
+    return 0;
+  }
+  if (this->eq_float)
+    memcpy (test->eq_float, this->eq_float, sizeof (*test->eq_float));
+  memset (test->eq_data_history, 0, sizeof (test->eq_data_history));
+  memset (test->eq_float->ch, 0, sizeof (test->eq_float->ch));
+  /* the port may not be open yet. */
+  test->in_channels = 2;
+  if (test->compression_factor_max < 1.0)
+    test->compression_factor_max = 2.0;
+  test->compression_factor = test->compression_factor_max;
+  test->amp_mute = 0;
+
+  xprintf (&this->xine->x, XINE_VERBOSITY_LOG,
+    _("audio_out: benchmarking filter methods (smaller is better):\n"));
+  for (m = 0; m < AO_FILTER_METHODS; m++) {
+    const ao_filter_method_t *f = &ao_filter_methods[m];
+    struct timespec ts1 = {0, 0}, ts2 = {0, 0};
+    int t;
+
+    if ((accel & f->cpu_require) != f->cpu_require)
+      continue;
+    xine_gettime (&ts1);
+    for (j = 0; j < 20; j++) {
+      for (i = 0; i < 2 * 4096; i++) {
+        s16[i] = ((i * 7919) & 0x3fff) - 0x2000;
+        f32[i] = (float)s16[i] * (1.0f / 32768.0f);
+      }
+      test->amp_factor = 0.9;
+      test->input.bits = 16;
+      f->equalize (test, s16, 4096);
+      f->compress (test, s16, 4096);
+      f->amp (test, s16, 4096);
+      test->input.bits = 32;
+      f->equalize_float (test, f32, 4096);
+      f->compress_float (test, f32, 4096);
+      f->amp (test, f32, 4096);
+    }
+    xine_gettime (&ts2);
+    t = (ts2.tv_sec - ts1.tv_sec) * 1000000 + (ts2.tv_nsec - ts1.tv_nsec) / 1000;
+    xprintf (&this->xine->x, XINE_VERBOSITY_LOG, "\t%s: %d us\n", f->name, t);
+    if ((m == 0) || (t < tbest)) {
+      tbest = t;
+      nbest = m;
+    }
+  }
+
+  xine_free_aligned (test->eq_float);
+  free (test);
+  free (s16);
+  free (f32);
+  this->filter_probe = nbest;
+  return nbest;
+}
+
+static void ao_update_filter_method (void *this_gen, xine_cfg_entry_t *entry) {
+  aos_t *this = (aos_t *)this_gen;
+  uint32_t accel = xine_mm_accel ();
+  int method = entry->num_value;
+
+  /* 0 == probe */
+  if ((method > 0) && ((unsigned int)method <= AO_FILTER_METHODS)
+    && ((accel & ao_filter_methods[method - 1].cpu_require) == ao_filter_methods[method - 1].cpu_require)) {
+    /* a switch while playing may give a little click from the equalizer. */
+    this->filters = &ao_filter_methods[method - 1];
+    xprintf (&this->xine->x, XINE_VERBOSITY_DEBUG,
+      "audio_out: using \"%s\" filters.\n", this->filters->name);
+    return;
+  }
+  this->filters = &ao_filter_methods[0];
+  this->xine->x.config->update_num (this->xine->x.config,
+    "engine.performance.audio_filter_method", ao_filter_probe (this) + 1);
+}
+
+static audio_buffer_t *prepare_samples_float (aos_t *this, audio_buffer_t *buf) {
+  xine_resampler_t *resampler;
+  int num_output_frames;
+
+  /*
+   * volume / compressor / equalizer filter
+   */
+
+  if (this->amp_factor == 0) {
+    if (this->do_amp)
+      audio_filter_amp (this, buf->mem, buf->num_frames);
+  } else {
+    if (this->do_equ)
+      this->filters->equalize_float (this, (float *)buf->mem, buf->num_frames);
+    if (this->do_compress)
+      this->filters->compress_float (this, (float *)buf->mem, buf->num_frames);
+    if (this->do_amp)
+      this->filters->amp (this, buf->mem, buf->num_frames);
+  }
+
+  /*
+   * resample and output audio data
+   */
+
+  num_output_frames = ao_output_frames (this, buf->num_frames);
+
+  /* there is no linear float resampler. */
+  resampler = ao_get_resampler (this, this->resample_quality ? this->resample_quality : XINE_RESAMPLE_QUALITY_FAST);
+  if (resampler) {
+    if (this->resample_sync_method || this->do_resample) {
+      ensure_buffer_size (this->frame_buf[1], 4 * this->in_channels, num_output_frames);
+      _x_audio_out_resampler_float (resampler, (float *)buf->mem, buf->num_frames,
+        (float *)this->frame_buf[1]->mem, num_output_frames);
+      buf = swap_frame_buffers (this);
+    } else {
+      _x_audio_out_resampler_float (resampler, (float *)buf->mem, buf->num_frames, NULL, 0);
+    }
+  }
+
+  /* mode conversion */
+  if ((this->input.mode == AO_CAP_MODE_MONO) && (this->output.mode == AO_CAP_MODE_STEREO)) {
+    ensure_buffer_size (this->frame_buf[1], 4 * 2, buf->num_frames);
+    _x_audio_out_resample_monotostereo_float ((float *)buf->mem, (float *)this->frame_buf[1]->mem,
+      buf->num_frames);
+    buf = swap_frame_buffers (this);
+  } else if ((this->input.mode == AO_CAP_MODE_STEREO) && (this->output.mode == AO_CAP_MODE_MONO)) {
+    ensure_buffer_size (this->frame_buf[1], 4, buf->num_frames);
+    _x_audio_out_resample_stereotomono_float ((float *)buf->mem, (float *)this->frame_buf[1]->mem,
+      buf->num_frames);
+    buf = swap_frame_buffers (this);
+  }
+
+  /* driver does not take floats. */
+  if (this->output.bits == 16) {
+    int samples = this->out_channels * buf->num_frames;
+    ensure_buffer_size (this->frame_buf[1], 2 * this->out_channels, buf->num_frames);
+    _x_audio_out_resample_floattos16 ((float *)buf->mem, this->frame_buf[1]->mem, samples);
+    buf = swap_frame_buffers (this);
+  } else if (this->output.bits == 24) {
+    int samples = this->out_channels * buf->num_frames;
+    ensure_buffer_size (this->frame_buf[1], 3 * this->out_channels, buf->num_frames);
+    _x_audio_out_resample_floattos24 ((float *)buf->mem, (uint8_t *)this->frame_buf[1]->mem, samples);
+    buf = swap_frame_buffers (this);
+  }
+  return buf;
+}
+
 static audio_buffer_t* prepare_samples( aos_t *this, audio_buffer_t *buf) {
-  double          acc_output_frames;
   int             num_output_frames ;
+  xine_resampler_t *resampler;
+
+  if (this->input.bits == 32)
+    return prepare_samples_float (this, buf);
 
   /*
    * volume / compressor / equalizer filter
@@ -1487,11 +2137,11 @@ static audio_buffer_t* prepare_samples( aos_t *this, audio_buffer_t *buf) {
       audio_filter_amp (this, buf->mem, buf->num_frames);
   } else if (this->input.bits == 16) {
     if (this->do_equ)
-      audio_filter_equalize (this, buf->mem, buf->num_frames);
+      this->filters->equalize (this, buf->mem, buf->num_frames);
     if (this->do_compress)
-      audio_filter_compress (this, buf->mem, buf->num_frames);
+      this->filters->compress (this, buf->mem, buf->num_frames);
     if (this->do_amp)
-      audio_filter_amp (this, buf->mem, buf->num_frames);
+      this->filters->amp (this, buf->mem, buf->num_frames);
   } else if (this->input.bits == 8) {
     if (this->do_amp)
       audio_filter_amp (this, buf->mem, buf->num_frames);
@@ -1502,20 +2152,7 @@ static audio_buffer_t* prepare_samples( aos_t *this, audio_buffer_t *buf) {
    * resample and output audio data
    */
 
-  /* calculate number of output frames (after resampling) */
-  acc_output_frames = (double) buf->num_frames * this->frame_rate_factor
-    * this->resample_sync_factor + this->output_frame_excess;
-
-  /* Truncate to an integer */
-  num_output_frames = acc_output_frames;
-
-  /* Keep track of the amount truncated */
-  this->output_frame_excess = acc_output_frames - (double) num_output_frames;
-  if ( this->output_frame_excess != 0 &&
-       !this->do_resample && !this->resample_sync_method)
-    this->output_frame_excess = 0;
-
-  lprintf ("outputting %d frames\n", num_output_frames);
+  num_output_frames = ao_output_frames (this, buf->num_frames);
 
   /* convert 8 bit samples as needed */
   if ( this->input.bits == 8 &&
@@ -1528,6 +2165,20 @@ static audio_buffer_t* prepare_samples( aos_t *this, audio_buffer_t *buf) {
     buf = swap_frame_buffers(this);
   }
 
+  /* polyphase resampler. unlike linear interpolation, it delays the signal by
+   * a few frames. run it even when frame counts match, to avoid jumps. */
+  resampler = ao_get_resampler (this, this->resample_quality);
+  if (resampler) {
+    if (this->resample_sync_method || this->do_resample) {
+      ensure_buffer_size (this->frame_buf[1], 2 * this->in_channels, num_output_frames);
+      _x_audio_out_resampler_s16 (resampler, buf->mem, buf->num_frames,
+        this->frame_buf[1]->mem, num_output_frames);
+      buf = swap_frame_buffers (this);
+    } else {
+      /* keep history in case we need it */
+      _x_audio_out_resampler_s16 (resampler, buf->mem, buf->num_frames, NULL, 0);
+    }
+  } else
   /* check if resampling may be skipped */
   if ( (this->resample_sync_method || this->do_resample) &&
        buf->num_frames != num_output_frames ) {
@@ -1763,6 +2414,15 @@ static int ao_update_resample_factor (aos_t *this);
  * 4) Do drop, 0-fill or output samples.
  * 5) Go round loop again.
  */
+/* latency tracer: count a dropped buf, late by that many pts. */
+static void ao_trace_drop (xine_stream_private_t *stream, int64_t late) {
+  if (!stream || (&stream->s == XINE_ANON_STREAM))
+    return;
+  stream = stream->side_streams[0];
+  if (stream->latency.enabled)
+    xine_latency_add (stream, XINE_LATENCY_AUDIO_DROP, late * 100 / 9);
+}
+
 static void *ao_loop (void *this_gen) {
 
   aos_t *this = (aos_t *) this_gen;
@@ -1782,6 +2442,7 @@ static void *ao_loop (void *this_gen) {
     int64_t         gap;
     int             delay;
     int             drop = 0;
+    int             freerun = 0;
 
     /* handle buf */
     do {
@@ -1824,7 +2485,16 @@ static void *ao_loop (void *this_gen) {
         ao_update_resample_factor (this);
       }
 
-      if ((this->rp.speed == XINE_SPEED_PAUSE) ||
+      /* free running clock: no wall time sync, just wait for the other
+       * outputs to catch up with this buf, then write it out right away.
+       * flush, speed change and exit kick us out of the wait. */
+      if ((this->rp.freerun_client >= 0) && (this->rp.speed != XINE_SPEED_PAUSE)
+        && this->clock->get_option (this->clock, CLOCK_FREE_RUN)) {
+        cur_time = xine_freerun_want (this->clock, this->rp.freerun_client, in_buf->vpts, -1);
+        if (in_buf->vpts > cur_time)
+          continue;
+        freerun = 1;
+      } else if ((this->rp.speed == XINE_SPEED_PAUSE) ||
          ((this->rp.speed != XINE_FINE_SPEED_NORMAL) && !this->rp.trick)) {
 
         cur_time = this->clock->get_current_time (this->clock);
@@ -1832,6 +2502,7 @@ static void *ao_loop (void *this_gen) {
         if ((this->rp.speed != XINE_SPEED_PAUSE) || this->step) {
           if (in_buf->vpts < cur_time) {
             this->dropped++;
+            ao_trace_drop (stream, cur_time - in_buf->vpts);
             drop = 1;
             break;
           }
@@ -2003,10 +2674,32 @@ static void *ao_loop (void *this_gen) {
       /* no sound card should delay more than 23.301s ;-) */
       delay = ((uint32_t)delay * this->out_pts_per_kframe) >> 10;
       this->pts_in_driver = delay;
+      /* device has enough for now. instead of blocking inside driver write (),
+       * sleep until it runs down to half the wanted fill, then top it up with
+       * several bufs in a row. a flush or stop will still wake us. */
+      if (delay > this->driver_buffer)
+        this->rp.driver_fill = 0;
+      if (!freerun && this->driver_buffer && !this->rp.driver_fill && (this->rp.speed > 0)) {
+        int wait = (int)delay - (this->driver_buffer >> 1);
+        this->rp.driver_fill = 1;
+        if (wait > 0)
+          wait = xine_uint_mul_div (wait, XINE_FINE_SPEED_NORMAL, this->rp.speed) / 90;
+        if (wait > 0) {
+          xine_gettime (&this->out_fifo.wake_time);
+          this->out_fifo.use_wake_time = 1;
+          this->out_fifo.wake_time.tv_sec  +=  wait / 1000;
+          this->out_fifo.wake_time.tv_nsec += (wait % 1000) * 1000000;
+          if (this->out_fifo.wake_time.tv_nsec >= 1000000000) {
+            this->out_fifo.wake_time.tv_nsec -= 1000000000;
+            this->out_fifo.wake_time.tv_sec  += 1;
+          }
+          continue;
+        }
+      }
       /* External A52 decoder delay correction (in pts) */
       delay += this->ptoffs;
       /* calculate gap: */
-      gap = in_buf->vpts - cur_time - delay;
+      gap = freerun ? 0 : in_buf->vpts - cur_time - delay;
       this->last_gap = gap;
       lprintf ("now=%" PRId64 ", buffer_vpts=%" PRId64 ", gap=%" PRId64 "\n", cur_time, in_buf->vpts, gap);
 
@@ -2027,6 +2720,7 @@ static void *ao_loop (void *this_gen) {
         /* drop late buf */
         this->last_sgap = 0;
         this->dropped++;
+        ao_trace_drop (stream, -gap);
         drop = 1;
         ao_gap_ring_reset (this);
 
@@ -2182,6 +2876,9 @@ static void *ao_loop (void *this_gen) {
     ao_driver_test_intr (this);
   }
 
+  /* let the other outputs go on without us. */
+  xine_freerun_want (this->clock, this->rp.freerun_client, XINE_FREERUN_IDLE, 0);
+
   if (in_buf)
     ao_free_fifo_append (this, in_buf);
 
@@ -2323,6 +3020,7 @@ static int ao_update_resample_factor(aos_t *this) {
   if (this->do_resample)
     xprintf (&this->xine->x, XINE_VERBOSITY_DEBUG,
       "audio_out: will resample audio from %u to %d.\n", eff_input_rate, this->output.rate);
+  this->resample_in_rate = eff_input_rate;
 
   this->small_gap = this->gap_tolerance;
   this->frame_rate_factor = ((double)(this->output.rate)) / ((double)(this->input.rate));
@@ -2355,6 +3053,9 @@ static int ao_change_settings (aos_t *this, xine_stream_t *stream, uint32_t bits
     this->driver.d->close (this->driver.d);
   this->driver.open = 0;
 
+  /* float equalizer history is in input units. */
+  if ((this->input.bits != bits) && this->eq_float)
+    memset (this->eq_float->ch, 0, sizeof (this->eq_float->ch));
   this->input.mode = mode;
   this->input.rate = rate;
   this->input.bits = bits;
@@ -2367,6 +3068,11 @@ static int ao_change_settings (aos_t *this, xine_stream_t *stream, uint32_t bits
       xprintf (&this->xine->x, XINE_VERBOSITY_LOG,
                _("8 bits not supported by driver, converting to 16 bits.\n"));
     }
+    if ((this->input.bits == 32) && !(caps & AO_CAP_FLOAT32)) {
+      bits = (caps & AO_CAP_24BITS) ? 24 : 16;
+      xprintf (&this->xine->x, XINE_VERBOSITY_LOG,
+               _("float not supported by driver, converting to %d bits.\n"), (int)bits);
+    }
     /* provide mono->stereo and stereo->mono conversions */
     if ((this->input.mode == AO_CAP_MODE_MONO) && !(caps & AO_CAP_MODE_MONO)) {
       mode = AO_CAP_MODE_STEREO;
@@ -2615,9 +3321,12 @@ static void ao_exit(xine_audio_port_t *this_gen) {
     pthread_mutex_lock (&this->out_fifo.mutex);
     pthread_cond_signal (&this->out_fifo.not_empty);
     pthread_mutex_unlock (&this->out_fifo.mutex);
+    ao_freerun_kick (this);
 
     pthread_join (this->audio_thread, &p);
   }
+  xine_freerun_unregister (this->clock, this->rp.freerun_client);
+  this->rp.freerun_client = -1;
 
   if (!this->grab_only) {
     ao_driver_t *driver;
@@ -2667,7 +3376,9 @@ static void ao_exit(xine_audio_port_t *this_gen) {
 
   _x_freep (&this->frame_buf[0]->mem);
   _x_freep (&this->frame_buf[1]->mem);
+  _x_audio_out_resampler_delete (&this->resampler);
   xine_freep_aligned (&this->base_samp);
+  xine_freep_aligned (&this->eq_float);
 
   free (this);
 }
@@ -2852,6 +3563,7 @@ static int ao_set_property (xine_audio_port_t *this_gen, int property, int value
       this->out_fifo.discard_buffers++;
       ret = this->out_fifo.discard_buffers;
       pthread_cond_signal (&this->out_fifo.not_empty);
+      ao_freerun_kick (this);
       if (this->grab_only) {
         /* discard buffers here because we have no output thread. */
         ao_out_fifo_manual_flush (this);
@@ -2996,6 +3708,12 @@ static void ao_update_av_sync_method(void *this_gen, xine_cfg_entry_t *entry) {
   this->resample_sync_info.valid = 0;
 }
 
+static void ao_update_resample_quality (void *this_gen, xine_cfg_entry_t *entry) {
+  aos_t *this = (aos_t *)this_gen;
+  /* audio thread will pick this up. */
+  this->resample_quality = entry->num_value;
+}
+
 static void ao_update_av_fine_sync_method (void *this_gen, xine_cfg_entry_t *entry) {
   aos_t *this = (aos_t *)this_gen;
   pthread_mutex_lock (&this->out_fifo.mutex);
@@ -3009,6 +3727,11 @@ static void ao_update_ptoffs (void *this_gen, xine_cfg_entry_t *entry) {
   this->ptoffs = (this->output.mode == AO_CAP_MODE_A52) || (this->output.mode == AO_CAP_MODE_AC5) ? this->passthrough_offset : 0;
 }
 
+static void ao_update_driver_buffer (void *this_gen, xine_cfg_entry_t *entry) {
+  aos_t *this = (aos_t *)this_gen;
+  this->driver_buffer = entry->num_value > 0 ? entry->num_value * 90 : 0;
+}
+
 static void ao_update_slow_fast (void *this_gen, xine_cfg_entry_t *entry) {
   aos_t *this = (aos_t *)this_gen;
   this->driver.trick = entry->num_value;
@@ -3043,6 +3766,9 @@ xine_audio_port_t *_x_ao_new_port (xine_t *xine, ao_driver_t *driver,
   this->do_amp                 = 0;
   this->amp_mute               = 0;
   this->do_equ                 = 0;
+  this->resampler              = NULL;
+  this->resample_in_rate       = 0;
+  this->eq_float               = NULL;
   this->eq_settings[0]         = 0;
   this->eq_settings[1]         = 0;
   this->eq_settings[2]         = 0;
@@ -3071,6 +3797,8 @@ xine_audio_port_t *_x_ao_new_port (xine_t *xine, ao_driver_t *driver,
   this->rp.seek_count2  = -1;
   this->rp.seek_count3  = -1;
   this->rp.seek_count_n = -1;
+  this->rp.freerun_client = -1;
+  this->filter_probe      = -1;
 
   this->driver.d     = driver;
   this->xine         = (xine_private_t *)xine;
@@ -3165,6 +3893,44 @@ xine_audio_port_t *_x_ao_new_port (xine_t *xine, ao_driver_t *driver,
       20, NULL, NULL);
   }
 
+  this->eq_float = xine_mallocz_aligned (sizeof (*this->eq_float));
+  if (this->eq_float) {
+    int i;
+    for (i = 0; i < EQ_BANDS; i++) {
+      this->eq_float->alpha[i] = (float)iir_cf[i].alpha * (1.0f / (float)(1 << FP_FRBITS));
+      this->eq_float->beta[i]  = (float)iir_cf[i].beta  * (1.0f / (float)(1 << FP_FRBITS));
+      this->eq_float->gamma[i] = (float)iir_cf[i].gamma * (1.0f / (float)(1 << FP_FRBITS));
+    }
+  }
+
+  {
+    static const char *const filter_methods[] = {"probe", "C",
+#if defined(ARCH_X86) && !defined(_MSC_VER)
+      "SSE2",
+#endif
+      NULL};
+    xine_cfg_entry_t entry;
+    entry.num_value = config->register_enum (
+      config, "engine.performance.audio_filter_method", 0, (char **)filter_methods,
+      _("audio filter implementation"),
+      _("Volume amplification, compressor and equalizer can use SIMD cpu features. "
+        "Usually, the best method is detected automatically."),
+      20, ao_update_filter_method, this);
+    ao_update_filter_method (this, &entry);
+  }
+
+  {
+    static const char *const resample_qualities[] = {"linear", "fast", "good", "best", NULL};
+    this->resample_quality = config->register_enum (
+      config, "audio.synchronization.resample_quality", XINE_RESAMPLE_QUALITY_GOOD,
+      (char **)resample_qualities,
+      _("resampling quality"),
+      _("linear: cheapest, but adds audible aliasing.\n"
+        "fast, good, best: band limited filters with 16, 32 or 64 taps. "
+        "These delay sound by some 8, 16 or 32 frames."),
+      20, ao_update_resample_quality, this);
+  }
+
   this->force_rate = config->register_num (
     config, "audio.synchronization.force_rate", 0,
     _("always resample to this rate (0 to disable)"),
@@ -3181,6 +3947,17 @@ xine_audio_port_t *_x_ao_new_port (xine_t *xine, ao_driver_t *driver,
       "The unit of the value is one PTS tick, which is the 90000th part of a second."),
     10, ao_update_ptoffs, this);
 
+  {
+    int ms = config->register_num (
+      config, "audio.synchronization.driver_buffer", 200,
+      _("audio driver buffer fill (ms)"),
+      _("Hand audio to the sound card when it has no more than this many milliseconds "
+        "left to play, and sleep until then. Smaller values make flush and pause react "
+        "faster, but may drop out on a busy system. 0 lets the driver decide."),
+      20, ao_update_driver_buffer, this);
+    this->driver_buffer = ms > 0 ? ms * 90 : 0;
+  }
+
   this->driver.trick = this->rp.trick = config->register_bool (
     config, "audio.synchronization.slow_fast_audio", 0,
     _("play audio even on slow/fast speeds"),
@@ -3272,6 +4049,8 @@ xine_audio_port_t *_x_ao_new_port (xine_t *xine, ao_driver_t *driver,
      */
 
     this->audio_loop_running = 1;
+    /* before the thread, others may kick it right away. */
+    this->rp.freerun_client = xine_freerun_register (this->clock);
 
     pthread_attr_init(&pth_attrs);
 #if defined(_POSIX_THREAD_PRIORITY_SCHEDULING) && (_POSIX_THREAD_PRIORITY_SCHEDULING > 0)
@@ -63,10 +63,18 @@
  * buf->free_buffer != buffer_pool_free.
  */
 
+/* latency tracer stamps in monotonic microseconds, 0 if not traced.
+ * see XINE_PARAM_LATENCY_TRACE. */
+typedef struct {
+  int64_t input; /* buf allocated (input read) */
+  int64_t queue; /* buf put to fifo */
+} buf_trace_t;
+
 typedef struct {
   buf_element_t elem; /* needs to be first */
   int nbufs;          /* # of contigous bufs */
   extra_info_t  ei;
+  buf_trace_t   trace;
 } be_ei_t;
 
 #define LARGE_NUM 0x7fffffff
@@ -202,23 +210,305 @@ static void buffer_pool_free (buf_element_t *element) {
   pthread_mutex_unlock (&this->buffer_pool_mutex);
 }
 
-/*
- * allocate a buffer from buffer pool
- */
+/* The large buffer slabs.
+ * Chained pool bufs are limited to a fraction of the pool, and they tend to
+ * fragment it. Thus, buffer_pool_size_alloc () serves large requests (think
+ * of a 4K keyframe) from a few separate contiguous bufs of fixed size classes.
+ * These are allocated on demand, and kept on per class free lists while the
+ * cached total stays below SLAB_CACHE_SIZE. When a class is used up, we try
+ * the next larger one, and finally fall back to the pool.
+ * A slab buf still counts as the pool bufs it replaces, and its max_size is
+ * cut down to these. So buffer_pool_num_free, fifo_size and the demuxer
+ * backpressure stay the same as without slabs.
+ * Slab bufs are custom bufs to the rest of the fifo code, and bufs still out
+ * at dispose time will free themselves later. */
 
-static buf_element_t *buffer_pool_size_alloc_int (fifo_buffer_t *this, int n) {
+#define SLAB_MIN_BUFS 8
+#define SLAB_HEAD_SIZE ((sizeof (slab_buf_t) + 63) & ~(size_t)63)
+#define SLAB_CACHE_SIZE (4 << 20)
+
+static const uint32_t slab_sizes[FIFO_SLAB_CLASSES] = {64 << 10, 256 << 10, 1 << 20, 4 << 20};
+static const uint32_t slab_max_bufs[FIFO_SLAB_CLASSES] = {16, 8, 4, 2};
+
+typedef struct fifo_slab_pool_s fifo_slab_pool_t;
+
+typedef struct {
+  buf_element_t     elem; /* needs to be first */
+  extra_info_t      ei;
+  buf_trace_t       trace;
+  fifo_slab_pool_t *pool;
+  int               class;
+  int               units; /* # of pool bufs accounted for this */
+} slab_buf_t;
+
+struct fifo_slab_pool_s {
+  fifo_buffer_t    *fifo;
+  pthread_mutex_t   mutex;
+  int               in_use;
+  int               disposed;
+  uint32_t          free_size; /* bytes on the free lists */
+  buf_element_t    *free[FIFO_SLAB_CLASSES];
+  fifo_slab_stats_t stats[FIFO_SLAB_CLASSES];
+};
+
+/* The private fifo part. */
+typedef struct {
+  fifo_buffer_t     fifo; /* needs to be first */
+  fifo_slab_pool_t *slab_pool;
+  int               trace_latency; /* stamp bufs for the latency tracer */
+  /* tell a consumer that does not wait inside get () about new bufs.
+   * see xine_fifo_set_wake (). */
+  void            (*wake_cb) (void *data);
+  void             *wake_cb_data;
+} fifo_private_t;
+
+/* call with the locks held that xine_fifo_set_wake () takes. */
+static void fifo_wake (fifo_buffer_t *fifo) {
+  fifo_private_t *priv = (fifo_private_t *)fifo;
+  if (priv->wake_cb)
+    priv->wake_cb (priv->wake_cb_data);
+}
+
+static void buffer_slab_free (buf_element_t *element);
+
+/* # of pool bufs a buf stands for in fifo_size. */
+static int buffer_units (buf_element_t *buf) {
+  if (buf->free_buffer == buffer_pool_free)
+    return ((be_ei_t *)buf)->nbufs;
+  if (buf->free_buffer == buffer_slab_free)
+    return ((slab_buf_t *)buf)->units;
+  return 1;
+}
+
+/* custom bufs are not traced. */
+static buf_trace_t *buffer_trace (buf_element_t *buf) {
+  if (buf->free_buffer == buffer_pool_free)
+    return &((be_ei_t *)buf)->trace;
+  if (buf->free_buffer == buffer_slab_free)
+    return &((slab_buf_t *)buf)->trace;
+  return NULL;
+}
+
+static void buffer_trace_alloc (fifo_buffer_t *this, buf_trace_t *trace) {
+  trace->input = ((fifo_private_t *)this)->trace_latency ? xine_trace_now () : 0;
+  trace->queue = 0;
+}
 
+static void buffer_trace_put (fifo_buffer_t *fifo, buf_element_t *element) {
+  if (((fifo_private_t *)fifo)->trace_latency) {
+    buf_trace_t *trace = buffer_trace (element);
+    if (trace)
+      trace->queue = xine_trace_now ();
+  }
+}
+
+void xine_fifo_trace_latency (fifo_buffer_t *fifo, int enable) {
+  if (fifo)
+    ((fifo_private_t *)fifo)->trace_latency = !!enable;
+}
+
+int xine_buf_trace_take (buf_element_t *buf, int64_t *input, int64_t *queue) {
+  buf_trace_t *trace = buffer_trace (buf);
+
+  if (!trace || !trace->queue)
+    return 0;
+  *input = trace->input;
+  *queue = trace->queue;
+  trace->input = 0;
+  trace->queue = 0;
+  return 1;
+}
+
+static fifo_slab_pool_t *buffer_slab_pool_new (fifo_buffer_t *fifo) {
+  fifo_slab_pool_t *pool = calloc (1, sizeof (*pool));
   int i;
-  be_ei_t *buf;
 
-  for (i = 0; this->alloc_cb[i]; i++)
-    this->alloc_cb[i] (this, this->alloc_cb_data[i]);
+  if (!pool)
+    return NULL;
+  pool->fifo = fifo;
+  pthread_mutex_init (&pool->mutex, NULL);
+  for (i = 0; i < FIFO_SLAB_CLASSES; i++) {
+#ifndef HAVE_ZERO_SAFE_MEM
+    pool->free[i] = NULL;
+#endif
+    pool->stats[i].size = slab_sizes[i];
+    pool->stats[i].max_bufs = slab_max_bufs[i];
+  }
+  return pool;
+}
 
-  if (n < 1)
-    n = 1;
-  /* we always keep one free buffer for emergency situations like
-   * decoder flushes that would need a buffer in buffer_pool_try_alloc() */
-  n += 2;
+static void buffer_slab_pool_free (fifo_slab_pool_t *pool) {
+  pthread_mutex_destroy (&pool->mutex);
+  free (pool);
+}
+
+static void buffer_slab_free (buf_element_t *element) {
+  slab_buf_t *buf = (slab_buf_t *)element;
+  fifo_slab_pool_t *pool = buf->pool;
+  int last;
+
+  pthread_mutex_lock (&pool->mutex);
+  pool->in_use--;
+  if (!pool->disposed) {
+    /* fifo dispose waits for pool->mutex. */
+    fifo_buffer_t *fifo = pool->fifo;
+    pthread_mutex_lock (&fifo->buffer_pool_mutex);
+    fbc_sub (fifo, buf->units);
+    fifo->buffer_pool_num_free += buf->units;
+    if (fifo->buffer_pool_num_waiters ||
+      (fifo->buffer_pool_large_wait <= fbc_avail (fifo)))
+      pthread_cond_signal (&fifo->buffer_pool_cond_not_empty);
+    pthread_mutex_unlock (&fifo->buffer_pool_mutex);
+    if (pool->free_size + slab_sizes[buf->class] <= SLAB_CACHE_SIZE) {
+      buf->elem.next = pool->free[buf->class];
+      pool->free[buf->class] = &buf->elem;
+      pool->free_size += slab_sizes[buf->class];
+      pool->stats[buf->class].num_free++;
+      buf = NULL;
+    } else {
+      pool->stats[buf->class].num_bufs--;
+    }
+  }
+  last = pool->disposed && !pool->in_use;
+  pthread_mutex_unlock (&pool->mutex);
+
+  if (buf)
+    xine_free_aligned (buf);
+  if (last)
+    buffer_slab_pool_free (pool);
+}
+
+/* NULL means "please use the pool". */
+static buf_element_t *buffer_slab_alloc (fifo_buffer_t *this, size_t size) {
+  fifo_slab_pool_t *pool = ((fifo_private_t *)this)->slab_pool;
+  slab_buf_t *buf = NULL;
+  int i, new_class = -1;
+
+  if (!pool)
+    return NULL;
+
+  for (i = 0; (i < FIFO_SLAB_CLASSES - 1) && (size > slab_sizes[i]); i++) ;
+
+  pthread_mutex_lock (&pool->mutex);
+  for (; i < FIFO_SLAB_CLASSES; i++) {
+    fifo_slab_stats_t *stats = &pool->stats[i];
+    if (pool->free[i]) {
+      buf = (slab_buf_t *)pool->free[i];
+      pool->free[i] = buf->elem.next;
+      pool->free_size -= slab_sizes[i];
+      stats->num_free--;
+      stats->hits++;
+    } else if (stats->num_bufs < stats->max_bufs) {
+      /* reserve, and allocate outside the lock. */
+      new_class = i;
+      stats->num_bufs++;
+      stats->misses++;
+    } else {
+      stats->fails++;
+      continue;
+    }
+    if (stats->num_bufs - stats->num_free > stats->peak_used)
+      stats->peak_used = stats->num_bufs - stats->num_free;
+    pool->in_use++;
+    break;
+  }
+  pthread_mutex_unlock (&pool->mutex);
+
+  if (new_class >= 0) {
+    buf = xine_malloc_aligned (SLAB_HEAD_SIZE + slab_sizes[new_class]);
+    if (!buf) {
+      int last;
+      pthread_mutex_lock (&pool->mutex);
+      pool->stats[new_class].num_bufs--;
+      pool->stats[new_class].misses--;
+      pool->stats[new_class].fails++;
+      pool->in_use--;
+      last = pool->disposed && !pool->in_use;
+      pthread_mutex_unlock (&pool->mutex);
+      if (last)
+        buffer_slab_pool_free (pool);
+      return NULL;
+    }
+    buf->elem.mem         = (unsigned char *)buf + SLAB_HEAD_SIZE;
+    buf->elem.free_buffer = buffer_slab_free;
+    buf->elem.source      = pool;
+    buf->elem.extra_info  = &buf->ei;
+    buf->pool             = pool;
+    buf->class            = new_class;
+  }
+
+  if (!buf)
+    return NULL;
+
+  buf->units             = 0;
+  buf->elem.next          = NULL;
+  buf->elem.content       = buf->elem.mem;
+  buf->elem.pts           = 0;
+  buf->elem.size          = 0;
+  buf->elem.max_size      = slab_sizes[buf->class];
+  buf->elem.type          = 0;
+  buf->elem.decoder_flags = 0;
+  memset (buf->elem.decoder_info, 0, sizeof (buf->elem.decoder_info));
+  memset (buf->elem.decoder_info_ptr, 0, sizeof (buf->elem.decoder_info_ptr));
+  _x_extra_info_reset (buf->elem.extra_info);
+  buffer_trace_alloc (this, &buf->trace);
+
+  return &buf->elem;
+}
+
+static void buffer_slab_pool_dispose (fifo_buffer_t *this) {
+  fifo_private_t *priv = (fifo_private_t *)this;
+  fifo_slab_pool_t *pool = priv->slab_pool;
+  buf_element_t *list[FIFO_SLAB_CLASSES];
+  int i, last;
+
+  if (!pool)
+    return;
+  priv->slab_pool = NULL;
+
+  pthread_mutex_lock (&pool->mutex);
+  pool->disposed = 1;
+  pool->free_size = 0;
+  for (i = 0; i < FIFO_SLAB_CLASSES; i++) {
+    list[i] = pool->free[i];
+    pool->free[i] = NULL;
+  }
+  last = !pool->in_use;
+  pthread_mutex_unlock (&pool->mutex);
+
+  for (i = 0; i < FIFO_SLAB_CLASSES; i++) {
+    while (list[i]) {
+      buf_element_t *next = list[i]->next;
+      xine_free_aligned (list[i]);
+      list[i] = next;
+    }
+  }
+  if (last)
+    buffer_slab_pool_free (pool);
+}
+
+int _x_fifo_buffer_slab_stats (fifo_buffer_t *fifo, fifo_slab_stats_t *stats, int max_classes) {
+  fifo_slab_pool_t *pool;
+  int n;
+
+  if (!fifo || !stats)
+    return 0;
+  pool = ((fifo_private_t *)fifo)->slab_pool;
+  if (!pool)
+    return 0;
+  n = max_classes < FIFO_SLAB_CLASSES ? max_classes : FIFO_SLAB_CLASSES;
+  if (n <= 0)
+    return 0;
+  pthread_mutex_lock (&pool->mutex);
+  memcpy (stats, pool->stats, n * sizeof (*stats));
+  pthread_mutex_unlock (&pool->mutex);
+  return n;
+}
+
+/*
+ * wait until n pool bufs are available, buffer_pool_mutex held.
+ */
+static void buffer_pool_wait (fifo_buffer_t *this, int n) {
   if (fbc_avail (this) < n) {
     /* Paranoia: someone else than demux calling this in parallel ?? */
     if (this->buffer_pool_large_wait != LARGE_NUM) {
@@ -235,7 +525,25 @@ static buf_element_t *buffer_pool_size_alloc_int (fifo_buffer_t *this, int n) {
       this->buffer_pool_large_wait = LARGE_NUM;
     }
   }
-  n -= 2;
+}
+
+/*
+ * allocate a buffer from buffer pool
+ */
+
+static buf_element_t *buffer_pool_size_alloc_int (fifo_buffer_t *this, int n) {
+
+  int i;
+  be_ei_t *buf;
+
+  for (i = 0; this->alloc_cb[i]; i++)
+    this->alloc_cb[i] (this, this->alloc_cb_data[i]);
+
+  if (n < 1)
+    n = 1;
+  /* we always keep one free buffer for emergency situations like
+   * decoder flushes that would need a buffer in buffer_pool_try_alloc() */
+  buffer_pool_wait (this, n + 2);
 
   buf = (be_ei_t *)this->buffer_pool_top;
   if (n == 1) {
@@ -291,14 +599,55 @@ static buf_element_t *buffer_pool_size_alloc_int (fifo_buffer_t *this, int n) {
   memset (buf->elem.decoder_info, 0, sizeof (buf->elem.decoder_info));
   memset (buf->elem.decoder_info_ptr, 0, sizeof (buf->elem.decoder_info_ptr));
   _x_extra_info_reset (buf->elem.extra_info);
+  buffer_trace_alloc (this, &buf->trace);
+
+  return &buf->elem;
+}
+
+/*
+ * get a slab buf, and account for it like for n pool bufs.
+ * lock order is slab pool before buffer_pool_mutex, call this unlocked.
+ * NULL means "please use the pool".
+ */
+static buf_element_t *buffer_slab_size_alloc (fifo_buffer_t *this, size_t size, int n) {
+  slab_buf_t *buf;
+  int i;
+
+  /* n may be capped already. */
+  if (size > (size_t)n * this->buffer_pool_buf_size)
+    size = (size_t)n * this->buffer_pool_buf_size;
+  buf = (slab_buf_t *)buffer_slab_alloc (this, size);
+
+  if (!buf)
+    return NULL;
+
+  pthread_mutex_lock (&this->buffer_pool_mutex);
+  for (i = 0; this->alloc_cb[i]; i++)
+    this->alloc_cb[i] (this, this->alloc_cb_data[i]);
+  /* same backpressure as for a chained pool buf. */
+  buffer_pool_wait (this, n + 2);
+  this->buffer_pool_num_free -= n;
+  buf->units = n;
+  pthread_mutex_unlock (&this->buffer_pool_mutex);
+
+  /* a larger class may have served this. dont let demux fill more
+   * than it was charged for. */
+  if (buf->elem.max_size > n * this->buffer_pool_buf_size)
+    buf->elem.max_size = n * this->buffer_pool_buf_size;
 
   return &buf->elem;
 }
 
 static buf_element_t *buffer_pool_size_alloc (fifo_buffer_t *this, size_t size) {
   int n = size ? ((int)size + this->buffer_pool_buf_size - 1) / this->buffer_pool_buf_size : 1;
+  int large = n > SLAB_MIN_BUFS;
   if (n > (this->buffer_pool_capacity >> 2))
     n = this->buffer_pool_capacity >> 2;
+  if (large) {
+    buf_element_t *buf = buffer_slab_size_alloc (this, size, n);
+    if (buf)
+      return buf;
+  }
   pthread_mutex_lock (&this->buffer_pool_mutex);
   return buffer_pool_size_alloc_int (this, n);
 }
@@ -342,6 +691,7 @@ static buf_element_t *buffer_pool_alloc (fifo_buffer_t *this) {
   memset (buf->elem.decoder_info, 0, sizeof (buf->elem.decoder_info));
   memset (buf->elem.decoder_info_ptr, 0, sizeof (buf->elem.decoder_info_ptr));
   _x_extra_info_reset (buf->elem.extra_info);
+  buffer_trace_alloc (this, &buf->trace);
 
   return &buf->elem;
 }
@@ -356,6 +706,16 @@ static buf_element_t *buffer_pool_realloc (buf_element_t *buf, size_t new_size)
     return NULL;
   if ((int)new_size <= old_buf->elem.max_size)
     return NULL;
+  if (old_buf->elem.free_buffer == buffer_slab_free) {
+    /* cannot grow, get a buf for the rest. the fifo may be gone already. */
+    fifo_slab_pool_t *pool = ((slab_buf_t *)old_buf)->pool;
+    pthread_mutex_lock (&pool->mutex);
+    this = pool->disposed ? NULL : pool->fifo;
+    pthread_mutex_unlock (&pool->mutex);
+    if (!this)
+      return NULL;
+    return this->buffer_pool_size_alloc (this, new_size - old_buf->elem.max_size);
+  }
   if (old_buf->elem.free_buffer != buffer_pool_free)
     return NULL;
   this = (fifo_buffer_t *)old_buf->elem.source;
@@ -409,6 +769,14 @@ static buf_element_t *buffer_pool_realloc (buf_element_t *buf, size_t new_size)
     return NULL;
   } while (0);
 
+  if (n > SLAB_MIN_BUFS) {
+    pthread_mutex_unlock (&this->buffer_pool_mutex);
+    new_buf = (be_ei_t *)buffer_slab_size_alloc (this, new_size - old_buf->elem.max_size, n);
+    if (new_buf)
+      return &new_buf->elem;
+    pthread_mutex_lock (&this->buffer_pool_mutex);
+  }
+
   return buffer_pool_size_alloc_int (this, n);
 }
 
@@ -444,6 +812,7 @@ static buf_element_t *buffer_pool_try_alloc (fifo_buffer_t *this) {
   memset (buf->elem.decoder_info, 0, sizeof (buf->elem.decoder_info));
   memset (buf->elem.decoder_info_ptr, 0, sizeof (buf->elem.decoder_info_ptr));
   _x_extra_info_reset (buf->elem.extra_info);
+  buffer_trace_alloc (this, &buf->trace);
 
   return &buf->elem;
 }
@@ -460,7 +829,9 @@ static void fifo_buffer_put (fifo_buffer_t *fifo, buf_element_t *element) {
   if (element->decoder_flags & BUF_FLAG_MERGE) {
     be_ei_t *new = (be_ei_t *)element, *prev = (be_ei_t *)fifo->last;
     new->elem.decoder_flags &= ~BUF_FLAG_MERGE;
-    if (prev && (prev + prev->nbufs == new)
+    if (prev && (prev->elem.free_buffer == buffer_pool_free)
+      && (new->elem.free_buffer == buffer_pool_free)
+      && (prev + prev->nbufs == new)
       && (prev->elem.type == new->elem.type)
       && (prev->nbufs < (fifo->buffer_pool_capacity >> 3))) {
       fifo->fifo_size += new->nbufs;
@@ -477,6 +848,8 @@ static void fifo_buffer_put (fifo_buffer_t *fifo, buf_element_t *element) {
   for(i = 0; fifo->put_cb[i]; i++)
     fifo->put_cb[i](fifo, element, fifo->put_cb_data[i]);
 
+  buffer_trace_put (fifo, element);
+
   if (fifo->last)
     fifo->last->next = element;
   else
@@ -485,16 +858,12 @@ static void fifo_buffer_put (fifo_buffer_t *fifo, buf_element_t *element) {
   fifo->last = element;
   element->next = NULL;
 
-  if (element->free_buffer == buffer_pool_free) {
-    be_ei_t *beei = (be_ei_t *)element;
-    fifo->fifo_size += beei->nbufs;
-  } else {
-    fifo->fifo_size += 1;
-  }
+  fifo->fifo_size += buffer_units (element);
   fifo->fifo_data_size += element->size;
 
   if (fifo->fifo_num_waiters)
     pthread_cond_signal (&fifo->not_empty);
+  fifo_wake (fifo);
 
   pthread_mutex_unlock (&fifo->mutex);
 }
@@ -527,16 +896,12 @@ static void fifo_buffer_insert (fifo_buffer_t *fifo, buf_element_t *element) {
   if( !fifo->last )
     fifo->last = element;
 
-  if (element->free_buffer == buffer_pool_free) {
-    be_ei_t *beei = (be_ei_t *)element;
-    fifo->fifo_size += beei->nbufs;
-  } else {
-    fifo->fifo_size += 1;
-  }
+  fifo->fifo_size += buffer_units (element);
   fifo->fifo_data_size += element->size;
 
   if (fifo->fifo_num_waiters)
     pthread_cond_signal (&fifo->not_empty);
+  fifo_wake (fifo);
 
   pthread_mutex_unlock (&fifo->mutex);
 }
@@ -572,12 +937,7 @@ static buf_element_t *fifo_buffer_get (fifo_buffer_t *fifo) {
   if (fifo->first==NULL)
     fifo->last = NULL;
 
-  if (buf->free_buffer == buffer_pool_free) {
-    be_ei_t *beei = (be_ei_t *)buf;
-    fifo->fifo_size -= beei->nbufs;
-  } else {
-    fifo->fifo_size -= 1;
-  }
+  fifo->fifo_size -= buffer_units (buf);
   fifo->fifo_data_size -= buf->size;
 
   for(i = 0; fifo->get_cb[i]; i++)
@@ -627,12 +987,7 @@ static buf_element_t *fifo_buffer_tget (fifo_buffer_t *fifo, xine_ticket_t *tick
   if (fifo->first==NULL)
     fifo->last = NULL;
 
-  if (buf->free_buffer == buffer_pool_free) {
-    be_ei_t *beei = (be_ei_t *)buf;
-    fifo->fifo_size -= beei->nbufs;
-  } else {
-    fifo->fifo_size -= 1;
-  }
+  fifo->fifo_size -= buffer_units (buf);
   fifo->fifo_data_size -= buf->size;
 
   if ((mode & 2) && ticket->ticket_revoked) {
@@ -807,6 +1162,7 @@ static int fifo_buffer_num_free (fifo_buffer_t *this) {
  */
 static void fifo_buffer_dispose (fifo_buffer_t *this) {
   fifo_buffer_all_clear (this);
+  buffer_slab_pool_dispose (this);
   xine_free_aligned (this->buffer_pool_base);
   pthread_mutex_destroy(&this->mutex);
   pthread_cond_destroy(&this->not_empty);
@@ -944,17 +1300,365 @@ static void fifo_unregister_get_cb (fifo_buffer_t *this,
   pthread_mutex_unlock(&this->mutex);
 }
 
+#if (HAVE_ATOMIC_VARS > 0)
+/* The single producer / single consumer (SPSC) fifo.
+ * The classic fifo above takes fifo->mutex for every put and get, and signals
+ * not_empty whenever the decoder waits. With small packets at high rates, demux
+ * and decoder keep bumping into each other there, causing lots of futex calls.
+ * Here, bufs travel through a ring of pointers instead. Producer and consumer
+ * only share the atomic fill counter, and touch fifo->mutex only when the ring
+ * really runs empty or full.
+ * put_mutex serializes the rare extra producers (control bufs sent from other
+ * threads), get_mutex does the same for clear () and insert () vs the decoder.
+ * Both are practically uncontended, and thus dont enter the kernel.
+ * Inserted bufs go to the classic fifo->first list, which is consumed before
+ * the ring. That list is modified with both get_mutex and fifo->mutex held.
+ * put and get callbacks still run with fifo->mutex held, like net_buf_ctrl
+ * expects. fifo->fifo_size and fifo->fifo_data_size are unlocked snapshots
+ * here, fifo->size () and fifo->data_size () give exact values. */
+
+typedef struct {
+  fifo_private_t   priv; /* needs to be first */
+  pthread_mutex_t  put_mutex;
+  pthread_mutex_t  get_mutex;
+  pthread_cond_t   not_full;
+  int              full_waiters;
+  XINE_ATINT_T     fill;      /* # of bufs in ring */
+  XINE_ATINT_T     num_bufs;  /* # of pool bufs in ring and first list */
+  XINE_ATINT_T     data_size;
+  int              mask;
+  int              put_pos;   /* producer private */
+  int              get_pos;   /* consumer private */
+  buf_element_t   *ring[1];
+} fifo_spsc_t;
+
+static void fifo_spsc_count (fifo_spsc_t *this, int n, int size) {
+  XINE_ATFA (this->num_bufs, n);
+  XINE_ATFA (this->data_size, size);
+}
+
+/* producer and consumer both count. let fifo_size and fifo_data_size
+ * follow the counters under fifo->mutex, so the last writer always stores
+ * the current state. net_buf_ctrl reads them from inside its callbacks. */
+static void fifo_spsc_publish (fifo_spsc_t *this) {
+  this->priv.fifo.fifo_size = XINE_ATGET (this->num_bufs);
+  this->priv.fifo.fifo_data_size = XINE_ATGET (this->data_size);
+}
+
+static void fifo_spsc_put (fifo_buffer_t *fifo, buf_element_t *element) {
+  fifo_spsc_t *this = (fifo_spsc_t *)fifo;
+  int i;
+
+  /* the previous buf may already be in use by the consumer. */
+  element->decoder_flags &= ~BUF_FLAG_MERGE;
+  element->next = NULL;
+
+  pthread_mutex_lock (&this->put_mutex);
+
+  if (fifo->put_cb[0]) {
+    pthread_mutex_lock (&fifo->mutex);
+    for (i = 0; fifo->put_cb[i]; i++)
+      fifo->put_cb[i] (fifo, element, fifo->put_cb_data[i]);
+    pthread_mutex_unlock (&fifo->mutex);
+  }
+
+  if (XINE_ATGET (this->fill) > this->mask) {
+    pthread_mutex_lock (&fifo->mutex);
+    this->full_waiters++;
+    while (XINE_ATGET (this->fill) > this->mask)
+      pthread_cond_wait (&this->not_full, &fifo->mutex);
+    this->full_waiters--;
+    pthread_mutex_unlock (&fifo->mutex);
+  }
+
+  buffer_trace_put (fifo, element);
+
+  this->ring[this->put_pos] = element;
+  this->put_pos = (this->put_pos + 1) & this->mask;
+  fifo_spsc_count (this, buffer_units (element), element->size);
+  i = XINE_ATFA (this->fill, 1);
+  pthread_mutex_lock (&fifo->mutex);
+  fifo_spsc_publish (this);
+  /* ring was empty, consumer may be waiting. */
+  if ((i == 0) && fifo->fifo_num_waiters)
+    pthread_cond_signal (&fifo->not_empty);
+  pthread_mutex_unlock (&fifo->mutex);
+  fifo_wake (fifo);
+
+  pthread_mutex_unlock (&this->put_mutex);
+}
+
+/* call with get_mutex held. */
+static buf_element_t *fifo_spsc_pop (fifo_spsc_t *this) {
+  fifo_buffer_t *fifo = &this->priv.fifo;
+  buf_element_t *buf;
+
+  if (fifo->first) {
+    pthread_mutex_lock (&fifo->mutex);
+    buf = fifo->first;
+    fifo->first = buf->next;
+    if (!fifo->first)
+      fifo->last = NULL;
+    fifo_spsc_count (this, -buffer_units (buf), -buf->size);
+    fifo_spsc_publish (this);
+    pthread_mutex_unlock (&fifo->mutex);
+  } else {
+    int full;
+    if (XINE_ATGET (this->fill) <= 0)
+      return NULL;
+    buf = this->ring[this->get_pos];
+    this->get_pos = (this->get_pos + 1) & this->mask;
+    fifo_spsc_count (this, -buffer_units (buf), -buf->size);
+    full = XINE_ATFA (this->fill, -1) > this->mask;
+    pthread_mutex_lock (&fifo->mutex);
+    fifo_spsc_publish (this);
+    /* ring was full, producer may be waiting. */
+    if (full && this->full_waiters)
+      pthread_cond_signal (&this->not_full);
+    pthread_mutex_unlock (&fifo->mutex);
+  }
+
+  buf->next = NULL;
+  return buf;
+}
+
+static buf_element_t *fifo_spsc_tget (fifo_buffer_t *fifo, xine_ticket_t *ticket) {
+  /* see fifo_buffer_tget () for the ticket dance. */
+  fifo_spsc_t *this = (fifo_spsc_t *)fifo;
+  buf_element_t *buf;
+  int mode = ticket ? 2 : 0, i;
+
+  if (pthread_mutex_trylock (&this->get_mutex)) {
+    if (mode & 2) {
+      ticket->release (ticket, 0);
+      mode = 1;
+    }
+    pthread_mutex_lock (&this->get_mutex);
+  }
+
+  while (!(buf = fifo_spsc_pop (this))) {
+    pthread_mutex_unlock (&this->get_mutex);
+    if (mode & 2) {
+      ticket->release (ticket, 0);
+      mode = 1;
+    }
+    pthread_mutex_lock (&fifo->mutex);
+    fifo->fifo_num_waiters++;
+    while (!fifo->first && (XINE_ATGET (this->fill) <= 0))
+      pthread_cond_wait (&fifo->not_empty, &fifo->mutex);
+    fifo->fifo_num_waiters--;
+    pthread_mutex_unlock (&fifo->mutex);
+    pthread_mutex_lock (&this->get_mutex);
+  }
+
+  if ((mode & 2) && ticket->ticket_revoked) {
+    ticket->release (ticket, 0);
+    mode = 1;
+  }
+
+  if (fifo->get_cb[0]) {
+    pthread_mutex_lock (&fifo->mutex);
+    for (i = 0; fifo->get_cb[i]; i++)
+      fifo->get_cb[i] (fifo, buf, fifo->get_cb_data[i]);
+    pthread_mutex_unlock (&fifo->mutex);
+  }
+
+  pthread_mutex_unlock (&this->get_mutex);
+
+  if (mode & 1)
+    ticket->acquire (ticket, 0);
+
+  return buf;
+}
+
+static buf_element_t *fifo_spsc_get (fifo_buffer_t *fifo) {
+  return fifo_spsc_tget (fifo, NULL);
+}
+
+static void fifo_spsc_insert (fifo_buffer_t *fifo, buf_element_t *element) {
+  fifo_spsc_t *this = (fifo_spsc_t *)fifo;
+
+  pthread_mutex_lock (&this->get_mutex);
+  pthread_mutex_lock (&fifo->mutex);
+
+  element->next = fifo->first;
+  fifo->first = element;
+  if (!fifo->last)
+    fifo->last = element;
+  fifo_spsc_count (this, buffer_units (element), element->size);
+  fifo_spsc_publish (this);
+
+  if (fifo->fifo_num_waiters)
+    pthread_cond_signal (&fifo->not_empty);
+  fifo_wake (fifo);
+
+  pthread_mutex_unlock (&fifo->mutex);
+  pthread_mutex_unlock (&this->get_mutex);
+}
+
+static void fifo_spsc_clear (fifo_buffer_t *fifo) {
+  fifo_spsc_t *this = (fifo_spsc_t *)fifo;
+  buf_element_t *keep = NULL, **add = &keep, *last = NULL;
+  int n, nbufs = 0, size = 0;
+
+  pthread_mutex_lock (&this->get_mutex);
+
+  /* take out what is there now, producer may go on meanwhile. */
+  n = XINE_ATGET (this->fill);
+  while (fifo->first || (n-- > 0)) {
+    buf_element_t *buf = fifo_spsc_pop (this);
+    /* keep control bufs (flush, ...) */
+    if ((buf->type & BUF_MAJOR_MASK) == BUF_CONTROL_BASE) {
+      *add = last = buf;
+      add = &buf->next;
+      nbufs += buffer_units (buf);
+      size += buf->size;
+    } else {
+      buf->free_buffer (buf);
+    }
+  }
+
+  pthread_mutex_lock (&fifo->mutex);
+  if (keep) {
+    fifo->first = keep;
+    fifo->last = last;
+    fifo_spsc_count (this, nbufs, size);
+    fifo_spsc_publish (this);
+    if (fifo->fifo_num_waiters)
+      pthread_cond_signal (&fifo->not_empty);
+  }
+  fbc_reset (fifo);
+  pthread_mutex_unlock (&fifo->mutex);
+
+  pthread_mutex_unlock (&this->get_mutex);
+}
+
+static int fifo_spsc_size (fifo_buffer_t *fifo) {
+  fifo_spsc_t *this = (fifo_spsc_t *)fifo;
+  return XINE_ATGET (this->num_bufs);
+}
+
+static uint32_t fifo_spsc_data_size (fifo_buffer_t *fifo) {
+  fifo_spsc_t *this = (fifo_spsc_t *)fifo;
+  return XINE_ATGET (this->data_size);
+}
+
+static void fifo_spsc_dispose (fifo_buffer_t *fifo) {
+  fifo_spsc_t *this = (fifo_spsc_t *)fifo;
+  buf_element_t **add = fifo->last ? &fifo->last->next : &fifo->first;
+
+  /* move ring contents to the classic list, and let fifo_buffer_all_clear ()
+   * free the sibling bufs there. */
+  while (XINE_ATGET (this->fill) > 0) {
+    buf_element_t *buf = this->ring[this->get_pos];
+    this->get_pos = (this->get_pos + 1) & this->mask;
+    XINE_ATFA (this->fill, -1);
+    *add = fifo->last = buf;
+    add = &buf->next;
+    buf->next = NULL;
+  }
+
+  pthread_mutex_destroy (&this->put_mutex);
+  pthread_mutex_destroy (&this->get_mutex);
+  pthread_cond_destroy (&this->not_full);
+  fifo_buffer_dispose (fifo);
+}
+#endif
+
+buf_element_t *xine_fifo_try_get (fifo_buffer_t *fifo) {
+  buf_element_t *buf;
+  int i;
+
+#if (HAVE_ATOMIC_VARS > 0)
+  if (fifo->get == fifo_spsc_get) {
+    fifo_spsc_t *this = (fifo_spsc_t *)fifo;
+
+    pthread_mutex_lock (&this->get_mutex);
+    buf = fifo_spsc_pop (this);
+    if (buf && fifo->get_cb[0]) {
+      pthread_mutex_lock (&fifo->mutex);
+      for (i = 0; fifo->get_cb[i]; i++)
+        fifo->get_cb[i] (fifo, buf, fifo->get_cb_data[i]);
+      pthread_mutex_unlock (&fifo->mutex);
+    }
+    pthread_mutex_unlock (&this->get_mutex);
+    return buf;
+  }
+#endif
+
+  pthread_mutex_lock (&fifo->mutex);
+  buf = fifo->first;
+  if (buf) {
+    fifo->first = buf->next;
+    if (!fifo->first)
+      fifo->last = NULL;
+    fifo->fifo_size -= buffer_units (buf);
+    fifo->fifo_data_size -= buf->size;
+    for (i = 0; fifo->get_cb[i]; i++)
+      fifo->get_cb[i] (fifo, buf, fifo->get_cb_data[i]);
+  }
+  pthread_mutex_unlock (&fifo->mutex);
+  return buf;
+}
+
+void xine_fifo_set_wake (fifo_buffer_t *fifo, void (*wake) (void *data), void *data) {
+  /* put () and insert () call this with these locks held. */
+#if (HAVE_ATOMIC_VARS > 0)
+  if (fifo->get == fifo_spsc_get) {
+    fifo_spsc_t *this = (fifo_spsc_t *)fifo;
+
+    pthread_mutex_lock (&this->put_mutex);
+    pthread_mutex_lock (&fifo->mutex);
+    this->priv.wake_cb = wake;
+    this->priv.wake_cb_data = data;
+    pthread_mutex_unlock (&fifo->mutex);
+    pthread_mutex_unlock (&this->put_mutex);
+    return;
+  }
+#endif
+  pthread_mutex_lock (&fifo->mutex);
+  ((fifo_private_t *)fifo)->wake_cb = wake;
+  ((fifo_private_t *)fifo)->wake_cb_data = data;
+  pthread_mutex_unlock (&fifo->mutex);
+}
+
+uint32_t xine_fifo_peek_type (fifo_buffer_t *fifo) {
+  uint32_t type = 0;
+
+#if (HAVE_ATOMIC_VARS > 0)
+  if (fifo->get == fifo_spsc_get) {
+    fifo_spsc_t *this = (fifo_spsc_t *)fifo;
+
+    /* inserted bufs come first, then the ring. */
+    pthread_mutex_lock (&this->get_mutex);
+    pthread_mutex_lock (&fifo->mutex);
+    if (fifo->first)
+      type = fifo->first->type;
+    pthread_mutex_unlock (&fifo->mutex);
+    if (!type && (XINE_ATGET (this->fill) > 0))
+      type = this->ring[this->get_pos]->type;
+    pthread_mutex_unlock (&this->get_mutex);
+    return type;
+  }
+#endif
+  pthread_mutex_lock (&fifo->mutex);
+  if (fifo->first)
+    type = fifo->first->type;
+  pthread_mutex_unlock (&fifo->mutex);
+  return type;
+}
+
 /*
  * allocate and initialize new (empty) fifo buffer
  */
-fifo_buffer_t *_x_fifo_buffer_new (int num_buffers, uint32_t buf_size) {
+static fifo_buffer_t *fifo_buffer_new_int (size_t struct_size, int num_buffers, uint32_t buf_size) {
 
   fifo_buffer_t *this;
   int            i;
   unsigned char *multi_buffer;
   be_ei_t       *beei;
 
-  this = calloc(1, sizeof(fifo_buffer_t));
+  this = calloc(1, struct_size);
   if (!this)
     return NULL;
 #ifndef HAVE_ZERO_SAFE_MEM
@@ -973,6 +1677,8 @@ fifo_buffer_t *_x_fifo_buffer_new (int num_buffers, uint32_t buf_size) {
   this->alloc_cb_data[0]        = NULL;
   this->get_cb_data[0]          = NULL;
   this->put_cb_data[0]          = NULL;
+  ((fifo_private_t *)this)->wake_cb      = NULL;
+  ((fifo_private_t *)this)->wake_cb_data = NULL;
 #endif
 
   /* printf ("Allocating %d buffers of %ld bytes in one chunk\n", num_buffers, (long int) buf_size); */
@@ -1014,6 +1720,7 @@ fifo_buffer_t *_x_fifo_buffer_new (int num_buffers, uint32_t buf_size) {
   this->buffer_pool_realloc    = buffer_pool_realloc;
 
   this->buffer_pool_large_wait  = LARGE_NUM;
+  ((fifo_private_t *)this)->slab_pool = buffer_slab_pool_new (this);
 
   this->buffer_pool_base = multi_buffer;
   beei = (be_ei_t *)(multi_buffer + num_buffers * buf_size);
@@ -1036,6 +1743,10 @@ fifo_buffer_t *_x_fifo_buffer_new (int num_buffers, uint32_t buf_size) {
   return this;
 }
 
+fifo_buffer_t *_x_fifo_buffer_new (int num_buffers, uint32_t buf_size) {
+  return fifo_buffer_new_int (sizeof (fifo_private_t), num_buffers, buf_size);
+}
+
 /*
  * allocate and initialize new (empty) fifo buffer
  */
@@ -1048,6 +1759,47 @@ fifo_buffer_t *_x_dummy_fifo_buffer_new (int num_buffers, uint32_t buf_size) {
   return this;
 }
 
+/*
+ * allocate and initialize new (empty) single producer / single consumer fifo buffer
+ */
+fifo_buffer_t *_x_spsc_fifo_buffer_new (int num_buffers, uint32_t buf_size) {
+#if (HAVE_ATOMIC_VARS > 0)
+  fifo_spsc_t *this;
+  int size;
+
+  /* room for all pool bufs, plus some custom ones. */
+  for (size = 64; size < num_buffers + 64; size <<= 1) ;
+  this = (fifo_spsc_t *)fifo_buffer_new_int (sizeof (*this) + (size - 1) * sizeof (this->ring[0]),
+    num_buffers, buf_size);
+  if (!this)
+    return NULL;
+
+  this->priv.fifo.put       = fifo_spsc_put;
+  this->priv.fifo.insert    = fifo_spsc_insert;
+  this->priv.fifo.get       = fifo_spsc_get;
+  this->priv.fifo.tget      = fifo_spsc_tget;
+  this->priv.fifo.clear     = fifo_spsc_clear;
+  this->priv.fifo.size      = fifo_spsc_size;
+  this->priv.fifo.data_size = fifo_spsc_data_size;
+  this->priv.fifo.dispose   = fifo_spsc_dispose;
+
+  pthread_mutex_init (&this->put_mutex, NULL);
+  pthread_mutex_init (&this->get_mutex, NULL);
+  pthread_cond_init (&this->not_full, NULL);
+  XINE_ATINIT (this->fill, 0);
+  XINE_ATINIT (this->num_bufs, 0);
+  XINE_ATINIT (this->data_size, 0);
+  this->full_waiters = 0;
+  this->mask         = size - 1;
+  this->put_pos      = 0;
+  this->get_pos      = 0;
+
+  return &this->priv.fifo;
+#else
+  return _x_fifo_buffer_new (num_buffers, buf_size);
+#endif
+}
+
 void _x_free_buf_elements(buf_element_t *head) {
 
   if (head) {
@@ -0,0 +1,353 @@
+/*
+ * Copyright (C) 2000-2022 the xine project
+ *
+ * This file is part of xine, a free video player.
+ *
+ * xine is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ *
+ *
+ * shared decoder threads.
+ *
+ * With lots of streams running in parallel, 2 decoder threads per stream
+ * mostly sit waiting for their fifos. Here, a few threads serve all decoder
+ * loops instead. A loop becomes a task that is queued when its fifo gets a
+ * new buf, and that any free thread may run for a while.
+ *
+ * Decoder loops still wait for other things sometimes, like a free output
+ * frame, or the other side of the stream reaching a discontinuity. When a
+ * thread is going to do that, it says so via xine_dpool_blocking (), and the
+ * pool starts an extra thread if there is queued work and no one to do it.
+ * That extra thread quits again later when there are too many.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+
+#define LOG_MODULE "decoder_pool"
+
+#include <xine/xine_internal.h>
+#include "xine_private.h"
+
+typedef enum {
+  DPOOL_TASK_IDLE = 0,
+  DPOOL_TASK_QUEUED,
+  DPOOL_TASK_RUNNING,
+  DPOOL_TASK_AGAIN,  /* woken while running */
+  DPOOL_TASK_LATER,  /* output full, wait on the deferred list */
+  DPOOL_TASK_DONE
+} dpool_task_state_t;
+
+struct xine_dpool_task_s {
+  xine_dpool_task_t  *next;
+  xine_dpool_t       *pool;
+  int               (*run) (void *data);
+  void               *data;
+  dpool_task_state_t  state;
+  struct timespec     due;
+};
+
+struct xine_dpool_s {
+  xine_t             *xine;
+  pthread_mutex_t     lock;
+  pthread_cond_t      wake;  /* idle threads wait here */
+  pthread_cond_t      done;  /* task finished or thread quit */
+  xine_dpool_task_t  *first, **add;
+  xine_dpool_task_t  *later, **later_add;
+  int                 size;  /* max threads not blocking */
+  int                 num_threads;
+  int                 num_idle;
+  int                 num_blocked;
+  int                 timer;  /* an idle thread waits for pool->later */
+  int                 quit;
+};
+
+/* retry interval for tasks with full output. */
+#define DPOOL_LATER_NSEC 10000000
+
+static pthread_key_t  dpool_key;
+static pthread_once_t dpool_once = PTHREAD_ONCE_INIT;
+static int            dpool_key_ok = 0;
+
+static void dpool_key_init (void) {
+  dpool_key_ok = !pthread_key_create (&dpool_key, NULL);
+}
+
+static void *dpool_thread (void *data);
+
+/* make sure someone serves the queue. call with pool->lock held. */
+static void dpool_kick (xine_dpool_t *pool) {
+  pthread_attr_t attr;
+  pthread_t thread;
+  int err;
+
+  if (pool->quit || !pool->first
+    || (pool->num_threads - pool->num_idle - pool->num_blocked >= pool->size))
+    return;
+
+  if (pool->num_idle) {
+    pthread_cond_signal (&pool->wake);
+    return;
+  }
+
+  pthread_attr_init (&attr);
+  pthread_attr_setdetachstate (&attr, PTHREAD_CREATE_DETACHED);
+  err = pthread_create (&thread, &attr, dpool_thread, pool);
+  pthread_attr_destroy (&attr);
+  if (err) {
+    xprintf (pool->xine, XINE_VERBOSITY_LOG,
+      LOG_MODULE ": can't create new thread (%s)\n", strerror (err));
+    return;
+  }
+  pool->num_threads++;
+}
+
+/* move due deferred tasks to the run queue. call with pool->lock held. */
+static void dpool_later_due (xine_dpool_t *pool) {
+  xine_dpool_task_t *task;
+  struct timespec now = {0, 0};
+  int n = 0;
+
+  xine_gettime (&now);
+  while ((task = pool->later)) {
+    if ((task->due.tv_sec > now.tv_sec)
+      || ((task->due.tv_sec == now.tv_sec) && (task->due.tv_nsec > now.tv_nsec)))
+      break;
+    pool->later = task->next;
+    if (!pool->later)
+      pool->later_add = &pool->later;
+    task->next = NULL;
+    task->state = DPOOL_TASK_QUEUED;
+    *pool->add = task;
+    pool->add = &task->next;
+    n++;
+  }
+  /* we take the first one ourselves. */
+  if (n > 1)
+    dpool_kick (pool);
+}
+
+static void *dpool_thread (void *data) {
+  xine_dpool_t *pool = (xine_dpool_t *)data;
+
+  pthread_setspecific (dpool_key, pool);
+
+  pthread_mutex_lock (&pool->lock);
+  while (1) {
+    xine_dpool_task_t *task;
+    int r;
+
+    if (pool->later)
+      dpool_later_due (pool);
+    task = pool->first;
+
+    /* after a blocking wait, we may be too many running. */
+    if (task && (pool->num_threads - pool->num_idle - pool->num_blocked <= pool->size)) {
+      pool->first = task->next;
+      if (!pool->first)
+        pool->add = &pool->first;
+      task->next = NULL;
+      task->state = DPOOL_TASK_RUNNING;
+      pthread_mutex_unlock (&pool->lock);
+
+      r = task->run (task->data);
+
+      pthread_mutex_lock (&pool->lock);
+      if (r == XINE_DPOOL_DONE) {
+        task->state = DPOOL_TASK_DONE;
+        pthread_cond_broadcast (&pool->done);
+      } else if (r == XINE_DPOOL_LATER) {
+        /* constant delay, list stays sorted. */
+        task->state = DPOOL_TASK_LATER;
+        xine_gettime (&task->due);
+        task->due.tv_nsec += DPOOL_LATER_NSEC;
+        if (task->due.tv_nsec >= 1000000000) {
+          task->due.tv_nsec -= 1000000000;
+          task->due.tv_sec += 1;
+        }
+        *pool->later_add = task;
+        pool->later_add = &task->next;
+        if (!pool->timer && pool->num_idle)
+          pthread_cond_signal (&pool->wake);
+      } else if ((r == XINE_DPOOL_MORE) || (task->state == DPOOL_TASK_AGAIN)) {
+        /* back to the end of the line, let the others have their turn. */
+        task->state = DPOOL_TASK_QUEUED;
+        *pool->add = task;
+        pool->add = &task->next;
+      } else {
+        task->state = DPOOL_TASK_IDLE;
+      }
+      continue;
+    }
+
+    if (pool->quit)
+      break;
+
+    pool->num_idle++;
+    if (pool->later && !pool->timer) {
+      pool->timer = 1;
+      pthread_cond_timedwait (&pool->wake, &pool->lock, &pool->later->due);
+      pool->timer = 0;
+      pool->num_idle--;
+    } else if (pool->num_threads > pool->size) {
+      /* an extra thread. keep it for a while, a decoder waiting for a frame
+       * will likely do that again soon. */
+      struct timespec ts = {0, 0};
+      xine_gettime (&ts);
+      ts.tv_sec += 1;
+      r = pthread_cond_timedwait (&pool->wake, &pool->lock, &ts);
+      pool->num_idle--;
+      if ((r == ETIMEDOUT) && (pool->num_threads > pool->size))
+        break;
+    } else {
+      pthread_cond_wait (&pool->wake, &pool->lock);
+      pool->num_idle--;
+    }
+  }
+  pool->num_threads--;
+  pthread_cond_broadcast (&pool->done);
+  pthread_mutex_unlock (&pool->lock);
+
+  return NULL;
+}
+
+xine_dpool_t *xine_dpool_new (xine_t *xine, int num_threads) {
+  xine_dpool_t *pool;
+
+  pthread_once (&dpool_once, dpool_key_init);
+  if (!dpool_key_ok)
+    return NULL;
+
+  pool = calloc (1, sizeof (*pool));
+  if (!pool)
+    return NULL;
+#ifndef HAVE_ZERO_SAFE_MEM
+  pool->first       = NULL;
+  pool->later       = NULL;
+  pool->timer       = 0;
+  pool->num_threads = 0;
+  pool->num_idle    = 0;
+  pool->num_blocked = 0;
+  pool->quit        = 0;
+#endif
+  pool->xine = xine;
+  pool->add  = &pool->first;
+  pool->later_add = &pool->later;
+  pool->size = num_threads < 1 ? 1 : num_threads;
+  pthread_mutex_init (&pool->lock, NULL);
+  pthread_cond_init (&pool->wake, NULL);
+  pthread_cond_init (&pool->done, NULL);
+
+  xprintf (xine, XINE_VERBOSITY_DEBUG,
+    LOG_MODULE ": decoding with %d shared threads.\n", pool->size);
+  return pool;
+}
+
+void xine_dpool_delete (xine_dpool_t **pool) {
+  xine_dpool_t *p = *pool;
+
+  if (!p)
+    return;
+  *pool = NULL;
+
+  pthread_mutex_lock (&p->lock);
+  p->quit = 1;
+  pthread_cond_broadcast (&p->wake);
+  while (p->num_threads)
+    pthread_cond_wait (&p->done, &p->lock);
+  pthread_mutex_unlock (&p->lock);
+
+  pthread_cond_destroy (&p->done);
+  pthread_cond_destroy (&p->wake);
+  pthread_mutex_destroy (&p->lock);
+  free (p);
+}
+
+xine_dpool_task_t *xine_dpool_task_new (xine_dpool_t *pool, int (*run) (void *data), void *data) {
+  xine_dpool_task_t *task;
+
+  if (!pool || !run)
+    return NULL;
+  task = calloc (1, sizeof (*task));
+  if (!task)
+    return NULL;
+#ifndef HAVE_ZERO_SAFE_MEM
+  task->next  = NULL;
+  task->state = DPOOL_TASK_IDLE;
+#endif
+  task->pool = pool;
+  task->run  = run;
+  task->data = data;
+  return task;
+}
+
+void xine_dpool_task_wake (void *data) {
+  xine_dpool_task_t *task = (xine_dpool_task_t *)data;
+  xine_dpool_t *pool = task->pool;
+
+  pthread_mutex_lock (&pool->lock);
+  if (task->state == DPOOL_TASK_IDLE) {
+    task->state = DPOOL_TASK_QUEUED;
+    *pool->add = task;
+    pool->add = &task->next;
+    dpool_kick (pool);
+  } else if (task->state == DPOOL_TASK_RUNNING) {
+    task->state = DPOOL_TASK_AGAIN;
+  }
+  pthread_mutex_unlock (&pool->lock);
+}
+
+void xine_dpool_task_join (xine_dpool_task_t **task) {
+  xine_dpool_task_t *t = *task;
+  xine_dpool_t *pool;
+
+  if (!t)
+    return;
+  *task = NULL;
+  pool = t->pool;
+
+  xine_dpool_blocking (1);
+  pthread_mutex_lock (&pool->lock);
+  while (t->state != DPOOL_TASK_DONE)
+    pthread_cond_wait (&pool->done, &pool->lock);
+  pthread_mutex_unlock (&pool->lock);
+  xine_dpool_blocking (0);
+
+  free (t);
+}
+
+void xine_dpool_blocking (int on) {
+  xine_dpool_t *pool;
+
+  if (!dpool_key_ok)
+    return;
+  pool = (xine_dpool_t *)pthread_getspecific (dpool_key);
+  if (!pool)
+    return;
+
+  pthread_mutex_lock (&pool->lock);
+  if (on) {
+    pool->num_blocked++;
+    dpool_kick (pool);
+  } else {
+    pool->num_blocked--;
+  }
+  pthread_mutex_unlock (&pool->lock);
+}
@@ -662,6 +662,9 @@ int _x_demux_read_header (input_plugin_t *input, void *buffer, off_t size) {
   }
 
   if (caps & INPUT_CAP_SEEKABLE) {
+    int have_size = _x_cache_plugin_read_header (input, buffer, want_size);
+    if (have_size >= 0)
+      return have_size;
     if (input->seek (input, 0, SEEK_SET) != 0)
       return 0;
     want_size = input->read (input, buffer, want_size);
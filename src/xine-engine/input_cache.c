@@ -37,6 +37,8 @@
 #include "xine_private.h"
 
 #define DEFAULT_BUFFER_SIZE 8192
+/* stream head kept while probing demuxers by content. */
+#define PROBE_WINDOW_SIZE (32 << 10)
 
 typedef struct {
   input_plugin_t    input_plugin;      /* inherited structure */
@@ -51,6 +53,11 @@ typedef struct {
 
   int               is_clone;
 
+  /* demux probe window: stream bytes 0 ... probe_len - 1 */
+  uint8_t          *probe_buf;
+  int               probe_len;
+  int               probe_eof;
+
   /* Statistics */
   int               read_call;
   int               main_read_call;
@@ -344,6 +351,7 @@ static void cache_plugin_dispose(input_plugin_t *this_gen) {
     _x_free_input_plugin (this->stream, this->main_input_plugin);
 
   _x_freep(&this->buf);
+  _x_freep(&this->probe_buf);
   free(this);
 }
 
@@ -403,6 +411,70 @@ static input_plugin_t *cache_plugin_new (xine_stream_t *stream, input_plugin_t *
   return &this->input_plugin;
 }
 
+/*
+ * demux probe window.
+ * while probing demuxers by content, most of them want to see the first few
+ * bytes of the stream via _x_demux_read_header (). that means seek to 0, read,
+ * seek to 0 again for each of them, and the read buffer above may not hold
+ * position 0 any longer after a demuxer scanned further. read the head once,
+ * and serve all these requests from memory.
+ */
+int _x_cache_plugin_probe (input_plugin_t *this_gen, int enable) {
+  cache_input_plugin_t *this = (cache_input_plugin_t *)this_gen;
+  uint32_t caps;
+  off_t got;
+
+  if (!this_gen || (this_gen->open != cache_plugin_open))
+    return 0;
+
+  if (!enable) {
+    _x_freep (&this->probe_buf);
+    this->probe_len = 0;
+    this->probe_eof = 0;
+    return 0;
+  }
+
+  if (this->probe_buf)
+    return 1;
+  caps = this->main_input_plugin->get_capabilities (this->main_input_plugin);
+  /* sized preview is served from memory by the input already. */
+  if ((caps & (INPUT_CAP_SEEKABLE | INPUT_CAP_SIZED_PREVIEW)) != INPUT_CAP_SEEKABLE)
+    return 0;
+  if (cache_plugin_get_current_pos (this_gen) != 0)
+    return 0;
+
+  this->probe_buf = malloc (PROBE_WINDOW_SIZE);
+  if (!this->probe_buf)
+    return 0;
+  got = cache_plugin_read (this_gen, this->probe_buf, PROBE_WINDOW_SIZE);
+  if ((got < 0) || (cache_plugin_seek (this_gen, 0, SEEK_SET) != 0)) {
+    _x_freep (&this->probe_buf);
+    return 0;
+  }
+  this->probe_len = got;
+  this->probe_eof = got < PROBE_WINDOW_SIZE;
+  return 1;
+}
+
+int _x_cache_plugin_read_header (input_plugin_t *this_gen, void *buf, int size) {
+  cache_input_plugin_t *this = (cache_input_plugin_t *)this_gen;
+
+  if (!this_gen || (this_gen->open != cache_plugin_open) || !this->probe_buf)
+    return -1;
+  if (size > this->probe_len) {
+    if (!this->probe_eof)
+      return -1;
+    size = this->probe_len;
+  }
+  /* same as plain _x_demux_read_header (): leave input at 0. */
+  if (cache_plugin_get_current_pos (this_gen) != 0) {
+    if (cache_plugin_seek (this_gen, 0, SEEK_SET) != 0)
+      return 0;
+  }
+  memcpy (buf, this->probe_buf, size);
+  return size;
+}
+
 input_plugin_t *_x_cache_plugin_get_instance (xine_stream_t *stream) {
   input_plugin_t *main_plugin = stream->input_plugin;
 
@@ -34,12 +34,16 @@
 #include <dirent.h>
 #endif
 #include <dlfcn.h>
+#include <fcntl.h>
 #include <string.h>
 #include <errno.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <ctype.h>
 #include <signal.h>
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
 
 #include <basedir.h>
 
@@ -106,8 +110,8 @@ static void remove_segv_handler(void){
 #endif
 #endif /* 0 */
 
-#define CACHE_CATALOG_VERSION 4
-#define CACHE_CATALOG_VERSION_STR "4"
+#define CACHE_CATALOG_VERSION 5
+#define CACHE_CATALOG_VERSION_STR "5"
 
 #define __Max(a,b) ((a) > (b) ? (a) : (b))
 static const uint8_t plugin_iface_versions[__Max(PLUGIN_TYPE_MAX, PLUGIN_XINE_MODULE) + 1] = {
@@ -144,6 +148,7 @@ typedef struct fat_node_st {
 /* effectively next:
   uint32_t       supported_types[num_supported_types];
   char           id[idlen + 1];
+  char           mrl_prefixes[plen + 1]; (input plugins only)
   xine_fast_string_t filename[fnlen + n];
 */
 
@@ -168,6 +173,7 @@ static void _fat_node_init (fat_node_t *node) {
   node->info[1].type         = 0;
   node->ainfo.decoder_info.supported_types = NULL;
   node->ainfo.decoder_info.priority        = 0;
+  node->ainfo.input_info.mrl_prefixes      = NULL;
   node->file.filename    = NULL;
   node->file.filesize    = 0;
   node->file.filemtime   = 0;
@@ -497,6 +503,7 @@ static int _insert_node (xine_t *this, plugin_file_t *file, fat_node_t *node_cac
   const all_info_t *ainfo;
   unsigned int num_supported_types = 0;
   unsigned int plugin_type = info->type & PLUGIN_TYPE_MASK;
+  size_t       prefixes_len = 0;
   int          left;
   const char  *what;
 
@@ -549,6 +556,10 @@ static int _insert_node (xine_t *this, plugin_file_t *file, fat_node_t *node_cac
       if (left > DECODER_MAX - this->plugin_catalog->decoder_count)
         left = DECODER_MAX - this->plugin_catalog->decoder_count;
     }
+    if ((plugin_type == PLUGIN_INPUT) && (info->type & PLUGIN_INPUT_MRL_PREFIXES) && !node_cache) {
+      if (ainfo && ainfo->input_info.mrl_prefixes)
+        prefixes_len = strlen (ainfo->input_info.mrl_prefixes) + 1;
+    }
     what = NULL;
   } while (0);
   if (what) {
@@ -573,7 +584,7 @@ static int _insert_node (xine_t *this, plugin_file_t *file, fat_node_t *node_cac
   } else {
     size_t idlen = strlen (info->id) + 1;
     char *q;
-    entry = malloc (sizeof (*entry) + num_supported_types * sizeof (uint32_t) + idlen);
+    entry = malloc (sizeof (*entry) + num_supported_types * sizeof (uint32_t) + idlen + prefixes_len);
     if (!entry)
       return 2;
     _fat_node_init (entry);
@@ -582,6 +593,12 @@ static int _insert_node (xine_t *this, plugin_file_t *file, fat_node_t *node_cac
     q = (char *)entry + sizeof (*entry) + num_supported_types * sizeof (uint32_t);
     entry->info[0].id = q;
     xine_small_memcpy (q, info->id, idlen);
+    if (prefixes_len) {
+      /* the plugin lib may go away, keep our own copy. */
+      q += idlen;
+      memcpy (q, ainfo->input_info.mrl_prefixes, prefixes_len);
+      entry->ainfo.input_info.mrl_prefixes = q;
+    }
   }
   entry->lastplugin = entry;
   entry->xine       = this;
@@ -808,21 +825,22 @@ void xine_register_plugins(xine_t *self, const plugin_info_t *info) {
  *
  ***************************************************************************/
 
-/* NOTE: path actually is a xine_fast_string_t *. */
-static void collect_plugins (xine_t *this, char *path, char *stop, char *pend) {
+/* NOTE: path actually is a xine_fast_string_t *.
+ * return the number of plugin files not found in the cache. */
+static int collect_plugins (xine_t *this, char *path, char *stop, char *pend) {
 
   char          *adds[5];
   DIR           *dirs[5];
   struct stat    statbuf;
-  int            level;
+  int            level, num_new = 0;
 
   lprintf ("collect_plugins in %s\n", path);
 
   /* we need a dir to start */
   if (stat (path, &statbuf))
-    return;
+    return 0;
   if (!S_ISDIR (statbuf.st_mode))
-    return;
+    return 0;
 
   adds[0] = stop;
   dirs[0] = NULL;
@@ -931,6 +949,8 @@ static void collect_plugins (xine_t *this, char *path, char *stop, char *pend) {
               file = _insert_file (this->plugin_catalog->file_list, path, &statbuf, lib, q - path);
               if (file) {
                 _register_plugins_internal (this, file, fatn_found, info);
+                if (!fatn_found)
+                  num_new++;
               } else {
                 if (lib != NULL)
                   dlclose(lib);
@@ -958,6 +978,7 @@ static void collect_plugins (xine_t *this, char *path, char *stop, char *pend) {
       } /* switch */
     }
   } /* while */
+  return num_new;
 } /* collect_plugins */
 
 /*
@@ -1199,6 +1220,25 @@ static void load_required_plugins(xine_t *this) {
   }
 }
 
+/*
+ *  serialize a config entry attached to a plugin node.
+ */
+#ifdef FAST_SCAN_PLUGINS
+static char *_cfg_entry_serialize (xine_t *this, cfg_entry_t *entry) {
+  char *key_value;
+  pthread_mutex_lock (&this->config->config_lock);
+  this->config->cur = entry;
+  key_value = this->config->get_serialized_entry (this->config, NULL);
+  pthread_mutex_unlock (&this->config->config_lock);
+  return key_value;
+}
+#else
+static char *_cfg_entry_serialize (xine_t *this, const char *entry) {
+  /* now serialize the config key */
+  return this->config->get_serialized_entry (this->config, entry);
+}
+#endif
+
 /*
  *  save plugin list information to file (cached catalog)
  */
@@ -1286,6 +1326,13 @@ static void save_plugin_list(xine_t *this, FILE *fp, xine_sarray_t *list) {
       }
       case PLUGIN_INPUT: {
         const input_info_t *input_info = node->info->special_info;
+        if (input_info->mrl_prefixes) {
+          memcpy (q, "mrl_prefixes=", 13); q += 13;
+          q += strlcpy (q, input_info->mrl_prefixes, e - q);
+          if (q >= e)
+            q = e - 1;
+          *q++ = '\n';
+        }
         memcpy (q, "input_priority=", 15); q += 15;
         pri = input_info->priority;
         goto write_pri;
@@ -1323,16 +1370,7 @@ static void save_plugin_list(xine_t *this, FILE *fp, xine_sarray_t *list) {
       const char *entry;
 #endif
       while ((entry = xine_list_next_value (node->config_entry_list, &ite))) {
-        char *key_value;
-#ifdef FAST_SCAN_PLUGINS
-        pthread_mutex_lock (&this->config->config_lock);
-        this->config->cur = entry;
-        key_value = this->config->get_serialized_entry (this->config, NULL);
-        pthread_mutex_unlock (&this->config->config_lock);
-#else
-        /* now serialize the config key */
-        key_value = this->config->get_serialized_entry (this->config, entry);
-#endif
+        char *key_value = _cfg_entry_serialize (this, entry);
         if (key_value) {
           size_t slen = strlen (key_value);
 #ifdef FAST_SCAN_PLUGINS
@@ -1353,6 +1391,86 @@ static void save_plugin_list(xine_t *this, FILE *fp, xine_sarray_t *list) {
   }
 }
 
+/*
+ *  add a node read from the cached catalog.
+ *  node->file.filename is a plain string of fnlen bytes here.
+ */
+static fat_node_t *_cached_node_add (xine_t *this, xine_sarray_t *plugins, const fat_node_t *node,
+  const uint32_t *supported_types, size_t stlen, size_t idlen, size_t fnlen,
+  char **cfgentries, int numcfgs) {
+  fat_node_t *n;
+  char *q;
+  size_t plen = 0;
+  if (((node->info[0].type & PLUGIN_TYPE_MASK) == PLUGIN_INPUT) && node->ainfo.input_info.mrl_prefixes)
+    plen = strlen (node->ainfo.input_info.mrl_prefixes) + 1;
+  /* get mem for new node */
+  n = malloc (sizeof (*node) + stlen + idlen + plen + fnlen + 32);
+  if (!n)
+    return NULL;
+  /* fill in */
+  *n = *node;
+  n->node.info = &n->info[0];
+  q = (char *)n + sizeof (*n);
+  if (stlen) {
+    memcpy (&n->supported_types[0], supported_types, stlen);
+    q += stlen;
+    n->ainfo.decoder_info.supported_types = &n->supported_types[0];
+  }
+  if (node->info[0].id) {
+    xine_small_memcpy (q, node->info[0].id, idlen);
+    n->info[0].id = q;
+    q += idlen;
+  }
+  if (plen) {
+    memcpy (q, node->ainfo.input_info.mrl_prefixes, plen);
+    n->ainfo.input_info.mrl_prefixes = q;
+    q += plen;
+  }
+  n->file.filename = xine_fast_string_init (q, fnlen + 32);
+  xine_fast_string_set (n->file.filename, node->file.filename, fnlen);
+  /* q += fn_need; */
+  n->node.file = &n->file;
+  n->info[0].special_info = &n->ainfo;
+  /* register */
+  {
+    int index = xine_sarray_add (plugins, n);
+    if (index >= 0) { /* new file */
+      n->lastplugin = n;
+    } else {
+      fat_node_t *first_in_file = xine_sarray_get (plugins, ~index);
+      first_in_file->lastplugin->nextplugin = n;
+      first_in_file->lastplugin = n;
+    }
+  }
+  if (numcfgs) {
+    char **cfgentry;
+#ifdef FAST_SCAN_PLUGINS
+    new_entry_data_t ned;
+    ned.v = this->config;
+    ned.node = &n->node;
+    this->config->set_new_entry_callback (this->config, _new_entry_cb, &ned);
+#endif
+    cfgentries[numcfgs] = NULL;
+    for (cfgentry = cfgentries; *cfgentry; cfgentry++) {
+      char *cfg_key = this->config->register_serialized_entry (this->config, *cfgentry);
+      if (cfg_key) {
+        /* this node is a cached node */
+#ifdef FAST_SCAN_PLUGINS
+        free (cfg_key);
+#else
+        _attach_entry_to_node (&n->node, cfg_key);
+#endif
+      } else {
+        lprintf("failed to deserialize config entry key\n");
+      }
+    }
+#ifdef FAST_SCAN_PLUGINS
+    this->config->unset_new_entry_callback (this->config);
+#endif
+  }
+  return n;
+}
+
 /*
  *  load plugin list information from file (cached catalog)
  */
@@ -1402,68 +1520,8 @@ static void load_plugin_list (xine_t *this, const char *filename, xine_sarray_t
     if (line[0] == '[' && version_ok) {
 
       if (node.file.filename) {
-        fat_node_t *n;
-        char *q;
-        /* get mem for new node */
-        n = malloc (sizeof (node) + stlen + idlen + fnlen + 32);
-        if (!n)
+        if (!_cached_node_add (this, plugins, &node, supported_types, stlen, idlen, fnlen, cfgentries, numcfgs))
           break;
-        /* fill in */
-        *n = node;
-        n->node.info = &n->info[0];
-        q = (char *)n + sizeof (*n);
-        if (stlen) {
-          memcpy (&n->supported_types[0], &supported_types[0], stlen);
-          q += stlen;
-          n->ainfo.decoder_info.supported_types = &n->supported_types[0];
-        }
-        if (node.info[0].id) {
-          xine_small_memcpy (q, node.info[0].id, idlen);
-          n->info[0].id = q;
-          q += idlen;
-        }
-        n->file.filename = xine_fast_string_init (q, fnlen + 32);
-        xine_fast_string_set (n->file.filename, node.file.filename, fnlen);
-        /* q += fn_need; */
-        n->node.file = &n->file;
-        n->info[0].special_info = &n->ainfo;
-        /* register */
-        {
-          int index = xine_sarray_add (plugins, n);
-          if (index >= 0) { /* new file */
-            n->lastplugin = n;
-          } else {
-            fat_node_t *first_in_file = xine_sarray_get (plugins, ~index);
-            first_in_file->lastplugin->nextplugin = n;
-            first_in_file->lastplugin = n;
-          }
-        }
-        if (numcfgs) {
-          char **cfgentry;
-#ifdef FAST_SCAN_PLUGINS
-          new_entry_data_t ned;
-          ned.v = this->config;
-          ned.node = &n->node;
-          this->config->set_new_entry_callback (this->config, _new_entry_cb, &ned);
-#endif
-          cfgentries[numcfgs] = NULL;
-          for (cfgentry = cfgentries; *cfgentry; cfgentry++) {
-            char *cfg_key = this->config->register_serialized_entry (this->config, *cfgentry);
-            if (cfg_key) {
-              /* this node is a cached node */
-#ifdef FAST_SCAN_PLUGINS
-              free (cfg_key);
-#else
-              _attach_entry_to_node (&n->node, cfg_key);
-#endif
-            } else {
-              lprintf("failed to deserialize config entry key\n");
-            }
-          }
-#ifdef FAST_SCAN_PLUGINS
-          this->config->unset_new_entry_callback (this->config);
-#endif
-        }
         /* reset */
         _fat_node_init (&node);
         stlen = 0;
@@ -1512,6 +1570,7 @@ static void load_plugin_list (xine_t *this, const char *filename, xine_sarray_t
         _K_module_priority,
         _K_module_sub_type,
         _K_module_type,
+        _K_mrl_prefixes,
         _K_LAST
       } _k_t;
       _k_t index = _K_NONE;
@@ -1566,6 +1625,10 @@ static void load_plugin_list (xine_t *this, const char *filename, xine_sarray_t
               index = _K_vo_priority;
           }
           break;
+        case 12:
+          if (!memcmp (line, "mrl_prefixes", 12))
+            index = _K_mrl_prefixes;
+          break;
         case 14:
           if (!memcmp (line, "input_priority", 14))
             index = _K_input_priority;
@@ -1670,6 +1733,9 @@ static void load_plugin_list (xine_t *this, const char *filename, xine_sarray_t
           case _K_input_priority:
             node.ainfo.input_info.priority = v.i;
             break;
+          case _K_mrl_prefixes:
+            node.ainfo.input_info.mrl_prefixes = value;
+            break;
           case _K_post_type:
             node.ainfo.post_info.type = v.u;
             break;
@@ -1694,6 +1760,398 @@ static void load_plugin_list (xine_t *this, const char *filename, xine_sarray_t
   xine_fast_text_unload (&xft);
 }
 
+#ifdef HAVE_SYS_MMAN_H
+/*
+ *  binary catalog cache ("plugins.cache.bin").
+ *  a header, a table of fixed size node records, and a string/data blob.
+ *  it is mmap'ed and turned into nodes without any text parsing.
+ *  it is native endian, and only valid together with the text cache
+ *  it was written with. if it is missing or stale, we fall back to the
+ *  text cache, and write a new one next time.
+ */
+#define CACHE_BIN_MAGIC "xinepcb"
+#define CACHE_BIN_VERSION ((CACHE_CATALOG_VERSION << 8) + 1)
+#define CACHE_BIN_ENDIAN 0x01020304
+
+typedef struct {
+  char     magic[8];
+  uint32_t endian;
+  uint32_t version;
+  /* the text cache this belongs to */
+  uint64_t text_size;
+  uint64_t text_mtime;
+  uint32_t num_nodes;
+  uint32_t blob_size;
+} cache_bin_head_t;
+
+typedef struct {
+  uint64_t filesize;
+  uint64_t filemtime;
+  /* blob offsets and lengths. strings are 0 terminated there. */
+  uint32_t filename, filename_len;
+  uint32_t id, id_len;
+  uint32_t supported_types, num_supported_types;
+  uint32_t cfg, num_cfg;
+  uint32_t mrl_prefixes, mrl_prefixes_len;
+  int32_t  type;
+  int32_t  api;
+  uint32_t version;
+  int32_t  priority;
+  int32_t  visual_type;
+  uint32_t sub_type;
+  char     module_type[16];
+} cache_bin_node_t;
+
+typedef struct {
+  cache_bin_node_t *nodes;
+  uint8_t          *blob;
+  uint32_t          num_nodes, max_nodes;
+  uint32_t          blob_size, blob_max;
+  int               error;
+} cache_bin_writer_t;
+
+static uint32_t _cache_bin_put (cache_bin_writer_t *w, const void *data, uint32_t len) {
+  uint32_t offs = w->blob_size;
+  if (offs + len + 1 > w->blob_max) {
+    uint32_t nmax = (offs + len + 1 + 8191) & ~8191u;
+    uint8_t *nblob = realloc (w->blob, nmax);
+    if (!nblob) {
+      w->error = 1;
+      return 0;
+    }
+    w->blob = nblob;
+    w->blob_max = nmax;
+  }
+  if (len)
+    memcpy (w->blob + offs, data, len);
+  w->blob[offs + len] = 0;
+  w->blob_size = offs + len + 1;
+  return offs;
+}
+
+static void save_plugin_list_bin (xine_t *this, cache_bin_writer_t *w, xine_sarray_t *list) {
+  int list_id, list_size = xine_sarray_size (list);
+
+  for (list_id = 0; list_id < list_size; list_id++) {
+    const plugin_node_t *node = xine_sarray_get (list, list_id);
+    const plugin_file_t *file = node->file;
+    cache_bin_node_t *r;
+
+    /* builtins are not cached. */
+    if (!file)
+      continue;
+    if (w->num_nodes >= w->max_nodes) {
+      uint32_t nmax = w->max_nodes + 64;
+      cache_bin_node_t *nn = realloc (w->nodes, nmax * sizeof (*nn));
+      if (!nn) {
+        w->error = 1;
+        return;
+      }
+      w->nodes = nn;
+      w->max_nodes = nmax;
+    }
+    r = w->nodes + w->num_nodes++;
+    memset (r, 0, sizeof (*r));
+
+    r->filesize = file->filesize;
+    r->filemtime = file->filemtime;
+    r->filename_len = strlen (file->filename);
+    r->filename = _cache_bin_put (w, file->filename, r->filename_len);
+    r->id_len = strlen (node->info->id);
+    r->id = _cache_bin_put (w, node->info->id, r->id_len);
+    r->type = node->info->type;
+    r->api = node->info->API;
+    r->version = node->info->version;
+
+    switch (node->info->type & PLUGIN_TYPE_MASK) {
+      case PLUGIN_VIDEO_OUT: {
+        const vo_info_t *vo_info = node->info->special_info;
+        r->visual_type = vo_info->visual_type;
+        r->priority = vo_info->priority;
+        break;
+      }
+      case PLUGIN_AUDIO_OUT: {
+        const ao_info_t *ao_info = node->info->special_info;
+        r->priority = ao_info->priority;
+        break;
+      }
+      case PLUGIN_AUDIO_DECODER:
+      case PLUGIN_VIDEO_DECODER:
+      case PLUGIN_SPU_DECODER: {
+        const decoder_info_t *decoder_info = node->info->special_info;
+        const uint32_t *t = decoder_info->supported_types;
+        uint32_t n = 0;
+        while (t[n] && (n < 255))
+          n++;
+        r->supported_types = _cache_bin_put (w, t, n * sizeof (*t));
+        r->num_supported_types = n;
+        r->priority = decoder_info->priority;
+        break;
+      }
+      case PLUGIN_DEMUX: {
+        const demuxer_info_t *demuxer_info = node->info->special_info;
+        r->priority = demuxer_info->priority;
+        break;
+      }
+      case PLUGIN_INPUT: {
+        const input_info_t *input_info = node->info->special_info;
+        r->priority = input_info->priority;
+        if (input_info->mrl_prefixes) {
+          r->mrl_prefixes_len = strlen (input_info->mrl_prefixes);
+          r->mrl_prefixes = _cache_bin_put (w, input_info->mrl_prefixes, r->mrl_prefixes_len);
+        }
+        break;
+      }
+      case PLUGIN_POST: {
+        const post_info_t *post_info = node->info->special_info;
+        r->sub_type = post_info->type;
+        break;
+      }
+      case PLUGIN_XINE_MODULE: {
+        const xine_module_info_t *module_info = node->info->special_info;
+        strlcpy (r->module_type, module_info->type, sizeof (r->module_type));
+        r->sub_type = module_info->sub_type;
+        r->priority = module_info->priority;
+        break;
+      }
+    }
+
+    /* config entries, as consecutive strings. */
+    r->cfg = w->blob_size;
+    if (node->config_entry_list) {
+      xine_list_iterator_t ite = NULL;
+#ifdef FAST_SCAN_PLUGINS
+      cfg_entry_t *entry;
+#else
+      const char *entry;
+#endif
+      while ((entry = xine_list_next_value (node->config_entry_list, &ite))) {
+        char *key_value = _cfg_entry_serialize (this, entry);
+        if (key_value) {
+          if (r->num_cfg < 255) {
+            uint32_t offs = _cache_bin_put (w, key_value, strlen (key_value));
+            if (!r->num_cfg)
+              r->cfg = offs;
+            r->num_cfg++;
+          }
+          free (key_value);
+        }
+      }
+    }
+    if (w->error)
+      return;
+  }
+}
+
+static void save_catalog_bin (xine_t *this, const char *textfile) {
+  cache_bin_writer_t w;
+  cache_bin_head_t head;
+  struct stat st;
+  char *binfile, *binfile_new;
+  FILE *fp;
+  int i;
+
+  if (stat (textfile, &st))
+    return;
+
+  w.nodes = NULL;
+  w.blob = NULL;
+  w.num_nodes = w.max_nodes = 0;
+  w.blob_size = w.blob_max = 0;
+  w.error = 0;
+  for (i = 0; i < PLUGIN_TYPE_MAX; i++)
+    save_plugin_list_bin (this, &w, this->plugin_catalog->plugin_lists[i]);
+  save_plugin_list_bin (this, &w, this->plugin_catalog->modules_list);
+
+  binfile = _x_asprintf ("%s.bin", textfile);
+  binfile_new = _x_asprintf ("%s.bin.new", textfile);
+  if (w.error || !binfile || !binfile_new)
+    goto done;
+
+  memcpy (head.magic, CACHE_BIN_MAGIC, 8);
+  head.endian = CACHE_BIN_ENDIAN;
+  head.version = CACHE_BIN_VERSION;
+  head.text_size = st.st_size;
+  head.text_mtime = st.st_mtime;
+  head.num_nodes = w.num_nodes;
+  head.blob_size = w.blob_size;
+
+  fp = fopen (binfile_new, "wb");
+  if (!fp)
+    goto done;
+  i = (fwrite (&head, sizeof (head), 1, fp) != 1)
+    || (w.num_nodes && (fwrite (w.nodes, sizeof (*w.nodes), w.num_nodes, fp) != w.num_nodes))
+    || (w.blob_size && (fwrite (w.blob, 1, w.blob_size, fp) != w.blob_size));
+  if (fclose (fp) || i) {
+    unlink (binfile_new);
+    goto done;
+  }
+  if (rename (binfile_new, binfile)) {
+    xine_log (this, XINE_LOG_MSG, _("failed to replace catalogue cache: %s\n"), strerror (errno));
+    unlink (binfile_new);
+  }
+
+  done:
+  free (binfile);
+  free (binfile_new);
+  free (w.nodes);
+  free (w.blob);
+}
+
+/* return 1 if string at offs of len + terminating 0 is inside blob. */
+static int _cache_bin_str_ok (const uint8_t *blob, uint32_t blob_size, uint32_t offs, uint32_t len) {
+  return (offs < blob_size) && (len < blob_size - offs) && !blob[offs + len];
+}
+
+/*
+ *  load plugin list information from binary cache.
+ *  return 0 if it is missing or does not match textfile.
+ */
+static int load_plugin_list_bin (xine_t *this, const char *textfile, xine_sarray_t *plugins) {
+  const cache_bin_head_t *head;
+  const cache_bin_node_t *r;
+  const uint8_t *blob;
+  uint8_t *mem;
+  struct stat st;
+  size_t size;
+  uint32_t u;
+  char *binfile;
+  int fd;
+
+  if (stat (textfile, &st))
+    return 0;
+  binfile = _x_asprintf ("%s.bin", textfile);
+  if (!binfile)
+    return 0;
+  fd = open (binfile, O_RDONLY);
+  free (binfile);
+  if (fd < 0)
+    return 0;
+  {
+    struct stat bst;
+    if (fstat (fd, &bst) || (bst.st_size < (off_t)sizeof (*head)) || (bst.st_size > (2 << 20))) {
+      close (fd);
+      return 0;
+    }
+    size = bst.st_size;
+  }
+  mem = mmap (NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close (fd);
+  if (mem == MAP_FAILED)
+    return 0;
+
+  /* validate everything first, there is no way back once we added nodes. */
+  head = (const cache_bin_head_t *)mem;
+  r = (const cache_bin_node_t *)(mem + sizeof (*head));
+  if (memcmp (head->magic, CACHE_BIN_MAGIC, 8)
+    || (head->endian != CACHE_BIN_ENDIAN)
+    || (head->version != CACHE_BIN_VERSION)
+    || (head->text_size != (uint64_t)st.st_size)
+    || (head->text_mtime != (uint64_t)st.st_mtime)
+    || (head->num_nodes > (size - sizeof (*head)) / sizeof (*r))
+    || ((uint64_t)sizeof (*head) + (uint64_t)head->num_nodes * sizeof (*r) + head->blob_size != size))
+    goto stale;
+  blob = (const uint8_t *)(r + head->num_nodes);
+  for (u = 0; u < head->num_nodes; u++) {
+    const cache_bin_node_t *n = r + u;
+    uint32_t offs, i;
+    if (!_cache_bin_str_ok (blob, head->blob_size, n->filename, n->filename_len)
+      || !_cache_bin_str_ok (blob, head->blob_size, n->id, n->id_len)
+      || (n->num_supported_types > 255)
+      || (n->num_cfg > 255)
+      || !memchr (n->module_type, 0, sizeof (n->module_type)))
+      goto stale;
+    if (n->num_supported_types
+      && !_cache_bin_str_ok (blob, head->blob_size, n->supported_types, n->num_supported_types * 4))
+      goto stale;
+    if (n->mrl_prefixes_len
+      && !_cache_bin_str_ok (blob, head->blob_size, n->mrl_prefixes, n->mrl_prefixes_len))
+      goto stale;
+    for (offs = n->cfg, i = 0; i < n->num_cfg; i++) {
+      const uint8_t *e;
+      if (offs >= head->blob_size)
+        goto stale;
+      e = memchr (blob + offs, 0, head->blob_size - offs);
+      if (!e)
+        goto stale;
+      offs = e + 1 - blob;
+    }
+  }
+
+  for (u = 0; u < head->num_nodes; u++) {
+    const cache_bin_node_t *n = r + u;
+    fat_node_t node;
+    uint32_t supported_types[256];
+    char *cfgentries[256];
+    size_t stlen = 0;
+    uint32_t i;
+
+    _fat_node_init (&node);
+    node.file.filename = (char *)blob + n->filename;
+    node.file.filesize = n->filesize;
+    node.file.filemtime = n->filemtime;
+    node.info[0].type = n->type;
+    node.info[0].API = n->api;
+    node.info[0].id = (char *)blob + n->id;
+    node.info[0].version = n->version;
+    switch (n->type & PLUGIN_TYPE_MASK) {
+      case PLUGIN_VIDEO_OUT:
+        node.ainfo.vo_info.visual_type = n->visual_type;
+        node.ainfo.vo_info.priority = n->priority;
+        break;
+      case PLUGIN_AUDIO_OUT:
+        node.ainfo.ao_info.priority = n->priority;
+        break;
+      case PLUGIN_AUDIO_DECODER:
+      case PLUGIN_VIDEO_DECODER:
+      case PLUGIN_SPU_DECODER:
+        node.ainfo.decoder_info.priority = n->priority;
+        if (n->num_supported_types) {
+          stlen = n->num_supported_types * sizeof (*supported_types);
+          memcpy (supported_types, blob + n->supported_types, stlen);
+        }
+        supported_types[n->num_supported_types] = 0;
+        stlen += sizeof (*supported_types);
+        break;
+      case PLUGIN_DEMUX:
+        node.ainfo.demuxer_info.priority = n->priority;
+        break;
+      case PLUGIN_INPUT:
+        node.ainfo.input_info.priority = n->priority;
+        if (n->mrl_prefixes_len)
+          node.ainfo.input_info.mrl_prefixes = (const char *)blob + n->mrl_prefixes;
+        break;
+      case PLUGIN_POST:
+        node.ainfo.post_info.type = n->sub_type;
+        break;
+      case PLUGIN_XINE_MODULE:
+        strlcpy (node.ainfo.module_info.type, n->module_type, sizeof (node.ainfo.module_info.type));
+        node.ainfo.module_info.sub_type = n->sub_type;
+        node.ainfo.module_info.priority = n->priority;
+        break;
+    }
+    /* the base64 strings go straight from the map to the config. */
+    {
+      const char *c = (const char *)blob + n->cfg;
+      for (i = 0; i < n->num_cfg; i++) {
+        cfgentries[i] = (char *)c;
+        c += strlen (c) + 1;
+      }
+    }
+    if (!_cached_node_add (this, plugins, &node, supported_types, stlen, n->id_len + 1, n->filename_len,
+      cfgentries, n->num_cfg))
+      break;
+  }
+
+  munmap (mem, size);
+  return 1;
+
+  stale:
+  munmap (mem, size);
+  return 0;
+}
+#endif
+
 /**
  * @brief Returns the complete filename for the plugins' cache file
  * @param this Instance pointer, used for logging and libxdg-basedir.
@@ -1793,20 +2251,34 @@ static void save_catalog (xine_t *this) {
 		  _("failed to remove new catalogue cache: %s\n"), err);
       }
     }
+#ifdef HAVE_SYS_MMAN_H
+    else
+      save_catalog_bin (this, cachefile);
+#endif
   }
   free(cachefile);
   free(cachefile_new);
 }
 
 /*
- * load cached catalog from file
+ * load cached catalog from file.
+ * return 0 if the cache needs to be (re)written.
  */
-static void load_cached_catalog (xine_t *this) {
+static int load_cached_catalog (xine_t *this) {
   char *const cachefile = catalog_filename(this, 0);
+  int ok;
   /* It can't return NULL without creating directories */
 
+#ifdef HAVE_SYS_MMAN_H
+  ok = load_plugin_list_bin (this, cachefile, this->plugin_catalog->cache_list);
+  if (!ok)
+    load_plugin_list (this, cachefile, this->plugin_catalog->cache_list);
+#else
   load_plugin_list (this, cachefile, this->plugin_catalog->cache_list);
+  ok = xine_sarray_size (this->plugin_catalog->cache_list) > 0;
+#endif
   free(cachefile);
+  return ok;
 }
 
 
@@ -1822,6 +2294,7 @@ int _x_scan_plugins (xine_t *this_gen) {
   const char *pluginpath = NULL;
   const char *homedir;
   size_t homelen;
+  int num_new;
 
   lprintf("_x_scan_plugins()\n");
 
@@ -1840,7 +2313,8 @@ int _x_scan_plugins (xine_t *this_gen) {
   if (!this->x.plugin_catalog)
     return -1;
 
-  XINE_PROFILE (load_cached_catalog (&this->x));
+  /* a missing or stale cache counts as 1 new file. */
+  XINE_PROFILE (num_new = !load_cached_catalog (&this->x));
 
 #ifdef XINE_MAKE_BUILTINS
   lprintf ("collect_plugins in libxine\n");
@@ -1868,14 +2342,14 @@ int _x_scan_plugins (xine_t *this_gen) {
       xine_small_memcpy (q, start, len); q += len;
       q[0] = 0;
       start = stop + 1;
-      collect_plugins (&this->x, buf, q, bufend);
+      num_new += collect_plugins (&this->x, buf, q, bufend);
     }
     len = strlen (start);
     if (len > (size_t)(bufend - q))
       len = bufend - q;
     xine_small_memcpy (q, start, len); q += len;
     q[0] = 0;
-    collect_plugins (&this->x, buf, q, bufend);
+    num_new += collect_plugins (&this->x, buf, q, bufend);
 
   } else {
 
@@ -1885,7 +2359,7 @@ int _x_scan_plugins (xine_t *this_gen) {
 
     xine_small_memcpy (buf, homedir, homelen);
     memcpy (buf + homelen, "/.xine/plugins", 15);
-    collect_plugins (&this->x, buf, buf + homelen + 15, bufend);
+    num_new += collect_plugins (&this->x, buf, buf + homelen + 15, bufend);
 
     p = XINE_PLUGINROOT;
     len = strlen (p);
@@ -1894,13 +2368,16 @@ int _x_scan_plugins (xine_t *this_gen) {
     for (i = XINE_LT_AGE; i >= 0; i--) {
       char *q = buf + len;
       xine_uint32_2str (&q, i);
-      collect_plugins (&this->x, buf, q, bufend);
+      num_new += collect_plugins (&this->x, buf, q, bufend);
     }
   }
 
   load_required_plugins (&this->x);
 
-  if ((this->flags & XINE_FLAG_NO_WRITE_CACHE) == 0)
+  /* dont rewrite an unchanged cache. cache entries still left
+   * belong to plugin files that went away. */
+  if ((this->flags & XINE_FLAG_NO_WRITE_CACHE) == 0
+    && (num_new || xine_sarray_size (this->x.plugin_catalog->cache_list)))
     XINE_PROFILE (save_catalog (&this->x));
 
   map_decoders (&this->x);
@@ -1970,6 +2447,22 @@ void _x_free_module(xine_t *xine, xine_module_t **pmodule) {
  * input / demuxer plugin loading
  */
 
+static int _input_mrl_prefix_match (const char *prefixes, const char *mrl) {
+  if (!prefixes)
+    return 1;
+  while (1) {
+    size_t l;
+    while (*prefixes == ' ')
+      prefixes++;
+    if (!*prefixes)
+      return 0;
+    for (l = 0; prefixes[l] && (prefixes[l] != ' '); l++) ;
+    if (!strncasecmp (mrl, prefixes, l))
+      return 1;
+    prefixes += l;
+  }
+}
+
 input_plugin_t *_x_find_input_plugin (xine_stream_t *stream, const char *mrl) {
 
   xine_stream_private_t *s;
@@ -1996,6 +2489,9 @@ input_plugin_t *_x_find_input_plugin (xine_stream_t *stream, const char *mrl) {
     for (list_id = 0; list_id < list_size; list_id++) {
       plugin_node_t *node = xine_sarray_get (catalog->plugin_lists[PLUGIN_INPUT - 1], list_id);
       input_class_t *class = (input_class_t *)node->plugin_class;
+      /* dont even load plugins that cannot handle this. */
+      if (!_input_mrl_prefix_match (((const input_info_t *)node->info->special_info)->mrl_prefixes, mrl))
+        continue;
       if (!class) {
         _load_plugin_class (xine, node, NULL);
         class = (input_class_t *)node->plugin_class;
@@ -2093,6 +2589,10 @@ demux_plugin_t *_x_find_demux_plugin (xine_stream_t *stream, input_plugin_t *inp
   for (i = 0; (methods[i] >= 0) && !plugin; i++) {
     int list_id, list_size;
 
+    /* read the stream head once for all demuxers probing by content.
+     * explicit and mrl based detection do not need it. */
+    _x_cache_plugin_probe (input, methods[i] == METHOD_BY_CONTENT);
+
     pthread_mutex_lock (&catalog->lock);
 
     list_size = xine_sarray_size(catalog->plugin_lists[PLUGIN_DEMUX - 1]);
@@ -2133,6 +2633,8 @@ demux_plugin_t *_x_find_demux_plugin (xine_stream_t *stream, input_plugin_t *inp
     pthread_mutex_unlock (&catalog->lock);
   }
 
+  _x_cache_plugin_probe (input, 0);
+
   if (input == stream->input_plugin) {
     xine_stream_private_t *s = (xine_stream_private_t *)stream;
     s->demux.input_caps = input->get_capabilities (input);
@@ -2207,6 +2709,7 @@ demux_plugin_t *_x_find_demux_plugin_last_probe(xine_stream_t *stream, const cha
     int list_id, list_size;
 
     stream->content_detection_method = methods[i];
+    _x_cache_plugin_probe (input, methods[i] == METHOD_BY_CONTENT);
 
     pthread_mutex_lock (&catalog->lock);
 
@@ -2248,13 +2751,13 @@ demux_plugin_t *_x_find_demux_plugin_last_probe(xine_stream_t *stream, const cha
     i++;
   }
 
-  if( plugin )
+  if( plugin || !last_demux ) {
+    _x_cache_plugin_probe (input, 0);
     return plugin;
-
-  if( !last_demux )
-    return NULL;
+  }
 
   stream->content_detection_method = METHOD_BY_CONTENT;
+  _x_cache_plugin_probe (input, 1);
 
   pthread_mutex_lock (&catalog->lock);
   if (last_demux->plugin_class || _load_plugin_class(xine, last_demux, NULL)) {
@@ -2267,6 +2770,7 @@ demux_plugin_t *_x_find_demux_plugin_last_probe(xine_stream_t *stream, const cha
   }
   pthread_mutex_unlock (&catalog->lock);
 
+  _x_cache_plugin_probe (input, 0);
   return plugin;
 }
 
@@ -180,23 +180,30 @@ static int64_t unixscr_get_current (scr_plugin_t *scr) {
   xine_monotonic_clock (&tv, NULL);
 #if (HAVE_ATOMIC_VARS > 0)
   {
-    int refs = xine_refs_get (&this->num_speed_changes);
-    if (refs & 1) {
-      /* TJ. no change in progress, try a snapshot without lock first.
-       * the "volatile" is there to stop compiler from reordering code.
-       * tested with gcc -O3 -S 4.5/x86-32 and 7/x86-64.
-       * there is a point where all optimization falls over into chaos.
-       * we are getting closer ;-) */
-      volatile unixscr_values_t v = this->v;
-
-      if (refs == xine_refs_get (&this->num_speed_changes)) {
-        double pts_calc;
-        pts_calc  = (tv.tv_sec - v.cur_time.tv_sec) * v.speed_factor_1;
-        pts_calc += ((int32_t)tv.tv_usec - (int32_t)v.cur_time.tv_usec) * v.speed_factor_2;
-        pts = v.cur_pts + pts_calc;
-        return pts;
+    /* a writer holds the values for a few ns only. retry a little
+     * before queuing up on the lock behind it. */
+    int tries = 4;
+    do {
+      int refs = xine_refs_get (&this->num_speed_changes);
+      if (refs & 1) {
+        /* TJ. no change in progress, try a snapshot without lock first.
+         * the "volatile" is there to stop compiler from reordering code.
+         * tested with gcc -O3 -S 4.5/x86-32 and 7/x86-64.
+         * there is a point where all optimization falls over into chaos.
+         * we are getting closer ;-)
+         * the fence does the same for weakly ordered cpus. */
+        volatile unixscr_values_t v = this->v;
+
+        XINE_ATFENCE_READ ();
+        if (refs == xine_refs_get (&this->num_speed_changes)) {
+          double pts_calc;
+          pts_calc  = (tv.tv_sec - v.cur_time.tv_sec) * v.speed_factor_1;
+          pts_calc += ((int32_t)tv.tv_usec - (int32_t)v.cur_time.tv_usec) * v.speed_factor_2;
+          pts = v.cur_pts + pts_calc;
+          return pts;
+        }
       }
-    }
+    } while (--tries > 0);
   }
 #endif
   xine_rwlock_rdlock (&this->lock);
@@ -288,6 +295,21 @@ typedef struct {
   int                     speed_change_used;
   xine_speed_change_cb_t *speed_change_callbacks[MAX_SPEED_CHANGE_CALLBACKS + 1];
   void                   *speed_change_data[MAX_SPEED_CHANGE_CALLBACKS + 1];
+  /* CLOCK_FREE_RUN: the clock does not follow wall time, but steps to the lowest
+   * vpts the registered outputs want to release next. */
+  struct {
+    pthread_mutex_t       mutex;
+    pthread_cond_t        advance;
+#if (HAVE_ATOMIC_VARS > 0)
+    /* enabled and vpts sequence counter for lock free get_current_time (). */
+    xine_refs_t           seq;
+#endif
+    int                   enabled;
+    int                   used;
+    int                   kick;
+    int64_t               vpts;
+    int64_t               want[XINE_FREERUN_MAX_CLIENTS];
+  }                freerun;
 } metronom_clock_private_t;
 
 static void metronom_register_speed_change_callback (metronom_clock_t *this,
@@ -331,12 +353,61 @@ static void metronom_unregister_speed_change_callback (metronom_clock_t *this,
 #define STOP_PTS ~0
 #define MASK_PTS (1 << 19) /* 5.825 s */
 
+#if (HAVE_ATOMIC_VARS > 0)
+static void metronom_freerun_seq_dummy (void *object) {
+  (void)object;
+}
+#endif
+
+/* call with freerun.mutex held. */
+static void metronom_freerun_set (metronom_clock_private_t *this_priv, int enabled, int64_t vpts) {
+#if (HAVE_ATOMIC_VARS > 0)
+  xine_refs_add (&this_priv->freerun.seq, 1);
+  this_priv->freerun.enabled = enabled;
+  this_priv->freerun.vpts = vpts;
+  xine_refs_add (&this_priv->freerun.seq, 1);
+#else
+  this_priv->freerun.enabled = enabled;
+  this_priv->freerun.vpts = vpts;
+#endif
+}
+
+/* get enabled and vpts as 1 snapshot, lock free if possible. */
+static int metronom_freerun_get (metronom_clock_private_t *this_priv, int64_t *vpts) {
+  int enabled;
+#if (HAVE_ATOMIC_VARS > 0)
+  int tries = 4;
+  do {
+    int seq = xine_refs_get (&this_priv->freerun.seq);
+    if (seq & 1) {
+      enabled = *(volatile int *)&this_priv->freerun.enabled;
+      *vpts = *(volatile int64_t *)&this_priv->freerun.vpts;
+      XINE_ATFENCE_READ ();
+      if (seq == xine_refs_get (&this_priv->freerun.seq))
+        return enabled;
+    }
+  } while (--tries > 0);
+#endif
+  pthread_mutex_lock (&this_priv->freerun.mutex);
+  enabled = this_priv->freerun.enabled;
+  *vpts = this_priv->freerun.vpts;
+  pthread_mutex_unlock (&this_priv->freerun.mutex);
+  return enabled;
+}
+
 static void metronom_start_clock (metronom_clock_t *this, int64_t pts) {
   metronom_clock_private_t *this_priv = (metronom_clock_private_t *)this;
   scr_plugin_t **r;
 
   lprintf("start_clock (at %" PRId64 ")\n", pts);
 
+  pthread_mutex_lock (&this_priv->freerun.mutex);
+  if (this_priv->freerun.enabled) {
+    metronom_freerun_set (this_priv, 1, pts);
+    pthread_cond_broadcast (&this_priv->freerun.advance);
+  }
+  pthread_mutex_unlock (&this_priv->freerun.mutex);
+
   if (this_priv->next_sync_pts != STOP_PTS)
     this_priv->next_sync_pts = (int)pts & MASK_PTS;
 
@@ -350,9 +421,14 @@ static void metronom_start_clock (metronom_clock_t *this, int64_t pts) {
 
 static int64_t metronom_get_current_time (metronom_clock_t *this) {
   metronom_clock_private_t *this_priv = (metronom_clock_private_t *)this;
-  int64_t pts = this_priv->mct.scr_master->get_current (this_priv->mct.scr_master);
+  int64_t pts;
   scr_plugin_t **r;
 
+  if (metronom_freerun_get (this_priv, &pts))
+    return pts;
+
+  pts = this_priv->mct.scr_master->get_current (this_priv->mct.scr_master);
+
   /* sync not needed or done by separate thread */
   if (((int)pts & MASK_PTS) != this_priv->next_sync_pts)
     return pts;
@@ -403,6 +479,132 @@ static void metronom_adjust_clock(metronom_clock_t *this, int64_t desired_pts) {
     this_priv->next_sync_pts = (int)desired_pts & MASK_PTS;
 }
 
+/* free running clock. */
+
+static void metronom_set_freerun (metronom_clock_private_t *this_priv, int on) {
+  scr_plugin_t **r;
+  int64_t pts;
+
+  on = !!on;
+  if (on) {
+    /* continue from where the real clock is now. */
+    pts = this_priv->mct.scr_master->get_current (this_priv->mct.scr_master);
+    pthread_mutex_lock (&this_priv->freerun.mutex);
+    if (this_priv->freerun.enabled) {
+      pthread_mutex_unlock (&this_priv->freerun.mutex);
+      return;
+    }
+    metronom_freerun_set (this_priv, 1, pts);
+    pthread_mutex_unlock (&this_priv->freerun.mutex);
+  } else {
+    pthread_mutex_lock (&this_priv->freerun.mutex);
+    if (!this_priv->freerun.enabled) {
+      pthread_mutex_unlock (&this_priv->freerun.mutex);
+      return;
+    }
+    pts = this_priv->freerun.vpts;
+    metronom_freerun_set (this_priv, 0, pts);
+    pthread_cond_broadcast (&this_priv->freerun.advance);
+    pthread_mutex_unlock (&this_priv->freerun.mutex);
+    /* and let the real clock continue from here. */
+    for (r = this_priv->providers; *r && (r < this_priv->providers + MAX_SCR_PROVIDERS); r++)
+      (*r)->adjust (*r, pts);
+  }
+  xprintf (this_priv->mct.xine, XINE_VERBOSITY_DEBUG,
+    "metronom: free running clock %s at %" PRId64 ".\n", on ? "on" : "off", pts);
+}
+
+int xine_freerun_register (metronom_clock_t *this) {
+  metronom_clock_private_t *this_priv = (metronom_clock_private_t *)this;
+  int i;
+
+  pthread_mutex_lock (&this_priv->freerun.mutex);
+  for (i = 0; i < XINE_FREERUN_MAX_CLIENTS; i++) {
+    if (!(this_priv->freerun.used & (1 << i))) {
+      this_priv->freerun.used |= 1 << i;
+      this_priv->freerun.want[i] = XINE_FREERUN_IDLE;
+      break;
+    }
+  }
+  pthread_mutex_unlock (&this_priv->freerun.mutex);
+  return i < XINE_FREERUN_MAX_CLIENTS ? i : -1;
+}
+
+void xine_freerun_unregister (metronom_clock_t *this, int client) {
+  metronom_clock_private_t *this_priv = (metronom_clock_private_t *)this;
+
+  if ((client < 0) || (client >= XINE_FREERUN_MAX_CLIENTS))
+    return;
+  /* let the others go on without us. */
+  xine_freerun_want (this, client, XINE_FREERUN_IDLE, 0);
+  pthread_mutex_lock (&this_priv->freerun.mutex);
+  this_priv->freerun.used &= ~(1 << client);
+  this_priv->freerun.kick &= ~(1 << client);
+  pthread_mutex_unlock (&this_priv->freerun.mutex);
+}
+
+void xine_freerun_kick (metronom_clock_t *this, int client) {
+  metronom_clock_private_t *this_priv = (metronom_clock_private_t *)this;
+
+  if ((client < 0) || (client >= XINE_FREERUN_MAX_CLIENTS))
+    return;
+  pthread_mutex_lock (&this_priv->freerun.mutex);
+  this_priv->freerun.kick |= 1 << client;
+  pthread_cond_broadcast (&this_priv->freerun.advance);
+  pthread_mutex_unlock (&this_priv->freerun.mutex);
+}
+
+int64_t xine_freerun_want (metronom_clock_t *this, int client, int64_t vpts, int timeout_us) {
+  metronom_clock_private_t *this_priv = (metronom_clock_private_t *)this;
+  int64_t min;
+  int i;
+
+  if ((client < 0) || (client >= XINE_FREERUN_MAX_CLIENTS))
+    return this->get_current_time (this);
+
+  pthread_mutex_lock (&this_priv->freerun.mutex);
+  this_priv->freerun.want[client] = vpts;
+  if (!this_priv->freerun.enabled) {
+    this_priv->freerun.kick &= ~(1 << client);
+    pthread_mutex_unlock (&this_priv->freerun.mutex);
+    return this->get_current_time (this);
+  }
+  /* step to the lowest wanted vpts, but never go back. */
+  min = XINE_FREERUN_IDLE;
+  for (i = 0; i < XINE_FREERUN_MAX_CLIENTS; i++) {
+    if ((this_priv->freerun.used & (1 << i)) && (this_priv->freerun.want[i] < min))
+      min = this_priv->freerun.want[i];
+  }
+  if ((min != XINE_FREERUN_IDLE) && (min > this_priv->freerun.vpts)) {
+    metronom_freerun_set (this_priv, 1, min);
+    pthread_cond_broadcast (&this_priv->freerun.advance);
+  }
+  /* wait for the others to catch up. */
+  if ((vpts != XINE_FREERUN_IDLE) && (vpts > this_priv->freerun.vpts) && timeout_us) {
+    struct timespec ts = {0, 0};
+    if (timeout_us > 0) {
+      xine_gettime (&ts);
+      ts.tv_sec  += timeout_us / 1000000;
+      ts.tv_nsec += (timeout_us % 1000000) * 1000;
+      if (ts.tv_nsec >= 1000000000) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000;
+      }
+    }
+    while (this_priv->freerun.enabled && (vpts > this_priv->freerun.vpts)
+      && !(this_priv->freerun.kick & (1 << client))) {
+      if (timeout_us < 0)
+        pthread_cond_wait (&this_priv->freerun.advance, &this_priv->freerun.mutex);
+      else if (pthread_cond_timedwait (&this_priv->freerun.advance, &this_priv->freerun.mutex, &ts))
+        break;
+    }
+  }
+  this_priv->freerun.kick &= ~(1 << client);
+  min = this_priv->freerun.vpts;
+  pthread_mutex_unlock (&this_priv->freerun.mutex);
+  return min;
+}
+
 static int metronom_set_speed (metronom_clock_t *this, int speed) {
   metronom_clock_private_t *this_priv = (metronom_clock_private_t *)this;
   scr_plugin_t **r;
@@ -1317,6 +1519,11 @@ static void metronom_set_option (metronom_t *this_gen, int option, int64_t value
 static void metronom_clock_set_option (metronom_clock_t *this,
 					int option, int64_t value) {
 
+  if (option == CLOCK_FREE_RUN) {
+    metronom_set_freerun ((metronom_clock_private_t *)this, value);
+    return;
+  }
+
   pthread_mutex_lock (&this->lock);
 
   switch (option) {
@@ -1399,6 +1606,10 @@ static int64_t metronom_clock_get_option (metronom_clock_t *this, int option) {
   switch (option) {
   case CLOCK_SCR_ADJUSTABLE:
     return this->scr_adjustable;
+  case CLOCK_FREE_RUN: {
+    int64_t vpts;
+    return metronom_freerun_get ((metronom_clock_private_t *)this, &vpts);
+  }
   }
   xprintf (this->xine, XINE_VERBOSITY_NONE,
     "metronom: unknown option in get_option: %d.\n", option);
@@ -1610,6 +1821,8 @@ static void metronom_clock_exit (metronom_clock_t *this) {
   pthread_mutex_unlock (&this_priv->mct.lock);
 
   pthread_mutex_destroy (&this_priv->mct.lock);
+  pthread_cond_destroy (&this_priv->freerun.advance);
+  pthread_mutex_destroy (&this_priv->freerun.mutex);
   free (this_priv);
 }
 
@@ -1734,6 +1947,9 @@ metronom_clock_t *_x_metronom_clock_init(xine_t *xine)
 #ifndef HAVE_ZERO_SAFE_MEM
   this_priv->speed_change_used = 0;
   this_priv->speed_change_callbacks[0] = NULL;
+  this_priv->freerun.enabled = 0;
+  this_priv->freerun.used = 0;
+  this_priv->freerun.kick = 0;
 #endif
 
   this_priv->mct.set_option       = metronom_clock_set_option;
@@ -1756,6 +1972,11 @@ metronom_clock_t *_x_metronom_clock_init(xine_t *xine)
   this_priv->mct.scr_list         = this_priv->providers;
 
   pthread_mutex_init (&this_priv->mct.lock, NULL);
+  pthread_mutex_init (&this_priv->freerun.mutex, NULL);
+  pthread_cond_init (&this_priv->freerun.advance, NULL);
+#if (HAVE_ATOMIC_VARS > 0)
+  xine_refs_init (&this_priv->freerun.seq, metronom_freerun_seq_dummy, this_priv);
+#endif
   this_priv->mct.register_scr (&this_priv->mct, unixscr_init (&this_priv->uscr));
 
   this_priv->mct.thread_running   = 0;
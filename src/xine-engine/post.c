@@ -98,7 +98,229 @@ static void post_free_unused_video_alias (post_video_port_t *port, vf_alias_t *f
   }
 }
 
-static vo_frame_t *post_intercept_video_frame (post_video_port_t *port, vo_frame_t *frame, vf_alias_t *new_frame, int usage) {
+/* Pipelined mode: a port with its own draw () gets a stage thread that runs
+   it. The caller just queues the frame with an extra lock, and returns the
+   skip value of the previous frame. Each stage keeps the order of its frames,
+   so vpts stay in order along the chain. */
+#define POST_PIPE_FRAMES 2
+
+typedef struct {
+  vo_frame_t      *frame;
+  xine_stream_t   *stream;
+  int            (*draw) (vo_frame_t *vo_img, xine_stream_t *stream);
+} post_pipe_entry_t;
+
+typedef struct post_pipe_s {
+  pthread_mutex_t    lock;
+  pthread_cond_t     wake;   /* stage thread waits here */
+  pthread_cond_t     space;  /* callers wait here */
+  xine_ticket_t     *ticket;
+  int                first, used, busy;
+  int                skip;
+  int                quit;
+  int                refs;   /* the port, and the thread */
+  post_pipe_entry_t  queue[POST_PIPE_FRAMES];
+} post_pipe_t;
+
+static void post_pipe_unref (post_pipe_t *pipe) {
+  int refs;
+
+  pthread_mutex_lock (&pipe->lock);
+  refs = --pipe->refs;
+  pthread_mutex_unlock (&pipe->lock);
+  if (!refs) {
+    pthread_cond_destroy (&pipe->space);
+    pthread_cond_destroy (&pipe->wake);
+    pthread_mutex_destroy (&pipe->lock);
+    free (pipe);
+  }
+}
+
+static void *post_pipe_loop (void *data) {
+  post_pipe_t *pipe = (post_pipe_t *)data;
+
+  pthread_mutex_lock (&pipe->lock);
+  while (1) {
+    post_pipe_entry_t e;
+    int skip;
+
+    if (!pipe->used) {
+      if (pipe->quit)
+        break;
+      pthread_cond_wait (&pipe->wake, &pipe->lock);
+      continue;
+    }
+    e = pipe->queue[pipe->first];
+    pipe->first = (pipe->first + 1) % POST_PIPE_FRAMES;
+    pipe->used--;
+    pipe->busy = 1;
+    pthread_cond_broadcast (&pipe->space);
+    pthread_mutex_unlock (&pipe->lock);
+    /* this may free the port, dont touch it afterwards. */
+    pipe->ticket->acquire (pipe->ticket, 0);
+    skip = e.draw (e.frame, e.stream);
+    e.frame->free (e.frame);
+    pipe->ticket->release (pipe->ticket, 0);
+    pthread_mutex_lock (&pipe->lock);
+    pipe->skip = skip;
+    pipe->busy = 0;
+    pthread_cond_broadcast (&pipe->space);
+  }
+  pthread_mutex_unlock (&pipe->lock);
+  post_pipe_unref (pipe);
+  return NULL;
+}
+
+static int post_pipe_enabled (post_video_port_t *port) {
+  xine_private_t *xine = (xine_private_t *)port->post->xine;
+
+  return xine && xine->post_pipeline && (xine_cpu_count () > 1);
+}
+
+static post_pipe_t *post_pipe_get (post_video_port_t *port) {
+  post_pipe_t *pipe;
+
+  pthread_mutex_lock (&port->usage_lock);
+  pipe = port->pipe;
+  if (!pipe) {
+    pipe = calloc (1, sizeof (*pipe));
+    if (pipe) {
+      pthread_attr_t attr;
+      pthread_t thread;
+      int err;
+
+      pthread_mutex_init (&pipe->lock, NULL);
+      pthread_cond_init (&pipe->wake, NULL);
+      pthread_cond_init (&pipe->space, NULL);
+      pipe->ticket = port->post->running_ticket;
+      pipe->refs = 2;
+      pthread_attr_init (&attr);
+      pthread_attr_setdetachstate (&attr, PTHREAD_CREATE_DETACHED);
+      err = pthread_create (&thread, &attr, post_pipe_loop, pipe);
+      pthread_attr_destroy (&attr);
+      if (err) {
+        xprintf (port->post->xine, XINE_VERBOSITY_LOG,
+          "post: cannot start pipeline thread (%d), drawing directly.\n", err);
+        pthread_cond_destroy (&pipe->space);
+        pthread_cond_destroy (&pipe->wake);
+        pthread_mutex_destroy (&pipe->lock);
+        free (pipe);
+        pipe = NULL;
+      } else {
+        port->pipe = pipe;
+      }
+    }
+  }
+  pthread_mutex_unlock (&port->usage_lock);
+  return pipe;
+}
+
+/* call with pipe->lock held. */
+static void post_pipe_wait (post_pipe_t *pipe, post_plugin_t *post) {
+  struct timespec ts = {0, 0};
+
+  xine_gettime (&ts);
+  ts.tv_nsec += 20000000;
+  if (ts.tv_nsec >= 1000000000) {
+    ts.tv_nsec -= 1000000000;
+    ts.tv_sec += 1;
+  }
+  pthread_cond_timedwait (&pipe->space, &pipe->lock, &ts);
+  if (post && pipe->ticket->ticket_revoked) {
+    /* let a pause or rewire pass while the stage thread is held up. */
+    pthread_mutex_unlock (&pipe->lock);
+    _x_post_rewire (post);
+    pthread_mutex_lock (&pipe->lock);
+  }
+}
+
+static int post_pipe_queue (vo_frame_t *vo_img, xine_stream_t *stream,
+  int (*draw) (vo_frame_t *vo_img, xine_stream_t *stream)) {
+  post_video_port_t *port = _x_post_video_frame_to_port (vo_img);
+  post_pipe_t *pipe = post_pipe_get (port);
+  post_pipe_entry_t *e;
+  int skip;
+
+  if (!pipe)
+    return draw (vo_img, stream);
+
+  /* the stage thread frees this again. */
+  vo_img->lock (vo_img);
+  pthread_mutex_lock (&pipe->lock);
+  while (pipe->used >= POST_PIPE_FRAMES)
+    post_pipe_wait (pipe, port->post);
+  e = &pipe->queue[(pipe->first + pipe->used) % POST_PIPE_FRAMES];
+  e->frame  = vo_img;
+  e->stream = stream;
+  e->draw   = draw;
+  pipe->used++;
+  pthread_cond_signal (&pipe->wake);
+  skip = pipe->skip;
+  pthread_mutex_unlock (&pipe->lock);
+  return skip;
+}
+
+static int post_frame_pipe_draw (vo_frame_t *vo_img, xine_stream_t *stream) {
+  post_video_port_t *port = _x_post_video_frame_to_port (vo_img);
+
+  return post_pipe_queue (vo_img, stream, port->new_frame->draw);
+}
+
+/* a frame this port does not filter still must not overtake the ones in the pipe. */
+static int post_frame_pipe_pass (vo_frame_t *vo_img, xine_stream_t *stream) {
+  return post_pipe_queue (vo_img, stream, post_frame_draw);
+}
+
+/* drop frames not yet drawn. */
+static void post_pipe_discard (post_video_port_t *port) {
+  post_pipe_t *pipe = port->pipe;
+  vo_frame_t *frames[POST_PIPE_FRAMES];
+  int i, n = 0;
+
+  if (!pipe)
+    return;
+  pthread_mutex_lock (&pipe->lock);
+  while (pipe->used) {
+    frames[n++] = pipe->queue[pipe->first].frame;
+    pipe->first = (pipe->first + 1) % POST_PIPE_FRAMES;
+    pipe->used--;
+  }
+  pthread_cond_broadcast (&pipe->space);
+  pthread_mutex_unlock (&pipe->lock);
+  for (i = 0; i < n; i++)
+    frames[i]->free (frames[i]);
+}
+
+/* let queued frames through, unless the engine wants to pause or rewire. */
+static void post_pipe_drain (post_video_port_t *port) {
+  post_pipe_t *pipe = port->pipe;
+
+  if (!pipe)
+    return;
+  pthread_mutex_lock (&pipe->lock);
+  while ((pipe->used || pipe->busy) && !pipe->ticket->ticket_revoked)
+    post_pipe_wait (pipe, NULL);
+  pthread_mutex_unlock (&pipe->lock);
+  post_pipe_discard (port);
+}
+
+static void post_pipe_stop (post_pipe_t *pipe) {
+  pthread_mutex_lock (&pipe->lock);
+  pipe->quit = 1;
+  pthread_cond_signal (&pipe->wake);
+  pthread_mutex_unlock (&pipe->lock);
+  post_pipe_unref (pipe);
+}
+
+/* once a port pipes, all its frames take that way, in order. */
+static int post_pipe_wanted (post_video_port_t *port) {
+  return port->pipe || (port->new_frame->draw && post_pipe_enabled (port));
+}
+
+/* pass: not filtered by this port, just keep it in line with the pipe. */
+static vo_frame_t *post_intercept_video_frame (post_video_port_t *port, vo_frame_t *frame, vf_alias_t *new_frame, int usage, int pass) {
+  static const vo_frame_t no_funcs;
+  const vo_frame_t *funcs = pass ? &no_funcs : port->new_frame;
 
   if (usage && port->frame_lock)
     pthread_mutex_lock (port->frame_lock);
@@ -109,13 +331,17 @@ static vo_frame_t *post_intercept_video_frame (post_video_port_t *port, vo_frame
 
   /* modify the frame with the intercept functions */
   new_frame->frame.port       = &port->new_port;
-  new_frame->frame.proc_frame = port->new_frame->proc_frame ? port->new_frame->proc_frame : NULL;
-  new_frame->frame.proc_slice = port->new_frame->proc_slice ? port->new_frame->proc_slice : NULL;
-  new_frame->frame.field      = port->new_frame->field      ? port->new_frame->field      : post_frame_field;
-  new_frame->frame.draw       = port->new_frame->draw       ? port->new_frame->draw       : post_frame_draw;
-  new_frame->frame.lock       = port->new_frame->lock       ? port->new_frame->lock       : post_frame_lock;
-  new_frame->frame.free       = port->new_frame->free       ? port->new_frame->free       : post_frame_free;
-  new_frame->frame.dispose    = port->new_frame->dispose    ? port->new_frame->dispose    : post_frame_dispose;
+  new_frame->frame.proc_frame = funcs->proc_frame ? funcs->proc_frame : NULL;
+  new_frame->frame.proc_slice = funcs->proc_slice ? funcs->proc_slice : NULL;
+  new_frame->frame.field      = funcs->field      ? funcs->field      : post_frame_field;
+  new_frame->frame.draw       = funcs->draw       ? funcs->draw       : post_frame_draw;
+  new_frame->frame.lock       = funcs->lock       ? funcs->lock       : post_frame_lock;
+  new_frame->frame.free       = funcs->free       ? funcs->free       : post_frame_free;
+  new_frame->frame.dispose    = funcs->dispose    ? funcs->dispose    : post_frame_dispose;
+  if (pass)
+    new_frame->frame.draw     = post_frame_pipe_pass;
+  else if (funcs->draw && post_pipe_wanted (port))
+    new_frame->frame.draw     = post_frame_pipe_draw;
 
   /* Optimization: dont NULL stream ref, will often be reused later */
   if ((new_frame->frame.free == post_frame_free) &&
@@ -130,7 +356,7 @@ static vo_frame_t *post_intercept_video_frame (post_video_port_t *port, vo_frame
     new_frame->stream = new_frame->frame.stream;
   }
 
-  if (!port->new_frame->draw || (port->route_preprocessing_procs && port->route_preprocessing_procs(port, frame))) {
+  if (!funcs->draw || (!pass && port->route_preprocessing_procs && port->route_preprocessing_procs(port, frame))) {
     /* draw will most likely modify the frame, so the decoder
      * should only request preprocessing when there is no new draw
      * but route_preprocessing_procs() can override this decision */
@@ -323,18 +549,34 @@ static vo_frame_t *post_video_get_frame(xine_video_port_t *port_gen, uint32_t wi
     uint32_t height, double ratio, int format, int flags) {
   post_video_port_t *port = (post_video_port_t *)port_gen;
   vo_frame_t *frame;
+  vf_alias_t *alias;
+
+  if (port->bypass && !post_pipe_wanted (port)) {
+    /* The plugin is transparent for now. Hand out the original frame,
+     * and save the alias, the frame lock, and the draw () detour. */
+    _x_post_inc_usage (port);
+    if (port->port_lock) pthread_mutex_lock(port->port_lock);
+    frame = port->original_port->get_frame(port->original_port,
+      width, height, ratio, format, flags);
+    if (port->port_lock) pthread_mutex_unlock(port->port_lock);
+    _x_post_dec_usage (port);
+    return frame;
+  }
+
   /* We always need to ref this port here to protect it from
    * possible port rewiring inside get_frame ().
    * In the intercept case, we save an extra unref. */
-  vf_alias_t *alias = post_new_video_alias (port, 1);
+  alias = post_new_video_alias (port, 1);
 
   if (port->port_lock) pthread_mutex_lock(port->port_lock);
   frame = port->original_port->get_frame(port->original_port,
     width, height, ratio, format, flags);
   if (port->port_lock) pthread_mutex_unlock(port->port_lock);
 
-  if (frame && (!port->intercept_frame || port->intercept_frame(port, frame))) {
-    frame = post_intercept_video_frame (port, frame, alias, 1);
+  if (frame && !port->bypass && (!port->intercept_frame || port->intercept_frame(port, frame))) {
+    frame = post_intercept_video_frame (port, frame, alias, 1, 0);
+  } else if (frame && post_pipe_wanted (port)) {
+    frame = post_intercept_video_frame (port, frame, alias, 1, 1);
   } else {
     post_free_unused_video_alias (port, alias);
   }
@@ -374,6 +616,7 @@ static void post_video_close(xine_video_port_t *port_gen, xine_stream_t *stream)
   post_video_port_t *port = (post_video_port_t *)port_gen;
   vf_alias_t *f;
 
+  post_pipe_drain (port);
   if (port->port_lock) pthread_mutex_lock(port->port_lock);
   port->original_port->close(port->original_port, stream);
   if (port->port_lock) pthread_mutex_unlock(port->port_lock);
@@ -426,6 +669,7 @@ static video_overlay_manager_t *post_video_get_overlay_manager(xine_video_port_t
 static void post_video_flush(xine_video_port_t *port_gen) {
   post_video_port_t *port = (post_video_port_t *)port_gen;
 
+  post_pipe_discard (port);
   if (port->port_lock) pthread_mutex_lock(port->port_lock);
   port->original_port->flush(port->original_port);
   if (port->port_lock) pthread_mutex_unlock(port->port_lock);
@@ -650,7 +894,7 @@ static void post_frame_dispose(vo_frame_t *vo_img) {
 
 vo_frame_t *_x_post_intercept_video_frame(vo_frame_t *frame, post_video_port_t *port) {
   vf_alias_t *alias = post_new_video_alias (port, 0);
-  return post_intercept_video_frame (port, frame, alias, 0);
+  return post_intercept_video_frame (port, frame, alias, 0, 0);
 }
 
 vo_frame_t *_x_post_restore_video_frame(vo_frame_t *frame, post_video_port_t *port) {
@@ -1115,6 +1359,9 @@ int _x_post_dispose(post_plugin_t *this) {
             xprintf (this->xine, XINE_VERBOSITY_DEBUG, "post: freed %d video frame aliases.\n", n);
           }
 
+          if (port->pipe)
+            post_pipe_stop (port->pipe);
+
           NAILS_S (port, 0x53);
           NAILS_S (input, 0x54);
 	  free(port);
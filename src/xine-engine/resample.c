@@ -22,10 +22,13 @@
 #include "config.h"
 #endif
 
+#include <stdlib.h>
 #include <string.h>
 #include <inttypes.h>
+#include <math.h>
 #include <xine/attributes.h>
 #include <xine/resample.h>
+#include <xine/xineutils.h>
 
 /* contributed by paul flinders */
 
@@ -359,3 +362,570 @@ void _x_audio_out_resample_stereotomono(int16_t* input_samples,
     *output_samples++ = os;
   }
 }
+
+void _x_audio_out_resample_s16tofloat (const int16_t *input_samples,
+                                       float *output_samples, uint32_t samples)
+{
+  const float scale = 1.0f / 32768.0f;
+#if defined(ARCH_X86) && !defined(_MSC_VER)
+  if ((xine_mm_accel () & MM_ACCEL_X86_SSE2) && (samples >= 8)) {
+    static const float sscale[4] ATTR_ALIGN(16) = {
+      1.0f / 32768.0f, 1.0f / 32768.0f, 1.0f / 32768.0f, 1.0f / 32768.0f
+    };
+    uint32_t n = samples & ~7u;
+    __asm__ __volatile__ (
+      "movups\t%3, %%xmm7\n"
+      "1:\n\t"
+      "movdqu\t(%0), %%xmm0\n\t"
+      "punpcklwd\t%%xmm0, %%xmm1\n\t"
+      "punpckhwd\t%%xmm0, %%xmm2\n\t"
+      "psrad\t$16, %%xmm1\n\t"
+      "psrad\t$16, %%xmm2\n\t"
+      "cvtdq2ps\t%%xmm1, %%xmm1\n\t"
+      "cvtdq2ps\t%%xmm2, %%xmm2\n\t"
+      "mulps\t%%xmm7, %%xmm1\n\t"
+      "mulps\t%%xmm7, %%xmm2\n\t"
+      "movups\t%%xmm1, (%1)\n\t"
+      "movups\t%%xmm2, 16(%1)\n\t"
+      "add\t$16, %0\n\t"
+      "add\t$32, %1\n\t"
+      "sub\t$8, %2\n\t"
+      "jnz\t1b"
+      : "+r" (input_samples), "+r" (output_samples), "+r" (n)
+      : "m" (sscale[0])
+      : "xmm0", "xmm1", "xmm2", "xmm7", "cc", "memory");
+    samples &= 7;
+  }
+#endif
+  while (samples--)
+    *output_samples++ = (float)*input_samples++ * scale;
+}
+
+void _x_audio_out_resample_floattos16 (const float *input_samples,
+                                       int16_t *output_samples, uint32_t samples)
+{
+#if defined(ARCH_X86) && !defined(_MSC_VER)
+  if ((xine_mm_accel () & MM_ACCEL_X86_SSE2) && (samples >= 8)) {
+    /* clip before cvtps2dq, it turns overflows into INT32_MIN. */
+    static const float sconst[3][4] ATTR_ALIGN(16) = {
+      { 32768.0f,  32768.0f,  32768.0f,  32768.0f},
+      { 32767.0f,  32767.0f,  32767.0f,  32767.0f},
+      {-32768.0f, -32768.0f, -32768.0f, -32768.0f}
+    };
+    uint32_t n = samples & ~7u;
+    __asm__ __volatile__ (
+      "movups\t%3, %%xmm5\n\t"
+      "movups\t%4, %%xmm6\n\t"
+      "movups\t%5, %%xmm7\n"
+      "1:\n\t"
+      "movups\t(%0), %%xmm0\n\t"
+      "movups\t16(%0), %%xmm1\n\t"
+      "mulps\t%%xmm5, %%xmm0\n\t"
+      "mulps\t%%xmm5, %%xmm1\n\t"
+      "minps\t%%xmm6, %%xmm0\n\t"
+      "minps\t%%xmm6, %%xmm1\n\t"
+      "maxps\t%%xmm7, %%xmm0\n\t"
+      "maxps\t%%xmm7, %%xmm1\n\t"
+      "cvtps2dq\t%%xmm0, %%xmm0\n\t"
+      "cvtps2dq\t%%xmm1, %%xmm1\n\t"
+      "packssdw\t%%xmm1, %%xmm0\n\t"
+      "movdqu\t%%xmm0, (%1)\n\t"
+      "add\t$32, %0\n\t"
+      "add\t$16, %1\n\t"
+      "sub\t$8, %2\n\t"
+      "jnz\t1b"
+      : "+r" (input_samples), "+r" (output_samples), "+r" (n)
+      : "m" (sconst[0][0]), "m" (sconst[1][0]), "m" (sconst[2][0])
+      : "xmm0", "xmm1", "xmm5", "xmm6", "xmm7", "cc", "memory");
+    samples &= 7;
+  }
+#endif
+  while (samples--) {
+    int v = lrintf (*input_samples++ * 32768.0f);
+    *output_samples++ = v > 32767 ? 32767 : v < -32768 ? -32768 : v;
+  }
+}
+
+void _x_audio_out_resample_floattos24 (const float *input_samples,
+                                       uint8_t *output_samples, uint32_t samples)
+{
+  while (samples--) {
+    float f = *input_samples++ * 8388608.0f;
+    int32_t v = f >= 8388607.0f ? 8388607 : f <= -8388608.0f ? -8388608 : lrintf (f);
+#ifdef WORDS_BIGENDIAN
+    output_samples[0] = v >> 16;
+    output_samples[1] = v >> 8;
+    output_samples[2] = v;
+#else
+    output_samples[0] = v;
+    output_samples[1] = v >> 8;
+    output_samples[2] = v >> 16;
+#endif
+    output_samples += 3;
+  }
+}
+
+void _x_audio_out_resample_monotostereo_float (const float *input_samples,
+                                               float *output_samples, uint32_t frames)
+{
+  while (frames--) {
+    float os = *input_samples++;
+    *output_samples++ = os;
+    *output_samples++ = os;
+  }
+}
+
+void _x_audio_out_resample_stereotomono_float (const float *input_samples,
+                                               float *output_samples, uint32_t frames)
+{
+  while (frames--) {
+    *output_samples++ = (input_samples[0] + input_samples[1]) * 0.5f;
+    input_samples += 2;
+  }
+}
+
+/*
+ * polyphase resampler.
+ *
+ * the input is kept as 1 float plane per channel, with (taps) frames of
+ * history in front. an output frame at input position p = i + f (0 <= f < 1)
+ * is the dot product of plane[i + 1 ... i + taps] and a windowed sinc
+ * centered at i + taps / 2 + f. coefficient rows are tabulated for
+ * RS_PHASES values of f, and linearly interpolated in between.
+ */
+
+#define RS_PHASE_BITS 8
+#define RS_PHASES     (1 << RS_PHASE_BITS)
+#define RS_FRAC_BITS  (32 - RS_PHASE_BITS)
+
+struct xine_resampler_s {
+  int       channels;
+  int       quality;
+  int       taps;
+  /* current anti aliasing filter */
+  uint32_t  in_rate, out_rate;
+  /* (RS_PHASES + 1) rows of (taps) coefficients followed by (taps) deltas to the next row */
+  float    *table;
+  float    *coef;
+  /* channels * plane_size */
+  float    *planes;
+  uint32_t  plane_size;
+  void    (*get_coef) (float *coef, const float *row, float a, intptr_t n);
+  float   (*dot) (const float *x, const float *coef, intptr_t n);
+};
+
+static void rs_get_coef_c (float *coef, const float *row, float a, intptr_t n) {
+  const float *delta = row + n;
+  intptr_t m;
+  for (m = 0; m < n; m++)
+    coef[m] = row[m] + a * delta[m];
+}
+
+static float rs_dot_c (const float *x, const float *coef, intptr_t n) {
+  float s0 = 0.0f, s1 = 0.0f, s2 = 0.0f, s3 = 0.0f;
+  intptr_t m;
+  for (m = 0; m < n; m += 4) {
+    s0 += x[m] * coef[m];
+    s1 += x[m + 1] * coef[m + 1];
+    s2 += x[m + 2] * coef[m + 2];
+    s3 += x[m + 3] * coef[m + 3];
+  }
+  return (s0 + s1) + (s2 + s3);
+}
+
+#if defined(ARCH_X86) && !defined(_MSC_VER)
+/* these need n to be a multiple of 16, and aligned row and coef. */
+
+static void rs_get_coef_sse (float *coef, const float *row, float a, intptr_t n) {
+  __asm__ __volatile__ (
+    "movss\t%4, %%xmm7\n\t"
+    "shufps\t$0, %%xmm7, %%xmm7\n"
+    "1:\n\t"
+    "movaps\t(%1,%3), %%xmm0\n\t"
+    "movaps\t16(%1,%3), %%xmm1\n\t"
+    "mulps\t%%xmm7, %%xmm0\n\t"
+    "mulps\t%%xmm7, %%xmm1\n\t"
+    "addps\t(%1), %%xmm0\n\t"
+    "addps\t16(%1), %%xmm1\n\t"
+    "movaps\t%%xmm0, (%0)\n\t"
+    "movaps\t%%xmm1, 16(%0)\n\t"
+    "add\t$32, %0\n\t"
+    "add\t$32, %1\n\t"
+    "sub\t$8, %2\n\t"
+    "jnz\t1b"
+    : "+r" (coef), "+r" (row), "+r" (n)
+    : "r" (n * sizeof (float)), "m" (a)
+    : "xmm0", "xmm1", "xmm7", "cc", "memory");
+}
+
+static float rs_dot_sse (const float *x, const float *coef, intptr_t n) {
+  float res;
+  __asm__ __volatile__ (
+    "xorps\t%%xmm0, %%xmm0\n\t"
+    "xorps\t%%xmm1, %%xmm1\n"
+    "1:\n\t"
+    "movups\t(%1), %%xmm2\n\t"
+    "movups\t16(%1), %%xmm3\n\t"
+    "mulps\t(%2), %%xmm2\n\t"
+    "mulps\t16(%2), %%xmm3\n\t"
+    "addps\t%%xmm2, %%xmm0\n\t"
+    "addps\t%%xmm3, %%xmm1\n\t"
+    "add\t$32, %1\n\t"
+    "add\t$32, %2\n\t"
+    "sub\t$8, %3\n\t"
+    "jnz\t1b\n\t"
+    "addps\t%%xmm1, %%xmm0\n\t"
+    "movhlps\t%%xmm0, %%xmm1\n\t"
+    "addps\t%%xmm1, %%xmm0\n\t"
+    "movaps\t%%xmm0, %%xmm1\n\t"
+    "shufps\t$0x55, %%xmm1, %%xmm1\n\t"
+    "addss\t%%xmm1, %%xmm0\n\t"
+    "movss\t%%xmm0, %0"
+    : "=m" (res), "+r" (x), "+r" (coef), "+r" (n)
+    :
+    : "xmm0", "xmm1", "xmm2", "xmm3", "cc", "memory");
+  return res;
+}
+
+#  ifdef HAVE_AVX
+/* plain AVX is enough for float math. */
+
+static void rs_get_coef_avx (float *coef, const float *row, float a, intptr_t n) {
+  __asm__ __volatile__ (
+    "vbroadcastss\t%4, %%ymm7\n"
+    "1:\n\t"
+    "vmulps\t(%1,%3), %%ymm7, %%ymm0\n\t"
+    "vmulps\t32(%1,%3), %%ymm7, %%ymm1\n\t"
+    "vaddps\t(%1), %%ymm0, %%ymm0\n\t"
+    "vaddps\t32(%1), %%ymm1, %%ymm1\n\t"
+    "vmovaps\t%%ymm0, (%0)\n\t"
+    "vmovaps\t%%ymm1, 32(%0)\n\t"
+    "add\t$64, %0\n\t"
+    "add\t$64, %1\n\t"
+    "sub\t$16, %2\n\t"
+    "jnz\t1b\n\t"
+    "vzeroupper"
+    : "+r" (coef), "+r" (row), "+r" (n)
+    : "r" (n * sizeof (float)), "m" (a)
+    : "xmm0", "xmm1", "xmm7", "cc", "memory");
+}
+
+static float rs_dot_avx (const float *x, const float *coef, intptr_t n) {
+  float res;
+  __asm__ __volatile__ (
+    "vxorps\t%%ymm0, %%ymm0, %%ymm0\n\t"
+    "vxorps\t%%ymm1, %%ymm1, %%ymm1\n"
+    "1:\n\t"
+    "vmovups\t(%1), %%ymm2\n\t"
+    "vmovups\t32(%1), %%ymm3\n\t"
+    "vmulps\t(%2), %%ymm2, %%ymm2\n\t"
+    "vmulps\t32(%2), %%ymm3, %%ymm3\n\t"
+    "vaddps\t%%ymm2, %%ymm0, %%ymm0\n\t"
+    "vaddps\t%%ymm3, %%ymm1, %%ymm1\n\t"
+    "add\t$64, %1\n\t"
+    "add\t$64, %2\n\t"
+    "sub\t$16, %3\n\t"
+    "jnz\t1b\n\t"
+    "vaddps\t%%ymm1, %%ymm0, %%ymm0\n\t"
+    "vextractf128\t$1, %%ymm0, %%xmm1\n\t"
+    "vaddps\t%%xmm1, %%xmm0, %%xmm0\n\t"
+    "vmovhlps\t%%xmm0, %%xmm0, %%xmm1\n\t"
+    "vaddps\t%%xmm1, %%xmm0, %%xmm0\n\t"
+    "vshufps\t$0x55, %%xmm0, %%xmm0, %%xmm1\n\t"
+    "vaddss\t%%xmm1, %%xmm0, %%xmm0\n\t"
+    "vmovss\t%%xmm0, %0\n\t"
+    "vzeroupper"
+    : "=m" (res), "+r" (x), "+r" (coef), "+r" (n)
+    :
+    : "xmm0", "xmm1", "xmm2", "xmm3", "cc", "memory");
+  return res;
+}
+#  endif /* HAVE_AVX */
+#endif /* ARCH_X86 */
+
+static double rs_bessel_i0 (double x) {
+  double sum = 1.0, term = 1.0, q = x * x * 0.25;
+  int k;
+  for (k = 1; k < 64; k++) {
+    term *= q / ((double)k * (double)k);
+    sum += term;
+    if (term < sum * 1e-12)
+      break;
+  }
+  return sum;
+}
+
+static void rs_make_table (xine_resampler_t *r) {
+  /* passband edge relative to the lower nyquist frequency, and kaiser beta. */
+  static const double rolloff[4] = {0.0, 0.84, 0.91, 0.95};
+  static const double beta[4]    = {0.0, 6.0,  8.0,  10.0};
+  const int n = r->taps, half = n >> 1;
+  double fc, ib, rows[2][64];
+  float *t = r->table;
+  int p, m;
+
+  fc = rolloff[r->quality];
+  if (r->out_rate < r->in_rate)
+    fc = fc * (double)r->out_rate / (double)r->in_rate;
+  ib = 1.0 / rs_bessel_i0 (beta[r->quality]);
+
+  for (p = 0; p <= RS_PHASES; p++) {
+    double *row = rows[p & 1], sum = 0.0;
+    double f = (double)p / (double)RS_PHASES;
+    for (m = 0; m < n; m++) {
+      /* distance from the center, in input frames. */
+      double x = (double)(m + 1 - half) - f, w, v;
+      w = x / (double)half;
+      w = 1.0 - w * w;
+      if (w <= 0.0) {
+        row[m] = 0.0;
+        continue;
+      }
+      w = rs_bessel_i0 (beta[r->quality] * sqrt (w)) * ib;
+      v = fc * x * M_PI;
+      v = (v > -1e-9) && (v < 1e-9) ? fc : fc * sin (v) / v;
+      row[m] = v * w;
+      sum += row[m];
+    }
+    /* unity dc gain for all phases. */
+    sum = sum != 0.0 ? 1.0 / sum : 0.0;
+    for (m = 0; m < n; m++) {
+      row[m] *= sum;
+      t[p * 2 * n + m] = row[m];
+    }
+    if (p > 0) {
+      double *prev = rows[(p - 1) & 1];
+      for (m = 0; m < n; m++)
+        t[(p - 1) * 2 * n + n + m] = row[m] - prev[m];
+    }
+  }
+  /* the last row is only used as a delta. */
+  memset (t + RS_PHASES * 2 * n + n, 0, n * sizeof (float));
+}
+
+xine_resampler_t *_x_audio_out_resampler_new (int channels, int quality) {
+  xine_resampler_t *r;
+
+  if ((channels < 1) || (quality < XINE_RESAMPLE_QUALITY_FAST))
+    return NULL;
+  if (quality > XINE_RESAMPLE_QUALITY_BEST)
+    quality = XINE_RESAMPLE_QUALITY_BEST;
+
+  r = calloc (1, sizeof (*r));
+  if (!r)
+    return NULL;
+  r->channels = channels;
+  r->quality  = quality;
+  r->taps     = 8 << quality;
+  r->in_rate  = r->out_rate = 1;
+  r->table = xine_malloc_aligned ((RS_PHASES + 1) * 2 * r->taps * sizeof (float));
+  r->coef  = xine_malloc_aligned (r->taps * sizeof (float));
+  if (!r->table || !r->coef) {
+    xine_free_aligned (r->table);
+    xine_free_aligned (r->coef);
+    free (r);
+    return NULL;
+  }
+#ifndef HAVE_ZERO_SAFE_MEM
+  r->planes     = NULL;
+  r->plane_size = 0;
+#endif
+  rs_make_table (r);
+
+  r->get_coef = rs_get_coef_c;
+  r->dot      = rs_dot_c;
+#if defined(ARCH_X86) && !defined(_MSC_VER)
+  {
+    uint32_t accel = xine_mm_accel ();
+#  ifdef HAVE_AVX
+    if (accel & MM_ACCEL_X86_AVX) {
+      r->get_coef = rs_get_coef_avx;
+      r->dot      = rs_dot_avx;
+    } else
+#  endif
+    if (accel & MM_ACCEL_X86_SSE) {
+      r->get_coef = rs_get_coef_sse;
+      r->dot      = rs_dot_sse;
+    }
+  }
+#endif
+  return r;
+}
+
+void _x_audio_out_resampler_delete (xine_resampler_t **resampler) {
+  xine_resampler_t *r = *resampler;
+
+  if (!r)
+    return;
+  *resampler = NULL;
+  xine_free_aligned (r->planes);
+  xine_free_aligned (r->coef);
+  xine_free_aligned (r->table);
+  free (r);
+}
+
+void _x_audio_out_resampler_set_rates (xine_resampler_t *r, uint32_t in_rate, uint32_t out_rate) {
+  int rebuild;
+
+  if (!r || !in_rate || !out_rate)
+    return;
+  if ((in_rate == r->in_rate) && (out_rate == r->out_rate))
+    return;
+  /* the filter only depends on the downsampling ratio. */
+  rebuild = (out_rate < in_rate) || (r->out_rate < r->in_rate);
+  if (rebuild && (out_rate < in_rate) && (r->out_rate < r->in_rate)
+    && ((uint64_t)out_rate * r->in_rate == (uint64_t)r->out_rate * in_rate))
+    rebuild = 0;
+  r->in_rate  = in_rate;
+  r->out_rate = out_rate;
+  if (rebuild)
+    rs_make_table (r);
+}
+
+void _x_audio_out_resampler_reset (xine_resampler_t *r) {
+  if (r && r->planes)
+    memset (r->planes, 0, (size_t)r->channels * r->plane_size * sizeof (float));
+}
+
+/* make room for (taps + in_frames) frames per plane, keeping history. */
+static int rs_planes_size (xine_resampler_t *r, uint32_t in_frames) {
+  uint32_t need = r->taps + in_frames, size;
+  float *planes;
+  int c;
+
+  if (need <= r->plane_size)
+    return 1;
+  size = (need + 1023) & ~1023u;
+  planes = xine_mallocz_aligned ((size_t)r->channels * size * sizeof (float));
+  if (!planes)
+    return 0;
+  if (r->planes) {
+    for (c = 0; c < r->channels; c++)
+      memcpy (planes + c * size, r->planes + c * r->plane_size, r->taps * sizeof (float));
+    xine_free_aligned (r->planes);
+  }
+  r->planes     = planes;
+  r->plane_size = size;
+  return 1;
+}
+
+static void rs_load_s16 (xine_resampler_t *r, uint32_t pos, const int16_t *in, uint32_t frames) {
+  const float scale = 1.0f / 32768.0f;
+  int c, channels = r->channels;
+  for (c = 0; c < channels; c++) {
+    float *d = r->planes + c * r->plane_size + pos;
+    const int16_t *s = in + c;
+    uint32_t u;
+    for (u = 0; u < frames; u++) {
+      d[u] = (float)*s * scale;
+      s += channels;
+    }
+  }
+}
+
+static void rs_load_float (xine_resampler_t *r, uint32_t pos, const float *in, uint32_t frames) {
+  int c, channels = r->channels;
+  for (c = 0; c < channels; c++) {
+    float *d = r->planes + c * r->plane_size + pos;
+    const float *s = in + c;
+    uint32_t u;
+    for (u = 0; u < frames; u++) {
+      d[u] = *s;
+      s += channels;
+    }
+  }
+}
+
+/* without output, just update history. returns frames to load, or 0 when done. */
+static uint32_t rs_feed (xine_resampler_t *r, uint32_t in_frames, uint32_t *pos, uint32_t *skip) {
+  uint32_t taps = r->taps;
+  int c;
+
+  if (!r->planes && !rs_planes_size (r, 0))
+    return 0;
+  if (in_frames >= taps) {
+    *pos  = 0;
+    *skip = in_frames - taps;
+    return taps;
+  }
+  for (c = 0; c < r->channels; c++) {
+    float *p = r->planes + c * r->plane_size;
+    memmove (p, p + in_frames, (taps - in_frames) * sizeof (float));
+  }
+  *pos  = taps - in_frames;
+  *skip = 0;
+  return in_frames;
+}
+
+static void rs_keep_history (xine_resampler_t *r, uint32_t in_frames) {
+  int c;
+  for (c = 0; c < r->channels; c++) {
+    float *p = r->planes + c * r->plane_size;
+    memmove (p, p + in_frames, r->taps * sizeof (float));
+  }
+}
+
+/* render out_frames into float interleaved out, or int16 out16. */
+static void rs_run (xine_resampler_t *r, uint32_t in_frames, float *out, int16_t *out16, uint32_t out_frames) {
+  const int channels = r->channels;
+  const intptr_t n = r->taps;
+  /* 32.32 fixed point input position. */
+  uint64_t pos = 0, step = ((uint64_t)in_frames << 32) / out_frames;
+  uint32_t u;
+
+  for (u = 0; u < out_frames; u++) {
+    uint32_t i = pos >> 32, frac = (uint32_t)pos;
+    const float *x = r->planes + i + 1;
+    int c;
+
+    r->get_coef (r->coef, r->table + (frac >> RS_FRAC_BITS) * 2 * n,
+      (float)(frac & ((1u << RS_FRAC_BITS) - 1)) * (1.0f / (float)(1u << RS_FRAC_BITS)), n);
+    if (out16) {
+      for (c = 0; c < channels; c++) {
+        int v = lrintf (r->dot (x, r->coef, n) * 32768.0f);
+        *out16++ = v > 32767 ? 32767 : v < -32768 ? -32768 : v;
+        x += r->plane_size;
+      }
+    } else {
+      for (c = 0; c < channels; c++) {
+        *out++ = r->dot (x, r->coef, n);
+        x += r->plane_size;
+      }
+    }
+    pos += step;
+  }
+}
+
+void _x_audio_out_resampler_s16 (xine_resampler_t *r,
+  const int16_t *input_samples, uint32_t in_frames, int16_t *output_samples, uint32_t out_frames) {
+  if (!r || !in_frames)
+    return;
+  if (!out_frames) {
+    uint32_t pos, skip, frames = rs_feed (r, in_frames, &pos, &skip);
+    if (frames)
+      rs_load_s16 (r, pos, input_samples + skip * r->channels, frames);
+    return;
+  }
+  if (!rs_planes_size (r, in_frames))
+    return;
+  rs_load_s16 (r, r->taps, input_samples, in_frames);
+  rs_run (r, in_frames, NULL, output_samples, out_frames);
+  rs_keep_history (r, in_frames);
+}
+
+void _x_audio_out_resampler_float (xine_resampler_t *r,
+  const float *input_samples, uint32_t in_frames, float *output_samples, uint32_t out_frames) {
+  if (!r || !in_frames)
+    return;
+  if (!out_frames) {
+    uint32_t pos, skip, frames = rs_feed (r, in_frames, &pos, &skip);
+    if (frames)
+      rs_load_float (r, pos, input_samples + skip * r->channels, frames);
+    return;
+  }
+  if (!rs_planes_size (r, in_frames))
+    return;
+  rs_load_float (r, r->taps, input_samples, in_frames);
+  rs_run (r, in_frames, output_samples, NULL, out_frames);
+  rs_keep_history (r, in_frames);
+}
@@ -34,6 +34,9 @@
 #include <inttypes.h>
 #include <errno.h>
 #include <sys/time.h>
+#ifdef __linux__
+#  include <sys/prctl.h>
+#endif
 
 #define XINE_ENABLE_EXPERIMENTAL_FEATURES
 
@@ -165,6 +168,9 @@ typedef struct {
     /* Wakeup time. */
     struct timespec         now;
     int                     speed;
+    /* Free running clock client id, and whether that mode is on right now. */
+    int                     freerun_client;
+    int                     freerun;
   } rp;
 
   /* Get grab_lock when
@@ -211,6 +217,9 @@ typedef struct {
   video_overlay_manager_t  *overlay_source;
 
   extra_info_t             *extra_info_base; /* used to free mem chunk */
+  /* latency tracer: frame drawn time by img->id, 0 if not traced. */
+  int64_t                  *frame_trace;
+  int                       frame_trace_num;
 
   int                       current_width, current_height;
   int64_t                   current_duration;
@@ -229,6 +238,8 @@ typedef struct {
     int                     draw;
     int                     speed;
     int                     step;
+    /* render thread waits for a new frame, with no idea when it will come. */
+    int                     idle;
   } trigger_drawing;
 
 #ifdef ADD_KEYFRAME_INDEX
@@ -743,7 +754,10 @@ static vo_frame_t *vo_free_queue_get (vos_t *this,
         struct timespec ts = {0, 0};
         xine_gettime (&ts);
         ts.tv_sec += 1;
+        /* dont hold up other streams on a shared decoder thread. */
+        xine_dpool_blocking (1);
         pthread_cond_timedwait (&this->free_queue.not_empty, &this->free_queue.mutex, &ts);
+        xine_dpool_blocking (0);
       }
     }
   } while (!img);
@@ -1356,6 +1370,10 @@ static vo_frame_t *vo_get_frame (xine_video_port_t *this_gen,
   return img;
 }
 
+static int64_t *vo_frame_trace (vos_t *this, vo_frame_t *img) {
+  return (img->id >= 0) && (img->id < this->frame_trace_num) ? &this->frame_trace[img->id] : NULL;
+}
+
 /* crop_frame() will allocate a new frame to copy in the given image
  * while cropping. maybe someday this will be an automatic post plugin.
  */
@@ -1415,6 +1433,11 @@ static vo_frame_t * crop_frame( xine_video_port_t *this_gen, vo_frame_t *img ) {
   dupl->stream    = img->stream;
 
   memcpy( dupl->extra_info, img->extra_info, sizeof(extra_info_t) );
+  {
+    int64_t *trace = vo_frame_trace ((vos_t *)this_gen, dupl);
+    if (trace)
+      *trace = 0;
+  }
 
   /* delay frame processing for now, we might not even need it (eg. frame will be discarded) */
   /* vo_frame_driver_proc(dupl); */
@@ -1476,6 +1499,11 @@ static int vo_frame_draw (vo_frame_t *img, xine_stream_t *s) {
     }
     img->stream = &stream->s;
     _x_extra_info_merge( img->extra_info, stream->video_decoder_extra_info );
+    {
+      int64_t *trace = vo_frame_trace (this, img);
+      if (trace)
+        *trace = stream->side_streams[0]->latency.enabled ? xine_trace_now () : 0;
+    }
     stream->s.metronom->got_video_frame (stream->s.metronom, img);
 #ifdef ADD_KEYFRAME_INDEX
     if (FIXME: IS_KEYFRAME (img)) {
@@ -1532,8 +1560,10 @@ static int vo_frame_draw (vo_frame_t *img, xine_stream_t *s) {
       this->frame_drop_cpt--;
     }
 
-    /* do not skip decoding until output fifo frames are consumed */
-    if (this->display_queue.num_buffers + this->rp.ready_num < this->frame_drop_limit) {
+    /* do not skip decoding until output fifo frames are consumed,
+     * and never when we are not bound to wall time. */
+    if (!this->rp.freerun &&
+      (this->display_queue.num_buffers + this->rp.ready_num < this->frame_drop_limit)) {
       int duration = img->duration > 0 ? img->duration : DEFAULT_FRAME_DURATION;
       frames_to_skip = (this->last_delivery_pts - img->vpts) / duration;
       frames_to_skip = (frames_to_skip + this->frame_drop_limit) * 2;
@@ -1662,6 +1692,15 @@ static int vo_frame_draw (vo_frame_t *img, xine_stream_t *s) {
       this->trigger_drawing.draw = 1;
       pthread_cond_signal (&this->trigger_drawing.wake);
       pthread_mutex_unlock (&this->trigger_drawing.mutex);
+    } else if (this->rp.freerun || this->trigger_drawing.idle) {
+      /* free running render thread does not poll, and an idle one shall not
+       * wait for its next poll to find this frame. */
+      pthread_mutex_lock (&this->trigger_drawing.mutex);
+      if (this->trigger_drawing.idle) {
+        this->trigger_drawing.draw = 1;
+        pthread_cond_signal (&this->trigger_drawing.wake);
+      }
+      pthread_mutex_unlock (&this->trigger_drawing.mutex);
     }
 
   } else {
@@ -1670,6 +1709,8 @@ static int vo_frame_draw (vo_frame_t *img, xine_stream_t *s) {
     if (stream) {
       xine_stream_private_t *m = stream->side_streams[0];
       xine_current_extra_info_set (m, img->extra_info);
+      if (m->latency.enabled)
+        xine_latency_add (m, XINE_LATENCY_VIDEO_DROP, 0);
     }
 
     this->num_frames_skipped++;
@@ -2112,6 +2153,12 @@ static vo_frame_t *next_frame (vos_t *this, int64_t *vpts) {
       xine_log (&this->xine->x, XINE_LOG_MSG,
         _("video_out: throwing away image with pts %" PRId64 " because it's too old (diff : %" PRId64 ").\n"),
         img->vpts, diff);
+      if (img->stream) {
+        xine_stream_private_t *m = (xine_stream_private_t *)img->stream;
+        m = m->side_streams[0];
+        if (m->latency.enabled)
+          xine_latency_add (m, XINE_LATENCY_VIDEO_DROP, diff * 100 / 9);
+      }
     }
 
     this->num_frames_discarded++;
@@ -2179,6 +2226,17 @@ static void overlay_and_display_frame (vos_t *this, vo_frame_t *img, int64_t vpt
     m = m->side_streams[0];
     /* Always post first frame time to make frontend relative seek work. */
     xine_current_extra_info_set (m, img->extra_info);
+    {
+      int64_t *trace = vo_frame_trace (this, img);
+      if (trace && *trace) {
+        if (m->latency.enabled) {
+          xine_latency_add (m, XINE_LATENCY_FRAME_QUEUE, xine_trace_now () - *trace);
+          if (!this->rp.freerun && (vpts >= img->vpts))
+            xine_latency_add (m, XINE_LATENCY_FRAME_LATE, (vpts - img->vpts) * 100 / 9);
+        }
+        *trace = 0;
+      }
+    }
     /* First frame's native stream is the most common case.
      * Do it without streams lock.
      */
@@ -2348,6 +2406,46 @@ static void paused_loop( vos_t *this, int64_t vpts )
   vo_free_queue_read_unlock (this);
 }
 
+/* Free running clock: do not wait for wall time, but only for the other outputs
+ * to catch up with our next frame. Return the vpts to render at, which is that
+ * frame's own vpts when it may go now, so next_frame () never finds it late. */
+static int64_t vo_freerun_sync (vos_t *this, int64_t vpts) {
+  vo_frame_t *img;
+  int64_t want;
+
+  ADD_READY_FRAMES;
+  img = this->rp.ready_first;
+  if (!img || this->display_queue.discard_frames)
+    want = XINE_FREERUN_IDLE;
+  else
+    want = img->is_first > 0 ? vpts : img->vpts;
+  vpts = xine_freerun_want (this->clock, this->rp.freerun_client, want, img ? this->rp.poll_limit : 0);
+  return (want <= vpts) ? want : vpts;
+}
+
+static void vo_freerun_wait (vos_t *this, int64_t vpts) {
+  pthread_mutex_lock (&this->trigger_drawing.mutex);
+  this->rp.speed = this->trigger_drawing.speed;
+  if ((this->rp.speed != XINE_SPEED_PAUSE) && !this->trigger_drawing.draw
+    && !this->rp.ready_first && !this->display_queue.first) {
+    struct timespec ts = {0, 0};
+    xine_gettime (&ts);
+    ts.tv_nsec += this->rp.poll_time * 1000;
+    if (ts.tv_nsec >= 1000000000) {
+      ts.tv_sec++;
+      ts.tv_nsec -= 1000000000;
+    }
+    this->trigger_drawing.idle = 1;
+    pthread_cond_timedwait (&this->trigger_drawing.wake, &this->trigger_drawing.mutex, &ts);
+    this->trigger_drawing.idle = 0;
+    this->rp.speed = this->trigger_drawing.speed;
+  }
+  this->trigger_drawing.draw = 0;
+  pthread_mutex_unlock (&this->trigger_drawing.mutex);
+  if (this->rp.speed == XINE_SPEED_PAUSE)
+    paused_loop (this, vpts);
+}
+
 static void video_out_update_disable_flush_from_video_out(void *this_gen, xine_cfg_entry_t *entry) {
   vos_t *this = (vos_t *)this_gen;
   this->disable_decoder_flush_from_video_out = entry->num_value;
@@ -2361,6 +2459,10 @@ static void *video_out_loop (void *this_gen) {
   if (nice(-2) == -1 && errno)
     xine_log(&this->xine->x, XINE_LOG_MSG, LOG_MODULE ": can't raise nice priority by 2: %s\n", strerror(errno));
 #endif /* WIN32 */
+#if defined(__linux__) && defined(PR_SET_TIMERSLACK)
+  /* default timer slack is 50us, and we are waiting for exact frame times. */
+  prctl (PR_SET_TIMERSLACK, 1, 0, 0, 0);
+#endif
 
   this->disable_decoder_flush_from_video_out = this->xine->x.config->register_bool (this->xine->x.config,
     "engine.decoder.disable_flush_from_video_out", 0,
@@ -2384,15 +2486,22 @@ static void *video_out_loop (void *this_gen) {
   this->rp.speed = this->trigger_drawing.speed;
   pthread_mutex_unlock (&this->trigger_drawing.mutex);
 
+  this->rp.freerun_client = xine_freerun_register (this->clock);
+
   while ( this->video_loop_running ) {
     int64_t vpts, next_frame_vpts;
     int64_t usec_to_sleep;
+    int idle;
 
     /* record current time as both speed dependent virtual presentation timestamp (vpts)
      * and absolute system time, and hope these are halfway in sync.
      */
     vpts = next_frame_vpts = this->clock->get_current_time (this->clock);
     xine_gettime (&this->rp.now);
+    this->rp.freerun = (this->rp.freerun_client >= 0)
+      && this->clock->get_option (this->clock, CLOCK_FREE_RUN);
+    if (this->rp.freerun)
+      vpts = next_frame_vpts = vo_freerun_sync (this, vpts);
     lprintf ("loop iteration at %" PRId64 "\n", vpts);
 
     this->rp.wakeups_total++;
@@ -2452,6 +2561,11 @@ static void *video_out_loop (void *this_gen) {
     /* now the time critical stuff is done */
     ADD_READY_FRAMES;
 
+    if (this->rp.freerun) {
+      vo_freerun_wait (this, vpts);
+      continue;
+    }
+
     /*
      * wait until it's time to display next frame
      */
@@ -2473,11 +2587,15 @@ static void *video_out_loop (void *this_gen) {
     }
 
     /* get diff time for next iteration */
-    if (next_frame_vpts && this->rp.speed > 0)
+    idle = 0;
+    if (next_frame_vpts && this->rp.speed > 0) {
       usec_to_sleep = (next_frame_vpts - vpts) * 100 * XINE_FINE_SPEED_NORMAL / (9 * this->rp.speed);
-    else
-      /* we don't know when the next frame is due, only wait a little */
+    } else {
+      /* we don't know when the next frame is due, only wait a little,
+       * or until one arrives. */
       usec_to_sleep = this->rp.poll_time;
+      idle = !this->rp.ready_first;
+    }
 
     while (this->video_loop_running) {
       int timedout, wait;
@@ -2511,17 +2629,24 @@ static void *video_out_loop (void *this_gen) {
       pthread_mutex_lock (&this->trigger_drawing.mutex);
       if (!this->trigger_drawing.draw) {
         struct timespec abstime = this->rp.now;
+        this->trigger_drawing.idle = idle && !this->display_queue.first;
         timedout = pthread_cond_timedwait (&this->trigger_drawing.wake, &this->trigger_drawing.mutex, &abstime);
+        this->trigger_drawing.idle = 0;
       }
       this->rp.speed = this->trigger_drawing.speed;
       this->trigger_drawing.draw = 0;
       pthread_mutex_unlock (&this->trigger_drawing.mutex);
-      /* honor trigger update only when a backup img is available */
-      if (!timedout && this->grab.last_frame)
+      /* honor trigger update only when a backup img is available,
+       * or when we were waiting for a new frame. */
+      if (!timedout && (idle || this->grab.last_frame))
         break;
     }
   }
 
+  xine_freerun_unregister (this->clock, this->rp.freerun_client);
+  this->rp.freerun_client = -1;
+  this->rp.freerun = 0;
+
   /*
    * throw away undisplayed frames
    */
@@ -3163,6 +3288,7 @@ xine_video_port_t *_x_vo_new_port (xine_t *xine, vo_driver_t *driver, int grabon
   this->rp.poll_time             = 40000;
   this->rp.poll_limit            = 42000;
   this->rp.poll_num              = 200;
+  this->rp.freerun_client        = -1;
   
   /* default number of video frames from config */
   num_frame_buffers = xine->config->register_num (xine->config,
@@ -3206,7 +3332,7 @@ xine_video_port_t *_x_vo_new_port (xine_t *xine, vo_driver_t *driver, int grabon
 
   /* get some extra mem */
   {
-    uint8_t *m = xine_mallocz_aligned (num_frame_buffers * (2 * sizeof (void *) + sizeof (extra_info_t)) + 32);
+    uint8_t *m = xine_mallocz_aligned (num_frame_buffers * (2 * sizeof (void *) + sizeof (extra_info_t) + sizeof (int64_t)) + 32);
     if (!m) {
       free (this);
       return NULL;
@@ -3217,6 +3343,9 @@ xine_video_port_t *_x_vo_new_port (xine_t *xine, vo_driver_t *driver, int grabon
     m += num_frame_buffers * sizeof (void *) + 31;
     m = (uint8_t *)((uintptr_t)m & ~(uintptr_t)31);
     this->extra_info_base = (extra_info_t *)m;
+    m += num_frame_buffers * sizeof (extra_info_t);
+    this->frame_trace = (int64_t *)m;
+    this->frame_trace_num = num_frame_buffers;
   }
 
   this->overlay_source = _x_video_overlay_new_manager (xine);
@@ -181,6 +181,72 @@ void xine_current_extra_info_set (xine_stream_private_t *stream, const extra_inf
   }
 }
 
+/* The latency tracer.
+ * Bufs are stamped when allocated and put by the fifo, and evaluated when
+ * the decoder gets them. Frames are stamped by vo_frame_draw (), and
+ * evaluated by overlay_and_display_frame (). */
+
+void xine_latency_add (xine_stream_private_t *stream, int stage, int64_t usec) {
+  xine_latency_stats_t *stats = &stream->latency.stats[stage];
+  uint32_t u = usec < 0 ? 0 : usec > 0xffffffff ? 0xffffffff : usec;
+  int n;
+
+  for (n = 0; (n < XINE_LATENCY_BINS - 1) && (u >> n); n++) ;
+
+  pthread_mutex_lock (&stream->latency.lock);
+  if (!stats->count || (u < stats->min_us))
+    stats->min_us = u;
+  if (u > stats->max_us)
+    stats->max_us = u;
+  stats->count++;
+  stats->sum_us += u;
+  stats->bins[n]++;
+  pthread_mutex_unlock (&stream->latency.lock);
+}
+
+void xine_latency_got_buf (xine_stream_private_t *stream, int stage, buf_element_t *buf) {
+  int64_t input, queue;
+
+  /* this clears the stamps, dont count replayed headers again. */
+  if (!xine_buf_trace_take (buf, &input, &queue))
+    return;
+  if (input)
+    xine_latency_add (stream, stage, queue - input);
+  xine_latency_add (stream, stage + 1, xine_trace_now () - queue);
+}
+
+int xine_get_latency_stats (xine_stream_t *s, int stage, xine_latency_stats_t *stats, int reset) {
+  xine_stream_private_t *stream = (xine_stream_private_t *)s;
+
+  if (!stream || !stats || (stage < 0) || (stage >= XINE_LATENCY_STAGES))
+    return 0;
+  stream = stream->side_streams[0];
+
+  pthread_mutex_lock (&stream->latency.lock);
+  *stats = stream->latency.stats[stage];
+  if (reset)
+    memset (&stream->latency.stats[stage], 0, sizeof (stream->latency.stats[stage]));
+  pthread_mutex_unlock (&stream->latency.lock);
+  return 1;
+}
+
+int xine_get_fifo_fill (xine_stream_t *s, xine_fifo_fill_t *fill) {
+  xine_stream_private_t *stream = (xine_stream_private_t *)s;
+  fifo_buffer_t *fifo;
+
+  if (!stream || !fill)
+    return 0;
+  stream = stream->side_streams[0];
+
+  fifo = stream->s.video_fifo;
+  fill->video_bufs     = fifo ? fifo->size (fifo) : 0;
+  fill->video_capacity = fifo ? fifo->buffer_pool_capacity : 0;
+  fifo = stream->s.audio_fifo;
+  fill->audio_bufs     = fifo ? fifo->size (fifo) : 0;
+  fill->audio_capacity = fifo ? fifo->buffer_pool_capacity : 0;
+  return 1;
+}
+
 static int xine_current_extra_info_get (xine_stream_private_t *stream, extra_info_t *info) {
   int index = xine_refs_get (&stream->current_extra_info_index);
   const extra_info_t *a = &stream->current_extra_info[index & (XINE_NUM_CURR_EXTRA_INFOS - 1)];
@@ -1159,6 +1225,7 @@ xine_stream_t *xine_stream_new (xine_t *this, xine_audio_port_t *ao, xine_video_
   pthread_mutex_init (&stream->first_frame.lock, NULL);
   pthread_cond_init  (&stream->first_frame.reached, NULL);
   pthread_mutex_init (&stream->index.lock, NULL);
+  pthread_mutex_init (&stream->latency.lock, NULL);
 
   /* warning: frontend_lock is a recursive mutex. it must NOT be
    * used with neither pthread_cond_wait() or pthread_cond_timedwait()
@@ -1221,6 +1288,7 @@ xine_stream_t *xine_stream_new (xine_t *this, xine_audio_port_t *ao, xine_video_
   pthread_mutex_unlock  (&this->streams_lock);
   pthread_mutex_destroy (&stream->frontend_lock);
   pthread_mutex_destroy (&stream->index.lock);
+  pthread_mutex_destroy (&stream->latency.lock);
   pthread_cond_destroy  (&stream->first_frame.reached);
   pthread_mutex_destroy (&stream->first_frame.lock);
   pthread_cond_destroy  (&stream->counter.changed);
@@ -1268,6 +1336,7 @@ static void xine_side_dispose_internal (xine_stream_private_t *stream) {
   xine_refs_sub (&stream->current_extra_info_index, xine_refs_get (&stream->current_extra_info_index));
   pthread_mutex_destroy (&stream->frontend_lock);
   pthread_mutex_destroy (&stream->index.lock);
+  pthread_mutex_destroy (&stream->latency.lock);
   pthread_mutex_destroy (&stream->demux.pair_mutex);
   pthread_mutex_destroy (&stream->event.lock);
   pthread_mutex_destroy (&stream->counter.lock);
@@ -2564,6 +2633,7 @@ static void xine_dispose_internal (xine_stream_private_t *stream) {
 
   pthread_mutex_destroy (&stream->frontend_lock);
   pthread_mutex_destroy (&stream->index.lock);
+  pthread_mutex_destroy (&stream->latency.lock);
   pthread_cond_destroy  (&stream->first_frame.reached);
   pthread_mutex_destroy (&stream->first_frame.lock);
   pthread_cond_destroy  (&stream->counter.changed);
@@ -2641,6 +2711,10 @@ void xine_dispose (xine_stream_t *s) {
 static int xine_wsa_users = 0;
 #endif
 
+/* the last instance stops process wide helpers. */
+static pthread_mutex_t xine_instances_lock = PTHREAD_MUTEX_INITIALIZER;
+static int xine_instances = 0;
+
 void xine_exit (xine_t *this_gen) {
   xine_private_t *this = (xine_private_t *)this_gen;
   if (this->x.streams) {
@@ -2692,6 +2766,8 @@ void xine_exit (xine_t *this_gen) {
 
   xprintf (&this->x, XINE_VERBOSITY_DEBUG, "xine_exit: bye!\n");
 
+  xine_dpool_delete (&this->decoder_pool);
+
   _x_dispose_plugins (&this->x);
 
   if (this->x.clock)
@@ -2724,6 +2800,11 @@ void xine_exit (xine_t *this_gen) {
   xdgWipeHandle (&this->x.basedir_handle);
 
   free (this);
+
+  pthread_mutex_lock (&xine_instances_lock);
+  if (--xine_instances == 0)
+    xine_slices_exit ();
+  pthread_mutex_unlock (&xine_instances_lock);
 }
 
 xine_t *xine_new (void) {
@@ -2783,6 +2864,10 @@ xine_t *xine_new (void) {
   }
 #endif /* WIN32 */
 
+  pthread_mutex_lock (&xine_instances_lock);
+  xine_instances++;
+  pthread_mutex_unlock (&xine_instances_lock);
+
   this->x.verbosity = XINE_VERBOSITY_NONE;
 
   return &this->x;
@@ -2797,6 +2882,12 @@ void xine_engine_set_param(xine_t *this, int param, int value) {
       this->verbosity = value;
       break;
 
+    case XINE_ENGINE_PARAM_FREE_RUN:
+      /* the clock is shared by all streams. */
+      if (this->clock)
+        this->clock->set_option (this->clock, CLOCK_FREE_RUN, !!value);
+      break;
+
     default:
       lprintf("Unknown parameter %d\n", param);
       break;
@@ -2813,6 +2904,9 @@ int xine_engine_get_param(xine_t *this, int param) {
       return this->verbosity;
       break;
 
+    case XINE_ENGINE_PARAM_FREE_RUN:
+      return this->clock ? this->clock->get_option (this->clock, CLOCK_FREE_RUN) : 0;
+
     default:
       lprintf("Unknown parameter %d\n", param);
       break;
@@ -2881,6 +2975,16 @@ static void join_av_cb (void *this_gen, xine_cfg_entry_t *entry) {
   this->join_av = entry->num_value;
 }
 
+static void lockfree_fifo_cb (void *this_gen, xine_cfg_entry_t *entry) {
+  xine_private_t *this = (xine_private_t *)this_gen;
+  this->lockfree_fifo = entry->num_value;
+}
+
+static void post_pipeline_cb (void *this_gen, xine_cfg_entry_t *entry) {
+  xine_private_t *this = (xine_private_t *)this_gen;
+  this->post_pipeline = entry->num_value;
+}
+
 void xine_init (xine_t *this_gen) {
   xine_private_t *this = (xine_private_t *)this_gen;
 
@@ -3011,6 +3115,43 @@ void xine_init (xine_t *this_gen) {
         "This mainly serves as a test for engine side streams."),
       20, join_av_cb, this);
 
+  /*
+   * shared decoder threads
+   */
+  if (this->x.config->register_bool (this->x.config,
+      "engine.decoder.shared_threads", 0,
+      _("Decode all streams with a shared set of threads"),
+      _("Usually, each stream has its own audio and video decoder threads. "
+        "With lots of streams running in parallel, let a set of threads "
+        "as large as the number of CPUs serve them all instead.\n"
+        "This takes effect with the next xine start."),
+      20, NULL, NULL))
+    this->decoder_pool = xine_dpool_new (&this->x, xine_cpu_count ());
+
+  /*
+   * decoder fifo kind, used with the next stream opened.
+   */
+  this->lockfree_fifo = this->x.config->register_bool (this->x.config,
+      "engine.buffers.lockfree_fifo", 0,
+      _("use lock free decoder fifos"),
+      _("Pass buffers from demuxer to decoders through a lock free ring. "
+        "This saves many thread switches with small packets at high rates, "
+        "and with lots of streams running in parallel."),
+      20, lockfree_fifo_cb, this);
+
+  /*
+   * pipelined video post plugin chains
+   */
+  this->post_pipeline = this->x.config->register_bool (this->x.config,
+      "engine.performance.post_pipeline", 0,
+      _("Run video post plugins in a pipeline"),
+      _("Usually, all video post plugins of a chain process a frame one after another, "
+        "inside the decoder thread. With this, each post plugin gets its own thread, "
+        "and works on a frame while the next one in chain is still busy with the previous. "
+        "This helps with expensive filter chains on multiple CPUs, at the cost of "
+        "a few frames of extra latency."),
+      20, post_pipeline_cb, this);
+
   /*
    * keep track of all opened streams
    */
@@ -570,6 +570,15 @@ void xine_set_param (xine_stream_t *s, int param, int value) {
     }
     break;
 
+  case XINE_PARAM_LATENCY_TRACE:
+    {
+      xine_stream_private_t *m = stream->side_streams[0];
+      m->latency.enabled = !!value;
+      xine_fifo_trace_latency (m->s.video_fifo, value);
+      xine_fifo_trace_latency (m->s.audio_fifo, value);
+    }
+    break;
+
   default:
     xprintf (stream->s.xine, XINE_VERBOSITY_DEBUG,
 	     "xine_interface: unknown or deprecated stream param %d set\n", param);
@@ -743,6 +752,10 @@ int xine_get_param (xine_stream_t *s, int param) {
     ret = stream->gapless_switch;
     break;
 
+  case XINE_PARAM_LATENCY_TRACE:
+    ret = stream->side_streams[0]->latency.enabled;
+    break;
+
   default:
     xprintf (stream->s.xine, XINE_VERBOSITY_DEBUG,
 	     "xine_interface: unknown or deprecated stream param %d requested\n", param);
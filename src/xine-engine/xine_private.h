@@ -72,21 +72,29 @@ EXTERN_C_START
 #    define XINE_ATINIT(xatfa_refs,xatfa_n) atomic_init (&(xatfa_refs), (xatfa_n))
 #    define XINE_ATFA(xatfa_refs,xatfa_n) atomic_fetch_add_explicit (&(xatfa_refs), (xatfa_n), memory_order_acq_rel)
 #    define XINE_ATGET(xatfa_refs) atomic_load_explicit (&(xatfa_refs), memory_order_acquire)
+#    define XINE_ATFENCE_READ() atomic_thread_fence (memory_order_acquire)
 #  elif (HAVE_ATOMIC_VARS == 2)
 #    define XINE_ATINT_T int
 #    define XINE_ATINIT(xatfa_refs,xatfa_n) __atomic_store_n (&(xatfa_refs), (xatfa_n), __ATOMIC_RELAXED)
 #    define XINE_ATFA(xatfa_refs,xatfa_n) __atomic_fetch_add (&(xatfa_refs), (xatfa_n), __ATOMIC_ACQ_REL)
 #    define XINE_ATGET(xatfa_refs) __atomic_load_n (&(xatfa_refs), __ATOMIC_ACQUIRE)
+#    define XINE_ATFENCE_READ() __atomic_thread_fence (__ATOMIC_ACQUIRE)
 #  else /* HAVE_ATOMIC_VARS == 3 */
 #    define XINE_ATINT_T volatile int
 #    define XINE_ATINIT(xatfa_refs,xatfa_n) xatfa_refs = xatfa_n
 #    define XINE_ATFA(xatfa_refs,xatfa_n) __sync_fetch_and_add (&(xatfa_refs), (xatfa_n))
 #    if defined (ARCH_X86)
 #      define XINE_ATGET(xatfa_refs) (xatfa_refs)
+#      define XINE_ATFENCE_READ() __asm__ __volatile__ ("" : : : "memory")
 #    else
 #      define XINE_ATGET(xatfa_refs) __sync_fetch_and_add (&(xatfa_refs), 0)
+#      define XINE_ATFENCE_READ() __sync_synchronize ()
 #    endif
 #  endif
+/* XINE_ATFENCE_READ (): plain reads before it stay before a following XINE_ATGET ().
+ * Use with xine_refs_t as a sequence counter for lock free snapshots: writer does
+ * xine_refs_add (+1), modify, xine_refs_add (+1). Reader sees an odd count before
+ * and the same count after (fence, xine_refs_get ()) its copy. */
 
 typedef struct {
   XINE_ATINT_T refs;
@@ -199,6 +207,11 @@ void _x_free_audio_driver (xine_t *xine, ao_driver_t **driver) INTERNAL;
 demux_plugin_t *_x_find_demux_plugin_last_probe(xine_stream_t *stream, const char *last_demux_name, input_plugin_t *input) INTERNAL;
 input_plugin_t *_x_rip_plugin_get_instance (xine_stream_t *stream, const char *filename) INTERNAL;
 input_plugin_t *_x_cache_plugin_get_instance (xine_stream_t *stream) INTERNAL;
+/* demux content probing: keep/drop the stream head in the cache input.
+ * return 1 if the window is active. */
+int _x_cache_plugin_probe (input_plugin_t *input, int enable) INTERNAL;
+/* like _x_demux_read_header (), -1 if not served from the window. */
+int _x_cache_plugin_read_header (input_plugin_t *input, void *buf, int size) INTERNAL;
 ///@}
 
 ///@{
@@ -219,6 +232,12 @@ void _x_audio_decoder_shutdown      (xine_stream_t *stream) INTERNAL;
  */
 void xine_probe_fast_memcpy(xine_t *xine) INTERNAL;
 
+/**
+ * @brief Stop and join the xine_slices_run () helper threads.
+ * Call when the last xine instance goes away. Next use starts them again.
+ */
+void xine_slices_exit (void) INTERNAL;
+
 /**
  * @brief Make file descriptors and sockets uninheritable
  */
@@ -266,6 +285,19 @@ static inline int xine_gettime (struct timespec *ts) {
 }
 #endif
 
+/* monotonic microseconds for the latency tracer. */
+static inline int64_t xine_trace_now (void) {
+#if defined(HAVE_POSIX_TIMERS) && defined(CLOCK_MONOTONIC)
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#else
+  struct timeval tv;
+  xine_monotonic_clock (&tv, NULL);
+  return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+#endif
+}
+
 #if (defined(__GNUC__) || defined(__clang__)) && defined(ARCH_X86)
 static inline uint32_t xine_uint_mul_div (uint32_t num, uint32_t mul, uint32_t den) {
   register uint32_t eax = num, edx;
@@ -449,6 +481,10 @@ static inline void xine_uint64_2str (char **s, uint64_t v) {
     ((uint8_t *)(_ptr) >= (uint8_t *)(_start) && ((uint8_t *)(_ptr) < (uint8_t *)(_start) + (_size)))
 #endif
 
+/* shared decoder threads, see below. */
+typedef struct xine_dpool_s xine_dpool_t;
+typedef struct xine_dpool_task_s xine_dpool_task_t;
+
 typedef struct {
   xine_t                     x;
 
@@ -468,6 +504,10 @@ typedef struct {
   }                          ip_pref;
 
   uint32_t                   join_av:1;
+  /* engine.performance.post_pipeline */
+  uint32_t                   post_pipeline:1;
+  /* engine.buffers.lockfree_fifo */
+  uint32_t                   lockfree_fifo:1;
 
   /* lock controlling speed change access.
    * if we should ever introduce per stream clock and ticket,
@@ -485,6 +525,9 @@ typedef struct {
   /* special values for set_speed_internal (). now defined in xine/xine_internal.h. */
   /* # define XINE_LIVE_PAUSE_ON 0x7ffffffd */
   /* # define XINE_LIVE_PAUSE_OFF 0x7ffffffc */
+
+  /* engine.decoder.shared_threads, or NULL. */
+  xine_dpool_t              *decoder_pool;
 } xine_private_t;
   
 typedef struct xine_stream_private_st {
@@ -507,6 +550,7 @@ typedef struct xine_stream_private_st {
 
 /*  vo_driver_t               *video_driver;*/
   pthread_t                  video_thread;
+  xine_dpool_task_t         *video_task;
   video_decoder_t           *video_decoder_plugin;
   extra_info_t              *video_decoder_extra_info;
   int                        video_decoder_streamtype;
@@ -516,6 +560,7 @@ typedef struct xine_stream_private_st {
 
   int                        audio_decoder_streamtype;
   pthread_t                  audio_thread;
+  xine_dpool_task_t         *audio_task;
   audio_decoder_t           *audio_decoder_plugin;
   extra_info_t              *audio_decoder_extra_info;
 
@@ -643,10 +688,39 @@ typedef struct xine_stream_private_st {
   input_class_t             *query_input_plugins[2];
 
   extra_info_t               ei[2];
+
+  /* pipeline latency tracer, see XINE_PARAM_LATENCY_TRACE. master stream only. */
+  struct {
+    pthread_mutex_t          lock;
+    int                      enabled;
+    xine_latency_stats_t     stats[XINE_LATENCY_STAGES];
+  } latency;
 } xine_stream_private_t;
 
 void xine_current_extra_info_set (xine_stream_private_t *stream, const extra_info_t *info) INTERNAL;
 
+/* latency tracer helpers. */
+void xine_latency_add (xine_stream_private_t *stream, int stage, int64_t usec) INTERNAL;
+/* stage is XINE_LATENCY_VIDEO_INPUT or XINE_LATENCY_AUDIO_INPUT. */
+void xine_latency_got_buf (xine_stream_private_t *stream, int stage, buf_element_t *buf) INTERNAL;
+/* the stamps live in a private buf trailer (buffer.c), not in the public extra_info_t.
+ * only pool bufs are traced. take returns 0 if buf is not stamped, and clears it. */
+void xine_fifo_trace_latency (fifo_buffer_t *fifo, int enable) INTERNAL;
+int xine_buf_trace_take (buf_element_t *buf, int64_t *input, int64_t *queue) INTERNAL;
+
+/* Free running clock (CLOCK_FREE_RUN) helpers for the output loops.
+ * Register as a client, then tell the vpts you want to release next, or
+ * XINE_FREERUN_IDLE when you have nothing queued. Returns the new clock, which
+ * steps to the lowest vpts wanted by all clients, and never goes back.
+ * With timeout_us > 0, wait that long for the clock to reach vpts, with
+ * timeout_us < 0, wait until it does, or until xine_freerun_kick () of that client. */
+#define XINE_FREERUN_MAX_CLIENTS 8
+#define XINE_FREERUN_IDLE ((int64_t)0x7fffffffffffffffLL)
+int xine_freerun_register (metronom_clock_t *clock) INTERNAL;
+void xine_freerun_unregister (metronom_clock_t *clock, int client) INTERNAL;
+int64_t xine_freerun_want (metronom_clock_t *clock, int client, int64_t vpts, int timeout_us) INTERNAL;
+void xine_freerun_kick (metronom_clock_t *clock, int client) INTERNAL;
+
 /* Nasty net_buf_ctrl helper: inform about something outside its regular callbacks. */
 #define XINE_NBC_EVENT_AUDIO_DRY 1
 void xine_nbc_event (xine_stream_private_t *stream, uint32_t type) INTERNAL;
@@ -656,6 +730,35 @@ void xine_nbc_event (xine_stream_private_t *stream, uint32_t type) INTERNAL;
  * Return actual state. */
 int xine_fbc_set (fifo_buffer_t *fifo, int on) INTERNAL;
 
+/* Decoder fifo helpers for the shared decoder threads.
+ * Get next buf if there is one, NULL otherwise. Single consumer only. */
+buf_element_t *xine_fifo_try_get (fifo_buffer_t *fifo) INTERNAL;
+/* Call wake (data) after each put () and insert (). wake = NULL stops this. */
+void xine_fifo_set_wake (fifo_buffer_t *fifo, void (*wake) (void *data), void *data) INTERNAL;
+/* Type of next buf without taking it, or 0 if empty. Works with both fifo kinds. */
+uint32_t xine_fifo_peek_type (fifo_buffer_t *fifo) INTERNAL;
+
+/* Shared decoder threads, see engine.decoder.shared_threads.
+ * A task is a decoder loop of one stream. It never runs on more than 1 thread
+ * at a time, so stream buf order is kept. Its run () function does some work
+ * without waiting for new bufs, and returns one of these: */
+#define XINE_DPOOL_IDLE  0 /* nothing left to do, run again after next wake. */
+#define XINE_DPOOL_MORE  1 /* more work pending, run again soon. */
+#define XINE_DPOOL_DONE -1 /* finished, never run again. */
+#define XINE_DPOOL_LATER 2 /* output is full, run again a little later. */
+xine_dpool_t *xine_dpool_new (xine_t *xine, int num_threads) INTERNAL;
+/* all tasks must have been joined already. */
+void xine_dpool_delete (xine_dpool_t **pool) INTERNAL;
+xine_dpool_task_t *xine_dpool_task_new (xine_dpool_t *pool, int (*run) (void *data), void *data) INTERNAL;
+/* (re)schedule task. usable as xine_fifo_set_wake () callback. */
+void xine_dpool_task_wake (void *task) INTERNAL;
+/* wait until task returned XINE_DPOOL_DONE, then free it. */
+void xine_dpool_task_join (xine_dpool_task_t **task) INTERNAL;
+/* Tell the pool that the calling thread is going to wait (1) for something that
+ * other tasks may need to provide, or has returned from there (0). The pool may
+ * then start an extra thread to keep the others running. No-op outside the pool. */
+void xine_dpool_blocking (int on) INTERNAL;
+
 /** The fast text feature. */
 typedef struct xine_fast_text_s xine_fast_text_t;
 /** load fast text from file. */
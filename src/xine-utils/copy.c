@@ -1,5 +1,5 @@
 /*
- * Copyright (C) 2004-2019 the xine project
+ * Copyright (C) 2004-2022 the xine project
  *
  * This file is part of xine, a free video player.
  *
@@ -25,6 +25,8 @@
 #include "config.h"
 #endif
 
+#include <pthread.h>
+
 #include <xine/xineutils.h>
 
 static void _copy_plane(uint8_t *restrict dst, const uint8_t *restrict src,
@@ -63,26 +65,345 @@ void yuy2_to_yuy2
   _copy_plane(dst, src, dst_pitch, src_pitch, width*2, height);
 }
 
+/*
+ * row helpers for the (de)interleaving conversions below.
+ */
+
+/* a[i] = src[2 * i], b[i] = src[2 * i + 1]. */
+static void _split_c (uint8_t *restrict a, uint8_t *restrict b, const uint8_t *restrict src, int n) {
+  int x;
+
+  for (x = 0; x < n; x++) {
+    a[x] = src[2 * x];
+    b[x] = src[2 * x + 1];
+  }
+}
+
+/* a[i] = src[2 * i]. */
+static void _even_c (uint8_t *restrict a, const uint8_t *restrict src, int n) {
+  int x;
+
+  for (x = 0; x < n; x++)
+    a[x] = src[2 * x];
+}
+
+/* dst[2 * i] = a[i], dst[2 * i + 1] = b[i]. */
+static void _merge_c (uint8_t *restrict dst, const uint8_t *restrict a, const uint8_t *restrict b, int n) {
+  int x;
+
+  for (x = 0; x < n; x++) {
+    dst[2 * x]     = a[x];
+    dst[2 * x + 1] = b[x];
+  }
+}
+
+#if defined(ARCH_X86) && !defined(_MSC_VER)
+static void _split_sse2 (uint8_t *a, uint8_t *b, const uint8_t *src, int n) {
+  intptr_t k = n & ~15;
+
+  if (k) {
+    __asm__ __volatile__ (
+      "pcmpeqw\t%%xmm7, %%xmm7\n\t"
+      "psrlw\t$8, %%xmm7\n"
+      "1:\n\t"
+      "movdqu\t(%2), %%xmm0\n\t"
+      "movdqu\t16(%2), %%xmm1\n\t"
+      "movdqa\t%%xmm0, %%xmm2\n\t"
+      "movdqa\t%%xmm1, %%xmm3\n\t"
+      "pand\t%%xmm7, %%xmm0\n\t"
+      "pand\t%%xmm7, %%xmm1\n\t"
+      "psrlw\t$8, %%xmm2\n\t"
+      "psrlw\t$8, %%xmm3\n\t"
+      "packuswb\t%%xmm1, %%xmm0\n\t"
+      "packuswb\t%%xmm3, %%xmm2\n\t"
+      "movdqu\t%%xmm0, (%0)\n\t"
+      "movdqu\t%%xmm2, (%1)\n\t"
+      "add\t$32, %2\n\t"
+      "add\t$16, %0\n\t"
+      "add\t$16, %1\n\t"
+      "sub\t$16, %3\n\t"
+      "jnz\t1b"
+      : "+r" (a), "+r" (b), "+r" (src), "+r" (k)
+      :
+      : "xmm0", "xmm1", "xmm2", "xmm3", "xmm7", "cc", "memory");
+  }
+  _split_c (a, b, src, n & 15);
+}
+
+static void _even_sse2 (uint8_t *a, const uint8_t *src, int n) {
+  intptr_t k = n & ~15;
+
+  if (k) {
+    __asm__ __volatile__ (
+      "pcmpeqw\t%%xmm7, %%xmm7\n\t"
+      "psrlw\t$8, %%xmm7\n"
+      "1:\n\t"
+      "movdqu\t(%1), %%xmm0\n\t"
+      "movdqu\t16(%1), %%xmm1\n\t"
+      "pand\t%%xmm7, %%xmm0\n\t"
+      "pand\t%%xmm7, %%xmm1\n\t"
+      "packuswb\t%%xmm1, %%xmm0\n\t"
+      "movdqu\t%%xmm0, (%0)\n\t"
+      "add\t$32, %1\n\t"
+      "add\t$16, %0\n\t"
+      "sub\t$16, %2\n\t"
+      "jnz\t1b"
+      : "+r" (a), "+r" (src), "+r" (k)
+      :
+      : "xmm0", "xmm1", "xmm7", "cc", "memory");
+  }
+  _even_c (a, src, n & 15);
+}
+
+static void _merge_sse2 (uint8_t *dst, const uint8_t *a, const uint8_t *b, int n) {
+  intptr_t k = n & ~15;
+
+  if (k) {
+    __asm__ __volatile__ (
+      "1:\n\t"
+      "movdqu\t(%1), %%xmm0\n\t"
+      "movdqu\t(%2), %%xmm1\n\t"
+      "movdqa\t%%xmm0, %%xmm2\n\t"
+      "punpcklbw\t%%xmm1, %%xmm0\n\t"
+      "punpckhbw\t%%xmm1, %%xmm2\n\t"
+      "movdqu\t%%xmm0, (%0)\n\t"
+      "movdqu\t%%xmm2, 16(%0)\n\t"
+      "add\t$32, %0\n\t"
+      "add\t$16, %1\n\t"
+      "add\t$16, %2\n\t"
+      "sub\t$16, %3\n\t"
+      "jnz\t1b"
+      : "+r" (dst), "+r" (a), "+r" (b), "+r" (k)
+      :
+      : "xmm0", "xmm1", "xmm2", "cc", "memory");
+  }
+  _merge_c (dst, a, b, n & 15);
+}
+
+#ifdef HAVE_AVX2
+/* vpack* and vpunpck* work inside 128 bit lanes, thus the vperm*. */
+static void _split_avx2 (uint8_t *a, uint8_t *b, const uint8_t *src, int n) {
+  intptr_t k = n & ~31;
+
+  if (k) {
+    __asm__ __volatile__ (
+      "vpcmpeqw\t%%ymm7, %%ymm7, %%ymm7\n\t"
+      "vpsrlw\t$8, %%ymm7, %%ymm7\n"
+      "1:\n\t"
+      "vmovdqu\t(%2), %%ymm0\n\t"
+      "vmovdqu\t32(%2), %%ymm1\n\t"
+      "vpsrlw\t$8, %%ymm0, %%ymm2\n\t"
+      "vpsrlw\t$8, %%ymm1, %%ymm3\n\t"
+      "vpand\t%%ymm7, %%ymm0, %%ymm0\n\t"
+      "vpand\t%%ymm7, %%ymm1, %%ymm1\n\t"
+      "vpackuswb\t%%ymm1, %%ymm0, %%ymm0\n\t"
+      "vpackuswb\t%%ymm3, %%ymm2, %%ymm2\n\t"
+      "vpermq\t$0xd8, %%ymm0, %%ymm0\n\t"
+      "vpermq\t$0xd8, %%ymm2, %%ymm2\n\t"
+      "vmovdqu\t%%ymm0, (%0)\n\t"
+      "vmovdqu\t%%ymm2, (%1)\n\t"
+      "add\t$64, %2\n\t"
+      "add\t$32, %0\n\t"
+      "add\t$32, %1\n\t"
+      "sub\t$32, %3\n\t"
+      "jnz\t1b\n\t"
+      "vzeroupper"
+      : "+r" (a), "+r" (b), "+r" (src), "+r" (k)
+      :
+      : "xmm0", "xmm1", "xmm2", "xmm3", "xmm7", "cc", "memory");
+  }
+  _split_c (a, b, src, n & 31);
+}
+
+static void _even_avx2 (uint8_t *a, const uint8_t *src, int n) {
+  intptr_t k = n & ~31;
+
+  if (k) {
+    __asm__ __volatile__ (
+      "vpcmpeqw\t%%ymm7, %%ymm7, %%ymm7\n\t"
+      "vpsrlw\t$8, %%ymm7, %%ymm7\n"
+      "1:\n\t"
+      "vpand\t(%1), %%ymm7, %%ymm0\n\t"
+      "vpand\t32(%1), %%ymm7, %%ymm1\n\t"
+      "vpackuswb\t%%ymm1, %%ymm0, %%ymm0\n\t"
+      "vpermq\t$0xd8, %%ymm0, %%ymm0\n\t"
+      "vmovdqu\t%%ymm0, (%0)\n\t"
+      "add\t$64, %1\n\t"
+      "add\t$32, %0\n\t"
+      "sub\t$32, %2\n\t"
+      "jnz\t1b\n\t"
+      "vzeroupper"
+      : "+r" (a), "+r" (src), "+r" (k)
+      :
+      : "xmm0", "xmm1", "xmm7", "cc", "memory");
+  }
+  _even_c (a, src, n & 31);
+}
+
+static void _merge_avx2 (uint8_t *dst, const uint8_t *a, const uint8_t *b, int n) {
+  intptr_t k = n & ~31;
+
+  if (k) {
+    __asm__ __volatile__ (
+      "1:\n\t"
+      "vmovdqu\t(%1), %%ymm0\n\t"
+      "vmovdqu\t(%2), %%ymm1\n\t"
+      "vpunpcklbw\t%%ymm1, %%ymm0, %%ymm2\n\t"
+      "vpunpckhbw\t%%ymm1, %%ymm0, %%ymm3\n\t"
+      "vperm2i128\t$0x20, %%ymm3, %%ymm2, %%ymm0\n\t"
+      "vperm2i128\t$0x31, %%ymm3, %%ymm2, %%ymm1\n\t"
+      "vmovdqu\t%%ymm0, (%0)\n\t"
+      "vmovdqu\t%%ymm1, 32(%0)\n\t"
+      "add\t$64, %0\n\t"
+      "add\t$32, %1\n\t"
+      "add\t$32, %2\n\t"
+      "sub\t$32, %3\n\t"
+      "jnz\t1b\n\t"
+      "vzeroupper"
+      : "+r" (dst), "+r" (a), "+r" (b), "+r" (k)
+      :
+      : "xmm0", "xmm1", "xmm2", "xmm3", "cc", "memory");
+  }
+  _merge_c (dst, a, b, n & 31);
+}
+#endif /* HAVE_AVX2 */
+#endif /* ARCH_X86 */
+
+static struct {
+  void (*split) (uint8_t *a, uint8_t *b, const uint8_t *src, int n);
+  void (*even)  (uint8_t *a, const uint8_t *src, int n);
+  void (*merge) (uint8_t *dst, const uint8_t *a, const uint8_t *b, int n);
+} _rows = {
+  _split_c, _even_c, _merge_c
+};
+
+static pthread_once_t _rows_once = PTHREAD_ONCE_INIT;
+
+static void _rows_init (void) {
+#if defined(ARCH_X86) && !defined(_MSC_VER)
+  uint32_t caps = xine_mm_accel ();
+
+# ifdef HAVE_AVX2
+  if (caps & MM_ACCEL_X86_AVX2) {
+    _rows.split = _split_avx2;
+    _rows.even  = _even_avx2;
+    _rows.merge = _merge_avx2;
+    return;
+  }
+# endif
+  if (caps & MM_ACCEL_X86_SSE2) {
+    _rows.split = _split_sse2;
+    _rows.even  = _even_sse2;
+    _rows.merge = _merge_sse2;
+  }
+#endif
+}
+
+/*
+ * Frames bigger than full hd are converted in row bands, using
+ * xine_slices_run ().
+ */
+#define SLICE_MIN_PIXELS (1920 * 1088)
+#define SLICE_MIN_ROWS   64
+
+typedef struct {
+  const uint8_t *src[3];
+  int            src_pitch[3];
+  uint8_t       *dst[3];
+  int            dst_pitch[3];
+  int            width, height;
+} _convert_t;
+
+static int _num_slices (int width, int height) {
+  int n;
+
+  if (width * height <= SLICE_MIN_PIXELS)
+    return 1;
+  n = xine_slices_max ();
+  if (n > height / SLICE_MIN_ROWS)
+    n = height / SLICE_MIN_ROWS;
+  return n < 1 ? 1 : n;
+}
+
+/* chroma rows [*c0, *c1), and luma rows [*y0, *y1) of a slice. */
+static void _slice_rows (int height, int chroma_height, int slice, int num_slices,
+  int *c0, int *c1, int *y0, int *y1) {
+  *c0 = chroma_height * slice / num_slices;
+  *c1 = chroma_height * (slice + 1) / num_slices;
+  *y0 = *c0 * 2;
+  *y1 = (slice == num_slices - 1) ? height : *c1 * 2;
+}
+
+static void _nv12_to_yv12_slice (void *data, int slice, int num_slices) {
+  _convert_t *c = (_convert_t *)data;
+  const uint8_t *uv_src;
+  uint8_t *u_dst, *v_dst;
+  int c0, c1, y0, y1, y;
+
+  _slice_rows (c->height, c->height / 2, slice, num_slices, &c0, &c1, &y0, &y1);
+
+  _copy_plane (c->dst[0] + y0 * c->dst_pitch[0], c->src[0] + y0 * c->src_pitch[0],
+    c->dst_pitch[0], c->src_pitch[0], c->width, y1 - y0);
+
+  uv_src = c->src[1] + c0 * c->src_pitch[1];
+  u_dst  = c->dst[1] + c0 * c->dst_pitch[1];
+  v_dst  = c->dst[2] + c0 * c->dst_pitch[2];
+  for (y = c0; y < c1; y++) {
+    _rows.split (u_dst, v_dst, uv_src, c->width / 2);
+    uv_src += c->src_pitch[1];
+    u_dst += c->dst_pitch[1];
+    v_dst += c->dst_pitch[2];
+  }
+}
+
 void _x_nv12_to_yv12(const uint8_t *restrict y_src,  int y_src_pitch,
                      const uint8_t *restrict uv_src, int uv_src_pitch,
                      uint8_t *restrict y_dst, int y_dst_pitch,
                      uint8_t *restrict u_dst, int u_dst_pitch,
                      uint8_t *restrict v_dst, int v_dst_pitch,
                      int width, int height) {
+  _convert_t c = {
+    .src = { y_src, uv_src, NULL },
+    .src_pitch = { y_src_pitch, uv_src_pitch, 0 },
+    .dst = { y_dst, u_dst, v_dst },
+    .dst_pitch = { y_dst_pitch, u_dst_pitch, v_dst_pitch },
+    .width = width,
+    .height = height
+  };
 
-  int y, x;
+  pthread_once (&_rows_once, _rows_init);
+  xine_slices_run (_nv12_to_yv12_slice, &c, _num_slices (width, height));
+}
 
-  _copy_plane(y_dst, y_src, y_dst_pitch, y_src_pitch, width, height);
+static void _yv12_to_nv12_slice (void *data, int slice, int num_slices) {
+  _convert_t *c = (_convert_t *)data;
+  const uint8_t *u_src, *v_src;
+  uint8_t *uv_dst, *line;
+  int c0, c1, y0, y1, y;
 
-  for (y = 0; y < height / 2; y++) {
-    for (x = 0; x < width / 2; x++) {
-      u_dst[x] = uv_src[2*x];
-      v_dst[x] = uv_src[2*x + 1];
-    }
-    uv_src += uv_src_pitch;
-    u_dst += u_dst_pitch;
-    v_dst += v_dst_pitch;
+  _slice_rows (c->height, c->height / 2, slice, num_slices, &c0, &c1, &y0, &y1);
+
+  _copy_plane (c->dst[0] + y0 * c->dst_pitch[0], c->src[0] + y0 * c->src_pitch[0],
+    c->dst_pitch[0], c->src_pitch[0], c->width, y1 - y0);
+
+  /* Combine uv line to temporary (cached) buffer.
+     Avoids fetching destination plane to cache. */
+  line = xine_malloc_aligned (c->width + 1);
+  if (!line)
+    return;
+
+  u_src  = c->src[1] + c0 * c->src_pitch[1];
+  v_src  = c->src[2] + c0 * c->src_pitch[2];
+  uv_dst = c->dst[1] + c0 * c->dst_pitch[1];
+  for (y = c0; y < c1; y++) {
+    _rows.merge (line, u_src, v_src, c->width / 2);
+    xine_fast_memcpy (uv_dst, line, c->width);
+    uv_dst += c->dst_pitch[1];
+    u_src += c->src_pitch[1];
+    v_src += c->src_pitch[2];
   }
+
+  xine_free_aligned (line);
 }
 
 void _x_yv12_to_nv12(const uint8_t *y_src, int y_src_pitch,
@@ -91,59 +412,58 @@ void _x_yv12_to_nv12(const uint8_t *y_src, int y_src_pitch,
                      uint8_t *y_dst,  int y_dst_pitch,
                      uint8_t *uv_dst, int uv_dst_pitch,
                      int width, int height) {
-  int y, x;
-
-  _copy_plane(y_dst, y_src, y_dst_pitch, y_src_pitch, width, height);
+  _convert_t c = {
+    .src = { y_src, u_src, v_src },
+    .src_pitch = { y_src_pitch, u_src_pitch, v_src_pitch },
+    .dst = { y_dst, uv_dst, NULL },
+    .dst_pitch = { y_dst_pitch, uv_dst_pitch, 0 },
+    .width = width,
+    .height = height
+  };
 
-  /* Combine uv line to temporary (cached) buffer.
-     Avoids fetching destination plane to cache. */
-  uint8_t *line = xine_malloc_aligned(width + 1);
-  if (!line)
-    return;
+  pthread_once (&_rows_once, _rows_init);
+  xine_slices_run (_yv12_to_nv12_slice, &c, _num_slices (width, height));
+}
 
-  for(y = 0; y < height / 2; y++) {
-    for(x = 0; x < width / 2; x++) {
-      line[2*x]     = *(u_src + x);
-      line[2*x + 1] = *(v_src + x);
-    }
+static void _yuy2_to_nv12_slice (void *data, int slice, int num_slices) {
+  _convert_t *c = (_convert_t *)data;
+  const uint8_t *src;
+  uint8_t *y_dst, *uv_dst;
+  int c0, c1, y0, y1, y, n = c->width & ~1;
 
-    xine_fast_memcpy(uv_dst, line, width);
+  /* chroma comes from the even rows. */
+  _slice_rows (c->height, (c->height + 1) / 2, slice, num_slices, &c0, &c1, &y0, &y1);
+  if (y1 > c->height)
+    y1 = c->height;
 
-    uv_dst += uv_dst_pitch;
-    u_src += u_src_pitch;
-    v_src += v_src_pitch;
+  src    = c->src[0] + y0 * c->src_pitch[0];
+  y_dst  = c->dst[0] + y0 * c->dst_pitch[0];
+  uv_dst = c->dst[1] + c0 * c->dst_pitch[1];
+  for (y = y0; y < y1; y++) {
+    if (y & 1) {
+      _rows.even (y_dst, src, n);
+    } else {
+      _rows.split (y_dst, uv_dst, src, n);
+      uv_dst += c->dst_pitch[1];
+    }
+    src += c->src_pitch[0];
+    y_dst += c->dst_pitch[0];
   }
-
-  xine_free_aligned(line);
 }
 
 void _x_yuy2_to_nv12(const uint8_t *src_yuy2_map, int yuy2_pitch,
                      uint8_t *y_dst,  int y_dst_pitch,
                      uint8_t *uv_dst, int uv_dst_pitch,
                      int width, int height) {
-  int y, x;
-
-  const uint8_t *yuy2_map = src_yuy2_map;
-  for(y = 0; y < height; y++) {
-    uint8_t *y_dst_tmp = y_dst;
-    const uint8_t *yuy2_src_tmp = yuy2_map;
-    for(x = 0; x < width / 2; x++) {
-      *(y_dst_tmp++   ) = *(yuy2_src_tmp++);
-      yuy2_src_tmp++;
-      *(y_dst_tmp++   ) = *(yuy2_src_tmp++);
-      yuy2_src_tmp++;
-    }
-    y_dst += y_dst_pitch;
-    yuy2_map += yuy2_pitch;
-  }
+  _convert_t c = {
+    .src = { src_yuy2_map, NULL, NULL },
+    .src_pitch = { yuy2_pitch, 0, 0 },
+    .dst = { y_dst, uv_dst, NULL },
+    .dst_pitch = { y_dst_pitch, uv_dst_pitch, 0 },
+    .width = width,
+    .height = height
+  };
 
-  yuy2_map = src_yuy2_map;
-  for(y = 0; y < height; y += 2) {
-    for(x = 0; x < width; x += 2) {
-      *(uv_dst + x )     = *(yuy2_map + x*2 + 1);
-      *(uv_dst + x + 1 ) = *(yuy2_map + x*2 + 3);
-    }
-    uv_dst += uv_dst_pitch;
-    yuy2_map += yuy2_pitch * 2;
-  }
+  pthread_once (&_rows_once, _rows_init);
+  xine_slices_run (_yuy2_to_nv12_slice, &c, _num_slices (width, height));
 }
@@ -83,6 +83,7 @@ static uint32_t arch_accel (void)
 #ifndef _MSC_VER
   void (*old_sigill_handler)(int);
   uint32_t eax, ebx, ecx, edx;
+  uint32_t max_leaf, xcr0 = 0;
 
 #if defined(__x86_64__)
 #define cpuid(op,eax,ebx,ecx,edx)       \
@@ -94,7 +95,7 @@ static uint32_t arch_accel (void)
            "=S" (ebx),                  \
            "=c" (ecx),                  \
            "=d" (edx)                   \
-         : "a" (op)                     \
+         : "a" (op), "c" (0)            \
          : "cc")
 #elif !defined(__PIC__)
 #define cpuid(op,eax,ebx,ecx,edx)       \
@@ -103,7 +104,7 @@ static uint32_t arch_accel (void)
            "=b" (ebx),                  \
            "=c" (ecx),                  \
            "=d" (edx)                   \
-         : "a" (op)                     \
+         : "a" (op), "c" (0)            \
          : "cc")
 #else   /* PIC version : save ebx */
 #define cpuid(op,eax,ebx,ecx,edx)       \
@@ -115,7 +116,7 @@ static uint32_t arch_accel (void)
            "=S" (ebx),                  \
            "=c" (ecx),                  \
            "=d" (edx)                   \
-         : "a" (op)                     \
+         : "a" (op), "c" (0)            \
          : "cc")
 #endif
 
@@ -145,10 +146,14 @@ static uint32_t arch_accel (void)
     /* vendor string only */
     return 0;
   }
+  max_leaf = eax;
 
   /* (little endian) "Auth"                 "enti"                 "cAMD" */
   is_AMD = (ebx == 0x68747541) && (edx == 0x69746e65) && (ecx == 0x444d4163);
 
+#else
+  cpuid (0x00000000, eax, ebx, ecx, edx);
+  max_leaf = eax;
 #endif /* __x86_64__ */
 
   cpuid (0x00000001, eax, ebx, ecx, edx);
@@ -194,6 +199,7 @@ static uint32_t arch_accel (void)
     } else {
       /* Get value of extended control register 0 */
       __asm__ (".byte 0x0f, 0x01, 0xd0" : "=a"(eax), "=d"(edx) : "c" (0));
+      xcr0 = eax;
       if ((eax & 0x6) == 0x6) {
 	caps |= MM_ACCEL_X86_AVX;
       }
@@ -203,6 +209,21 @@ static uint32_t arch_accel (void)
     signal(SIGILL, old_sigill_handler);
   }
 
+  if (max_leaf >= 7) {
+    cpuid (0x00000007, eax, ebx, ecx, edx);
+    if (ebx & 0x00000200) {
+      /* enhanced rep movsb/stosb */
+      caps |= MM_ACCEL_X86_ERMS;
+    }
+    if ((ebx & 0x00000020) && (caps & MM_ACCEL_X86_AVX)) {
+      caps |= MM_ACCEL_X86_AVX2;
+    }
+    /* AVX512F, and OS saves opmask and upper zmm registers */
+    if ((ebx & 0x00010000) && ((xcr0 & 0xe6) == 0xe6)) {
+      caps |= MM_ACCEL_X86_AVX512;
+    }
+  }
+
 #ifndef __x86_64__
   cpuid (0x80000000, eax, ebx, ecx, edx);
   if (eax >= 0x80000001) {
@@ -563,6 +563,65 @@ static void * mmx2_memcpy(void * to, const void * from, size_t len)
 static void *linux_kernel_memcpy(void *to, const void *from, size_t len) {
   return linux_kernel_memcpy_impl(to,from,len);
 }
+
+/* with "enhanced rep movsb", the cpu does all the alignment and
+ * block size tricks internally. */
+static void *erms_memcpy(void *to, const void *from, size_t len) {
+  void *retval = to;
+  if (len)
+    rep_movsb (to, from, len);
+  return retval;
+}
+
+#ifdef HAVE_AVX512
+static void * avx512_memcpy(void * to, const void * from, size_t len)
+{
+  void *retval = to;
+  uintptr_t i;
+
+  if (len >= 256) {
+    /* Align destinition to 64 byte (cache line) boundary */
+    i = ((uintptr_t)to) & 63;
+    if (i) {
+      i = 64 - i;
+      len -= i;
+      rep_movsb (to, from, i);
+    }
+    i = len >> 8; /* len/256 */
+    while (i--) {
+      __asm__ __volatile__ (
+        "\n\tprefetchnta\t"MEM2("256","0")
+        "\n\tprefetchnta\t"MEM2("320","0")
+        "\n\tprefetchnta\t"MEM2("384","0")
+        "\n\tprefetchnta\t"MEM2("448","0")
+        "\n\tvmovdqu64\t"MEM1(      "0")", %%zmm0"
+        "\n\tvmovdqu64\t"MEM2( "64","0")", %%zmm1"
+        "\n\tvmovdqu64\t"MEM2("128","0")", %%zmm2"
+        "\n\tvmovdqu64\t"MEM2("192","0")", %%zmm3"
+        BUMPPTR("256","0")
+        "\n\tvmovntdq\t%%zmm0, "MEM1(      "1")
+        "\n\tvmovntdq\t%%zmm1, "MEM2( "64","1")
+        "\n\tvmovntdq\t%%zmm2, "MEM2("128","1")
+        "\n\tvmovntdq\t%%zmm3, "MEM2("192","1")
+        BUMPPTR("256","1")
+        : "=r" (from), "=r" (to)
+        : "0"  (from), "1"  (to)
+        : "memory", "xmm0", "xmm1", "xmm2", "xmm3");
+    }
+    /* since vmovntdq is weakly-ordered, a "sfence"
+     * is needed to become ordered again. */
+    __asm__ __volatile__ ("sfence":::"memory");
+    __asm__ __volatile__ ("vzeroupper");
+    len &= 255;
+  }
+  /*
+   *	Now do the tail of the block
+   */
+  if (len)
+    rep_movsb (to, from, len);
+  return retval;
+}
+#endif /* HAVE_AVX512 */
 #endif /* _MSC_VER */
 #endif /* ARCH_X86 */
 
@@ -583,6 +642,10 @@ static const struct {
 # ifdef HAVE_AVX
   { "AVX", avx_memcpy, MM_ACCEL_X86_AVX },
 # endif /* HAVE_AVX */
+  { "ERMS", erms_memcpy, MM_ACCEL_X86_ERMS },
+# ifdef HAVE_AVX512
+  { "AVX512", avx512_memcpy, MM_ACCEL_X86_AVX512 },
+# endif /* HAVE_AVX512 */
 #endif /* ARCH_X86 */
 #if defined (ARCH_PPC) && !defined (HOST_OS_DARWIN)
   { "ppcasm", ppcasm_memcpy, 0 },
@@ -591,7 +654,52 @@ static const struct {
   { "", NULL, 0 }
 };
 
-static uint64_t memcpy_timing[sizeof(memcpy_method)/sizeof(memcpy_method[0])] = { 0, };
+#define MEMCPY_NUM_METHODS (sizeof (memcpy_method) / sizeof (memcpy_method[0]))
+/* config enum value for using memcpy_table. */
+#define MEMCPY_BY_SIZE (MEMCPY_NUM_METHODS - 1)
+
+/* config names, same order as memcpy_method. */
+static const char *const memcpy_methods[] = {
+  "probe", "libc",
+#if defined(ARCH_X86) && !defined(_MSC_VER)
+  "kernel", "mmx", "mmxext", "sse",
+# ifdef HAVE_AVX
+  "avx",
+# endif /* HAVE_AVX */
+  "erms",
+# ifdef HAVE_AVX512
+  "avx512",
+# endif /* HAVE_AVX512 */
+#endif
+#if defined (ARCH_PPC) && !defined (HOST_OS_DARWIN)
+  "ppcasm_memcpy", "ppcasm_cacheable_memcpy",
+#endif
+  "by size",
+  NULL
+};
+
+/* Small buffer copies like to stay in cache, and avoid startup overhead.
+ * Big frame copies like to bypass the cache. Probe these size classes
+ * separately, and dispatch by length when they want different methods. */
+#define MEMCPY_CLASSES 4
+static const struct {
+  const char name[8];
+  uint32_t   test_len;  /* benchmark with this */
+} memcpy_class[MEMCPY_CLASSES] = {
+  { "small",  512 },        /* < 2k */
+  { "medium", 32 << 10 },   /* < 128k */
+  { "large",  512 << 10 },  /* < 2M */
+  { "huge",   4 << 20 }
+};
+#define MEMCPY_TEST_BYTES (16 << 20)
+
+static void *(*memcpy_class_func[MEMCPY_CLASSES]) (void *to, const void *from, size_t len) = {
+  memcpy, memcpy, memcpy, memcpy
+};
+
+static void *memcpy_by_size (void *to, const void *from, size_t len) {
+  return memcpy_class_func[(len >= (2 << 10)) + (len >= (128 << 10)) + (len >= (2 << 20))] (to, from, len);
+}
 
 #ifdef HAVE_POSIX_TIMERS
 /* Prefer clock_gettime() where available. */
@@ -639,71 +747,156 @@ static uint64_t rdtsc(int config_flags)
 }
 #endif
 
-static int xine_probe_fast_memcpy_int (xine_t *xine) {
-#define BUFSIZE 1024*1024
-  uint64_t     t;
+/* fill best[MEMCPY_CLASSES], return best method for "large", or 0. */
+static int xine_probe_fast_memcpy_int (xine_t *xine, int *best) {
+  uint64_t     t, timing[MEMCPY_CLASSES];
   char        *buf1, *buf2;
-  unsigned int i, j, best = 0;
+  unsigned int i, j, k, n;
   int          config_flags = xine_mm_accel ();
+  const size_t bufsize = memcpy_class[MEMCPY_CLASSES - 1].test_len;
 
-  if ((buf1 = malloc (BUFSIZE)) == NULL)
+  if ((buf1 = malloc (bufsize)) == NULL)
     return 0;
-  if ((buf2 = malloc (BUFSIZE)) == NULL) {
+  if ((buf2 = malloc (bufsize)) == NULL) {
     free (buf1);
     return 0;
   }
 
   xprintf (xine, XINE_VERBOSITY_LOG, _("Benchmarking memcpy methods (smaller is better):\n"));
+  xprintf (xine, XINE_VERBOSITY_LOG, "\t%-16s %10s %10s %10s %10s\n", "",
+    memcpy_class[0].name, memcpy_class[1].name, memcpy_class[2].name, memcpy_class[3].name);
 
   /* make sure buffers are present on physical memory */
-  memset (buf1, 0, BUFSIZE);
-  memset (buf2, 0, BUFSIZE);
+  memset (buf1, 0, bufsize);
+  memset (buf2, 0, bufsize);
 
   /* some initial activity to ensure that we're not running slowly :-) */
-  for (j = 0; j < 50; j++) {
-    memcpy_method[1].function (buf2, buf1, BUFSIZE);
-    memcpy_method[1].function (buf1, buf2, BUFSIZE);
+  for (j = 0; j < 4; j++) {
+    memcpy_method[1].function (buf2, buf1, bufsize);
+    memcpy_method[1].function (buf1, buf2, bufsize);
+  }
+
+  for (k = 0; k < MEMCPY_CLASSES; k++) {
+    best[k] = 0;
+    timing[k] = 0;
   }
 
   for (i = 1; memcpy_method[i].name[0]; i++) {
+    uint64_t tk[MEMCPY_CLASSES];
+
     if ((config_flags & memcpy_method[i].cpu_require) != memcpy_method[i].cpu_require)
       continue;
 
-    t = rdtsc (config_flags);
-    for (j = 0; j < 50; j++) {
-      memcpy_method[i].function (buf2, buf1, BUFSIZE);
-      memcpy_method[i].function (buf1, buf2, BUFSIZE);
+    for (k = 0; k < MEMCPY_CLASSES; k++) {
+      size_t len = memcpy_class[k].test_len;
+      n = MEMCPY_TEST_BYTES / 2 / len;
+      /* warm up the cache for the small sizes, like real life. */
+      memcpy_method[i].function (buf2, buf1, len);
+      t = rdtsc (config_flags);
+      for (j = 0; j < n; j++) {
+        memcpy_method[i].function (buf2, buf1, len);
+        memcpy_method[i].function (buf1, buf2, len);
+      }
+      tk[k] = rdtsc (config_flags) - t;
+      if (!best[k] || (tk[k] < timing[k])) {
+        best[k] = i;
+        timing[k] = tk[k];
+      }
     }
-    t = rdtsc (config_flags) - t;
-    memcpy_timing[i] = t;
-
-    xprintf (xine, XINE_VERBOSITY_LOG, "\t%s memcpy() : %" PRIu64 "\n", memcpy_method[i].name, t);
 
-    if (best == 0 || t < memcpy_timing[best])
-      best = i;
+    xprintf (xine, XINE_VERBOSITY_LOG, "\t%-16s %10" PRIu64 " %10" PRIu64 " %10" PRIu64 " %10" PRIu64 "\n",
+      memcpy_method[i].name, tk[0], tk[1], tk[2], tk[3]);
   }
 
   free (buf1);
   free (buf2);
 
-  return best;
+  return best[2];
+}
+
+/* "small medium large huge" method names -> method[]. return 1 if all usable. */
+static int memcpy_parse_table (const char *table, int *method) {
+  uint32_t config_flags = xine_mm_accel ();
+  const char *p = table;
+  int k;
+
+  if (!p)
+    return 0;
+  for (k = 0; k < MEMCPY_CLASSES; k++) {
+    size_t l;
+    int i;
+    while (*p == ' ')
+      p++;
+    for (l = 0; p[l] && (p[l] != ','); l++) ;
+    for (i = 1; i < (int)MEMCPY_BY_SIZE; i++) {
+      if ((strlen (memcpy_methods[i]) == l) && !strncmp (memcpy_methods[i], p, l))
+        break;
+    }
+    if ((i >= (int)MEMCPY_BY_SIZE)
+      || ((config_flags & memcpy_method[i].cpu_require) != memcpy_method[i].cpu_require))
+      return 0;
+    method[k] = i;
+    p += l;
+    if (*p == ',')
+      p++;
+  }
+  return 1;
+}
+
+static int memcpy_use_table (xine_t *xine, const char *table) {
+  int method[MEMCPY_CLASSES], k;
+
+  if (!memcpy_parse_table (table, method))
+    return 0;
+  for (k = 0; k < MEMCPY_CLASSES; k++) {
+    xprintf (xine, XINE_VERBOSITY_DEBUG, "xine_fast_memcpy (): using \"%s\" for %s copies\n",
+      memcpy_method[method[k]].name, memcpy_class[k].name);
+    memcpy_class_func[k] = memcpy_method[method[k]].function;
+  }
+  xine_fast_memcpy = memcpy_by_size;
+  return 1;
+}
+
+static void update_fast_memcpy_table (void *user_data, xine_cfg_entry_t *entry) {
+  xine_t *xine = (xine_t *)user_data;
+
+  if (xine_fast_memcpy == memcpy_by_size)
+    memcpy_use_table (xine, entry->str_value);
 }
 
 static void update_fast_memcpy (void *user_data, xine_cfg_entry_t *entry) {
   int     config_flags = xine_mm_accel ();
   xine_t *xine = (xine_t *)user_data;
   int     method = entry->num_value;
+  int     best[MEMCPY_CLASSES], k;
 
   /* check if function is configured and valid for this machine */
-  if ((method > 0) && ((size_t)method < sizeof (memcpy_method) / sizeof (memcpy_method[0]) - 1) &&
+  if ((method > 0) && ((size_t)method < MEMCPY_BY_SIZE) &&
      ((config_flags & memcpy_method[method].cpu_require) == memcpy_method[method].cpu_require)) {
     xprintf (xine, XINE_VERBOSITY_DEBUG, "xine_fast_memcpy (): using \"%s\"\n", memcpy_method[method].name);
     xine_fast_memcpy = memcpy_method[method].function;
     return;
   }
 
-  method = xine_probe_fast_memcpy_int (xine);
+  if ((size_t)method == MEMCPY_BY_SIZE) {
+    cfg_entry_t *e = xine->config->lookup_entry (xine->config, "engine.performance.memcpy_table");
+    if (e && memcpy_use_table (xine, e->str_value))
+      return;
+  }
+
+  method = xine_probe_fast_memcpy_int (xine, best);
   if (method) {
+    for (k = 1; k < MEMCPY_CLASSES; k++) {
+      if (best[k] != best[0])
+        break;
+    }
+    if (k < MEMCPY_CLASSES) {
+      char table[80];
+      snprintf (table, sizeof (table), "%s,%s,%s,%s", memcpy_methods[best[0]],
+        memcpy_methods[best[1]], memcpy_methods[best[2]], memcpy_methods[best[3]]);
+      xine->config->update_string (xine->config, "engine.performance.memcpy_table", table);
+      method = MEMCPY_BY_SIZE;
+    }
     /* should not be an endless recursion as this method will pass the test above */
     xine->config->update_num (xine->config, "engine.performance.memcpy_method", method);
   }
@@ -712,19 +905,18 @@ static void update_fast_memcpy (void *user_data, xine_cfg_entry_t *entry) {
 void xine_probe_fast_memcpy(xine_t *xine)
 {
   unsigned int      method;
-  static const char *const memcpy_methods[] = {
-    "probe", "libc",
-#if defined(ARCH_X86) && !defined(_MSC_VER)
-    "kernel", "mmx", "mmxext", "sse",
-# ifdef HAVE_AVX
-    "avx",
-# endif /* HAVE_AVX */
-#endif
-#if defined (ARCH_PPC) && !defined (HOST_OS_DARWIN)
-    "ppcasm_memcpy", "ppcasm_cacheable_memcpy",
-#endif
-    NULL
-  };
+
+  xine->config->register_string (
+    xine->config,
+    "engine.performance.memcpy_table",
+    "",
+    _("memcopy methods by copy size"),
+    _("With memcopy method \"by size\", use these methods for small, medium, large "
+      "and huge copies, separated by commas. Usually, this is detected automatically."),
+    30,
+    update_fast_memcpy_table,
+    xine
+  );
 
   method = xine->config->register_enum (
     xine->config,
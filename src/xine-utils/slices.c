@@ -0,0 +1,204 @@
+/*
+ * Copyright (C) 2000-2022 the xine project
+ *
+ * This file is part of xine, a free video player.
+ *
+ * xine is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ *
+ *
+ * parallel slice processing.
+ *
+ * Big frame conversions may be split into independent row bands. Here, a
+ * few helper threads shared by all callers run such bands, while the caller
+ * runs some itself. Helpers are started on first use, and only if there is
+ * more than 1 cpu. xine_exit () stops them with the last instance.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <pthread.h>
+
+#include <xine/xineutils.h>
+#include "../xine-engine/xine_private.h"
+
+/* memory bound work hardly scales beyond that. */
+#define SLICES_MAX_HELPERS 7
+
+typedef struct slices_job_s slices_job_t;
+struct slices_job_s {
+  slices_job_t  *next;
+  void         (*func) (void *data, int slice, int num_slices);
+  void          *data;
+  int            num;
+  int            next_slice;  /* not yet taken */
+  int            done;
+};
+
+static struct {
+  pthread_mutex_t  lock;
+  pthread_cond_t   wake;  /* helpers wait here */
+  pthread_cond_t   done;  /* callers wait here */
+  slices_job_t    *first, **add;
+  int              num_helpers;
+  int              max_helpers;
+  int              quit;
+  pthread_t        helpers[SLICES_MAX_HELPERS];
+} slices = {
+  .lock = PTHREAD_MUTEX_INITIALIZER,
+  .wake = PTHREAD_COND_INITIALIZER,
+  .done = PTHREAD_COND_INITIALIZER,
+  .first = NULL,
+  .add = &slices.first,
+  .num_helpers = 0,
+  .max_helpers = -1,
+  .quit = 0
+};
+
+/* take next slice of first job. call with slices.lock held. */
+static slices_job_t *slices_take (int *slice) {
+  slices_job_t *job = slices.first;
+
+  if (!job)
+    return NULL;
+  *slice = job->next_slice++;
+  if (job->next_slice >= job->num) {
+    slices.first = job->next;
+    if (!slices.first)
+      slices.add = &slices.first;
+    job->next = NULL;
+  }
+  return job;
+}
+
+/* run a taken slice. call with slices.lock held, returns with it held again. */
+static void slices_do (slices_job_t *job, int slice) {
+  pthread_mutex_unlock (&slices.lock);
+  job->func (job->data, slice, job->num);
+  pthread_mutex_lock (&slices.lock);
+  if (++job->done == job->num)
+    pthread_cond_broadcast (&slices.done);
+}
+
+static void *slices_helper (void *data) {
+  (void)data;
+  pthread_mutex_lock (&slices.lock);
+  while (1) {
+    slices_job_t *job;
+    int slice;
+
+    job = slices_take (&slice);
+    if (job)
+      slices_do (job, slice);
+    else if (slices.quit)
+      break;
+    else
+      pthread_cond_wait (&slices.wake, &slices.lock);
+  }
+  pthread_mutex_unlock (&slices.lock);
+  return NULL;
+}
+
+/* call with slices.lock held. */
+static void slices_start_helpers (void) {
+  int n = xine_cpu_count () - 1;
+
+  slices.max_helpers = 0;
+  if (n > SLICES_MAX_HELPERS)
+    n = SLICES_MAX_HELPERS;
+  while (slices.num_helpers < n) {
+    if (pthread_create (&slices.helpers[slices.num_helpers], NULL, slices_helper, NULL))
+      break;
+    slices.num_helpers++;
+  }
+  slices.max_helpers = slices.num_helpers;
+}
+
+void xine_slices_exit (void) {
+  int i, n;
+
+  pthread_mutex_lock (&slices.lock);
+  /* callers run their own slices when there are no helpers. */
+  n = slices.num_helpers;
+  slices.num_helpers = 0;
+  slices.max_helpers = 0;
+  slices.quit = 1;
+  pthread_cond_broadcast (&slices.wake);
+  pthread_mutex_unlock (&slices.lock);
+
+  for (i = 0; i < n; i++)
+    pthread_join (slices.helpers[i], NULL);
+
+  pthread_mutex_lock (&slices.lock);
+  slices.quit = 0;
+  slices.max_helpers = -1;
+  pthread_mutex_unlock (&slices.lock);
+}
+
+int xine_slices_max (void) {
+  int n;
+
+  pthread_mutex_lock (&slices.lock);
+  if (slices.max_helpers < 0)
+    slices_start_helpers ();
+  n = slices.max_helpers + 1;
+  pthread_mutex_unlock (&slices.lock);
+  return n;
+}
+
+void xine_slices_run (void (*func) (void *data, int slice, int num_slices), void *data, int num_slices) {
+  slices_job_t job;
+  int slice;
+
+  if (num_slices < 1)
+    return;
+  if (num_slices == 1) {
+    func (data, 0, 1);
+    return;
+  }
+
+  job.next = NULL;
+  job.func = func;
+  job.data = data;
+  job.num = num_slices;
+  job.next_slice = 0;
+  job.done = 0;
+
+  pthread_mutex_lock (&slices.lock);
+  if (slices.max_helpers < 0)
+    slices_start_helpers ();
+  if (!slices.num_helpers) {
+    pthread_mutex_unlock (&slices.lock);
+    for (slice = 0; slice < num_slices; slice++)
+      func (data, slice, num_slices);
+    return;
+  }
+  *slices.add = &job;
+  slices.add = &job.next;
+  if (num_slices > 2)
+    pthread_cond_broadcast (&slices.wake);
+  else
+    pthread_cond_signal (&slices.wake);
+  /* help out. this may also serve jobs queued before ours. */
+  while (job.next_slice < num_slices) {
+    slices_job_t *j = slices_take (&slice);
+    slices_do (j, slice);
+  }
+  while (job.done < num_slices)
+    pthread_cond_wait (&slices.done, &slices.lock);
+  pthread_mutex_unlock (&slices.lock);
+}
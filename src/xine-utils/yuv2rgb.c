@@ -89,6 +89,13 @@ static int yuv2rgb_next_slice_intf (yuv2rgb_t *this_gen, uint8_t **dest)
   return yuv2rgb_next_slice (this, dest);
 }
 
+static void yuv2rgb_start_slice (yuv2rgb_t *this_gen, int line)
+{
+  yuv2rgb_impl_t *this = (yuv2rgb_impl_t *)this_gen;
+  this->slice_offset = line;
+  this->slice_height = 16;
+}
+
 static void yuv2rgb_dispose (yuv2rgb_t *this_gen)
 {
   yuv2rgb_impl_t *this = (yuv2rgb_impl_t *)this_gen;
@@ -3355,6 +3362,7 @@ static yuv2rgb_t *yuv2rgb_create_converter (yuv2rgb_factory_t *this_gen) {
   intf = &this->intf;
   intf->configure                = yuv2rgb_configure;
   intf->next_slice               = yuv2rgb_next_slice_intf;
+  intf->start_slice              = yuv2rgb_start_slice;
   intf->dispose                  = yuv2rgb_dispose;
 
   intf->yuv2rgb_fun              = factory->yuv2rgb_fun;
@@ -3431,6 +3439,28 @@ yuv2rgb_factory_t* yuv2rgb_factory_init (int mode, int swapped,
 
   this->yuv2rgb_fun = NULL;
 #if defined(ARCH_X86)
+#if !defined(_MSC_VER)
+  if ((this->yuv2rgb_fun == NULL) && (mm & MM_ACCEL_X86_AVX2)) {
+
+    yuv2rgb_init_avx2 (this);
+
+#ifdef LOG
+    if (this->yuv2rgb_fun != NULL)
+      printf ("yuv2rgb: using AVX2 for colour space transform\n");
+#endif
+  }
+
+  if ((this->yuv2rgb_fun == NULL) && (mm & MM_ACCEL_X86_SSE2)) {
+
+    yuv2rgb_init_sse2 (this);
+
+#ifdef LOG
+    if (this->yuv2rgb_fun != NULL)
+      printf ("yuv2rgb: using SSE2 for colour space transform\n");
+#endif
+  }
+#endif
+
   if ((this->yuv2rgb_fun == NULL) && (mm & MM_ACCEL_X86_MMXEXT)) {
 
     yuv2rgb_init_mmxext (this);
@@ -93,6 +93,13 @@ struct yuv2rgb_s {
    */
   int (*next_slice) (yuv2rgb_t *this, uint8_t **dest);
 
+  /*
+   * like next_slice (this, NULL), but start with the 16 line slice at
+   * source line. several converters configured the same way may thus
+   * convert separate row bands of the same frame in parallel.
+   */
+  void (*start_slice) (yuv2rgb_t *this, int line);
+
   /*
    * free resources
    */
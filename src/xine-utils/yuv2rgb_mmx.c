@@ -66,6 +66,21 @@ struct mmx_csc_s {
   mmx_t V_red;
   mmx_t V_green;
   mmx_t Y_coeff;
+  /* the same for SSE2 and AVX2, plus some masks. keep offsets in sync
+   * with the SIMD_* macros below. */
+  struct {
+    int16_t x00ffw[16];    /*   0 */
+    int16_t x0080w[16];    /*  32 */
+    int16_t addYw[16];     /*  64 */
+    int16_t U_green[16];   /*  96 */
+    int16_t U_blue[16];    /* 128 */
+    int16_t V_red[16];     /* 160 */
+    int16_t V_green[16];   /* 192 */
+    int16_t Y_coeff[16];   /* 224 */
+    uint8_t xf8[32];       /* 256 */
+    uint8_t xfc[32];       /* 288 */
+    uint8_t shuf24[32];    /* 320 */
+  } wide;
 };
 
 extern const int32_t Inverse_Table_6_9[8][4];
@@ -131,6 +146,26 @@ void mmx_yuv2rgb_set_csc_levels(yuv2rgb_factory_t *this_gen,
     csc->x0080w.w[i]  = 128;
     csc->x00ffw.w[i]  = 0xff;
   }
+
+  for (i = 0; i < 16; i++) {
+    csc->wide.U_green[i] = -cgu;
+    csc->wide.U_blue[i]  =  cbu;
+    csc->wide.V_red[i]   =  crv;
+    csc->wide.V_green[i] = -cgv;
+    csc->wide.Y_coeff[i] =  cty;
+    csc->wide.addYw[i]   = yoffset;
+    csc->wide.x0080w[i]  = 128;
+    csc->wide.x00ffw[i]  = 0xff;
+  }
+  for (i = 0; i < 32; i++) {
+    /* 4 x 32bit -> 4 x 24bit, in each 128bit lane */
+    static const uint8_t shuf24[16] = {
+      0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, 0x80, 0x80, 0x80, 0x80
+    };
+    csc->wide.xf8[i]    = 0xf8;
+    csc->wide.xfc[i]    = 0xfc;
+    csc->wide.shuf24[i] = shuf24[i & 15];
+  }
 }
 
 static inline void mmx_yuv2rgb (const uint8_t * py,
@@ -1367,4 +1402,447 @@ void yuv2rgb_init_mmx (yuv2rgb_factory_impl_t *this) {
 }
 
 
+
+#if !defined(_MSC_VER)
+/*
+ * SSE2 and AVX2 versions. They do the same math as mmx_yuv2rgb (), giving
+ * identical output, for 16 or 32 pixels at once. A row tail that does not
+ * fill a whole block is converted via a padded copy.
+ *
+ * After the conversion part, B, R and G bytes are in register 0, 1 and 2.
+ * %[c] points to mmx_csc_t.wide.
+ */
+
+#define SSE2_YUV2RGB \
+    "movdqu\t(%[y]), %%xmm6\n\t" \
+    "pxor\t%%xmm4, %%xmm4\n\t" \
+    "movq\t(%[u]), %%xmm0\n\t" \
+    "movdqa\t%%xmm6, %%xmm7\n\t" \
+    "pand\t(%[c]), %%xmm6\n\t"          /* Y even */ \
+    "psrlw\t$8, %%xmm7\n\t"             /* Y odd */ \
+    "psllw\t$7, %%xmm6\n\t" \
+    "movq\t(%[v]), %%xmm1\n\t" \
+    "pmulhw\t224(%[c]), %%xmm6\n\t" \
+    "psllw\t$7, %%xmm7\n\t" \
+    "punpcklbw\t%%xmm4, %%xmm0\n\t" \
+    "paddsw\t64(%[c]), %%xmm6\n\t" \
+    "psubsw\t32(%[c]), %%xmm0\n\t" \
+    "punpcklbw\t%%xmm4, %%xmm1\n\t" \
+    "pmulhw\t224(%[c]), %%xmm7\n\t" \
+    "psllw\t$7, %%xmm0\n\t" \
+    "psubsw\t32(%[c]), %%xmm1\n\t" \
+    "movdqa\t%%xmm0, %%xmm2\n\t" \
+    "psllw\t$7, %%xmm1\n\t" \
+    "movdqa\t%%xmm1, %%xmm4\n\t" \
+    "paddsw\t64(%[c]), %%xmm7\n\t" \
+    "pmulhw\t128(%[c]), %%xmm0\n\t"     /* chroma_b */ \
+    "pmulhw\t160(%[c]), %%xmm1\n\t"     /* chroma_r */ \
+    "movdqa\t%%xmm0, %%xmm3\n\t" \
+    "paddsw\t%%xmm6, %%xmm0\n\t" \
+    "paddsw\t%%xmm7, %%xmm3\n\t" \
+    "psraw\t$4, %%xmm0\n\t" \
+    "pmulhw\t96(%[c]), %%xmm2\n\t" \
+    "psraw\t$4, %%xmm3\n\t" \
+    "packuswb\t%%xmm0, %%xmm0\n\t" \
+    "packuswb\t%%xmm3, %%xmm3\n\t" \
+    "pmulhw\t192(%[c]), %%xmm4\n\t" \
+    "punpcklbw\t%%xmm3, %%xmm0\n\t"     /* B */ \
+    "paddsw\t%%xmm4, %%xmm2\n\t"        /* chroma_g */ \
+    "movdqa\t%%xmm1, %%xmm4\n\t" \
+    "movdqa\t%%xmm2, %%xmm5\n\t" \
+    "paddsw\t%%xmm6, %%xmm2\n\t" \
+    "psraw\t$4, %%xmm2\n\t" \
+    "paddsw\t%%xmm6, %%xmm1\n\t" \
+    "packuswb\t%%xmm2, %%xmm2\n\t" \
+    "psraw\t$4, %%xmm1\n\t" \
+    "paddsw\t%%xmm7, %%xmm4\n\t" \
+    "packuswb\t%%xmm1, %%xmm1\n\t" \
+    "psraw\t$4, %%xmm4\n\t" \
+    "paddsw\t%%xmm7, %%xmm5\n\t" \
+    "packuswb\t%%xmm4, %%xmm4\n\t" \
+    "psraw\t$4, %%xmm5\n\t" \
+    "punpcklbw\t%%xmm4, %%xmm1\n\t"     /* R */ \
+    "packuswb\t%%xmm5, %%xmm5\n\t" \
+    "punpcklbw\t%%xmm5, %%xmm2\n\t"     /* G */
+
+/* P G Q 0 dwords -> xmm6, xmm4, xmmP, xmm5 */
+#define SSE2_TO_32(P,Q) \
+    "pxor\t%%xmm3, %%xmm3\n\t" \
+    "movdqa\t%%xmm" P ", %%xmm6\n\t" \
+    "punpcklbw\t%%xmm2, %%xmm6\n\t" \
+    "movdqa\t%%xmm" Q ", %%xmm7\n\t" \
+    "punpcklbw\t%%xmm3, %%xmm7\n\t" \
+    "movdqa\t%%xmm6, %%xmm4\n\t" \
+    "punpcklwd\t%%xmm7, %%xmm6\n\t" \
+    "punpckhwd\t%%xmm7, %%xmm4\n\t" \
+    "punpckhbw\t%%xmm2, %%xmm" P "\n\t" \
+    "punpckhbw\t%%xmm3, %%xmm" Q "\n\t" \
+    "movdqa\t%%xmm" P ", %%xmm5\n\t" \
+    "punpcklwd\t%%xmm" Q ", %%xmm" P "\n\t" \
+    "punpckhwd\t%%xmm" Q ", %%xmm5\n\t"
+
+#define SSE2_STORE_32(P) \
+    "movdqu\t%%xmm6, (%[d])\n\t" \
+    "movdqu\t%%xmm4, 16(%[d])\n\t" \
+    "movdqu\t%%xmm" P ", 32(%[d])\n\t" \
+    "movdqu\t%%xmm5, 48(%[d])\n\t"
+
+/* needs SSSE3 pshufb */
+#define SSE2_STORE_24(P) \
+    "pshufb\t320(%[c]), %%xmm6\n\t" \
+    "pshufb\t320(%[c]), %%xmm4\n\t" \
+    "pshufb\t320(%[c]), %%xmm" P "\n\t" \
+    "pshufb\t320(%[c]), %%xmm5\n\t" \
+    "movdqa\t%%xmm4, %%xmm7\n\t" \
+    "pslldq\t$12, %%xmm7\n\t" \
+    "por\t%%xmm7, %%xmm6\n\t" \
+    "movdqu\t%%xmm6, (%[d])\n\t" \
+    "psrldq\t$4, %%xmm4\n\t" \
+    "movdqa\t%%xmm" P ", %%xmm7\n\t" \
+    "pslldq\t$8, %%xmm7\n\t" \
+    "por\t%%xmm7, %%xmm4\n\t" \
+    "movdqu\t%%xmm4, 16(%[d])\n\t" \
+    "psrldq\t$8, %%xmm" P "\n\t" \
+    "pslldq\t$4, %%xmm5\n\t" \
+    "por\t%%xmm5, %%xmm" P "\n\t" \
+    "movdqu\t%%xmm" P ", 32(%[d])\n\t"
+
+/* GMASK 256: 5 bit green, 288: 6 bit green. */
+#define SSE2_STORE_16(GMASK,RSHIFT,GSHIFT) \
+    "pand\t256(%[c]), %%xmm0\n\t" \
+    "pand\t" GMASK "(%[c]), %%xmm2\n\t" \
+    "pand\t256(%[c]), %%xmm1\n\t" \
+    "psrlw\t$3, %%xmm0\n\t" \
+    "psrlw\t$" RSHIFT ", %%xmm1\n\t" \
+    "pxor\t%%xmm4, %%xmm4\n\t" \
+    "movdqa\t%%xmm2, %%xmm7\n\t" \
+    "movdqa\t%%xmm0, %%xmm5\n\t" \
+    "punpcklbw\t%%xmm4, %%xmm2\n\t" \
+    "punpcklbw\t%%xmm1, %%xmm0\n\t" \
+    "psllw\t$" GSHIFT ", %%xmm2\n\t" \
+    "punpckhbw\t%%xmm4, %%xmm7\n\t" \
+    "por\t%%xmm2, %%xmm0\n\t" \
+    "psllw\t$" GSHIFT ", %%xmm7\n\t" \
+    "punpckhbw\t%%xmm1, %%xmm5\n\t" \
+    "por\t%%xmm7, %%xmm5\n\t" \
+    "movdqu\t%%xmm0, (%[d])\n\t" \
+    "movdqu\t%%xmm5, 16(%[d])\n\t"
+
+#define SIMD_BLOCK(name,code) \
+static void name (uint8_t *d, const uint8_t *y, const uint8_t *u, const uint8_t *v, const void *c) { \
+  __asm__ __volatile__ ( \
+    code \
+    : \
+    : [d] "r" (d), [y] "r" (y), [u] "r" (u), [v] "r" (v), [c] "r" (c) \
+    : "xmm0", "xmm1", "xmm2", "xmm3", "xmm4", "xmm5", "xmm6", "xmm7", "memory"); \
+}
+
+SIMD_BLOCK (sse2_block_argb32, SSE2_YUV2RGB SSE2_TO_32 ("0", "1") SSE2_STORE_32 ("0"))
+SIMD_BLOCK (sse2_block_abgr32, SSE2_YUV2RGB SSE2_TO_32 ("1", "0") SSE2_STORE_32 ("1"))
+SIMD_BLOCK (sse2_block_rgb24,  SSE2_YUV2RGB SSE2_TO_32 ("1", "0") SSE2_STORE_24 ("1"))
+SIMD_BLOCK (sse2_block_bgr24,  SSE2_YUV2RGB SSE2_TO_32 ("0", "1") SSE2_STORE_24 ("0"))
+SIMD_BLOCK (sse2_block_rgb16,  SSE2_YUV2RGB SSE2_STORE_16 ("288", "0", "3"))
+SIMD_BLOCK (sse2_block_rgb15,  SSE2_YUV2RGB SSE2_STORE_16 ("256", "1", "2"))
+
+#ifdef HAVE_AVX2
+/* in 128bit lanes, pixels 0...15 and 16...31. */
+#define AVX2_YUV2RGB \
+    "vmovdqu\t(%[y]), %%ymm6\n\t" \
+    "vpmovzxbw\t(%[u]), %%ymm0\n\t" \
+    "vpmovzxbw\t(%[v]), %%ymm1\n\t" \
+    "vpsrlw\t$8, %%ymm6, %%ymm7\n\t" \
+    "vpand\t(%[c]), %%ymm6, %%ymm6\n\t" \
+    "vpsllw\t$7, %%ymm6, %%ymm6\n\t" \
+    "vpsllw\t$7, %%ymm7, %%ymm7\n\t" \
+    "vpmulhw\t224(%[c]), %%ymm6, %%ymm6\n\t" \
+    "vpmulhw\t224(%[c]), %%ymm7, %%ymm7\n\t" \
+    "vpaddsw\t64(%[c]), %%ymm6, %%ymm6\n\t" \
+    "vpaddsw\t64(%[c]), %%ymm7, %%ymm7\n\t" \
+    "vpsubsw\t32(%[c]), %%ymm0, %%ymm0\n\t" \
+    "vpsubsw\t32(%[c]), %%ymm1, %%ymm1\n\t" \
+    "vpsllw\t$7, %%ymm0, %%ymm0\n\t" \
+    "vpsllw\t$7, %%ymm1, %%ymm1\n\t" \
+    "vpmulhw\t96(%[c]), %%ymm0, %%ymm2\n\t" \
+    "vpmulhw\t192(%[c]), %%ymm1, %%ymm4\n\t" \
+    "vpmulhw\t128(%[c]), %%ymm0, %%ymm0\n\t" \
+    "vpmulhw\t160(%[c]), %%ymm1, %%ymm1\n\t" \
+    "vpaddsw\t%%ymm4, %%ymm2, %%ymm2\n\t" \
+    "vpaddsw\t%%ymm6, %%ymm0, %%ymm3\n\t" \
+    "vpaddsw\t%%ymm7, %%ymm0, %%ymm0\n\t" \
+    "vpsraw\t$4, %%ymm3, %%ymm3\n\t" \
+    "vpsraw\t$4, %%ymm0, %%ymm0\n\t" \
+    "vpackuswb\t%%ymm3, %%ymm3, %%ymm3\n\t" \
+    "vpackuswb\t%%ymm0, %%ymm0, %%ymm0\n\t" \
+    "vpunpcklbw\t%%ymm0, %%ymm3, %%ymm0\n\t"     /* B */ \
+    "vpaddsw\t%%ymm6, %%ymm1, %%ymm3\n\t" \
+    "vpaddsw\t%%ymm7, %%ymm1, %%ymm1\n\t" \
+    "vpsraw\t$4, %%ymm3, %%ymm3\n\t" \
+    "vpsraw\t$4, %%ymm1, %%ymm1\n\t" \
+    "vpackuswb\t%%ymm3, %%ymm3, %%ymm3\n\t" \
+    "vpackuswb\t%%ymm1, %%ymm1, %%ymm1\n\t" \
+    "vpunpcklbw\t%%ymm1, %%ymm3, %%ymm1\n\t"     /* R */ \
+    "vpaddsw\t%%ymm6, %%ymm2, %%ymm3\n\t" \
+    "vpaddsw\t%%ymm7, %%ymm2, %%ymm2\n\t" \
+    "vpsraw\t$4, %%ymm3, %%ymm3\n\t" \
+    "vpsraw\t$4, %%ymm2, %%ymm2\n\t" \
+    "vpackuswb\t%%ymm3, %%ymm3, %%ymm3\n\t" \
+    "vpackuswb\t%%ymm2, %%ymm2, %%ymm2\n\t" \
+    "vpunpcklbw\t%%ymm2, %%ymm3, %%ymm2\n\t"     /* G */
+
+/* P G Q 0 dwords -> ymm0...3, holding pixels 0...15 in the low lanes. */
+#define AVX2_TO_32(P,Q) \
+    "vpxor\t%%ymm3, %%ymm3, %%ymm3\n\t" \
+    "vpunpcklbw\t%%ymm2, %%ymm" P ", %%ymm6\n\t" \
+    "vpunpckhbw\t%%ymm2, %%ymm" P ", %%ymm4\n\t" \
+    "vpunpcklbw\t%%ymm3, %%ymm" Q ", %%ymm7\n\t" \
+    "vpunpckhbw\t%%ymm3, %%ymm" Q ", %%ymm5\n\t" \
+    "vpunpcklwd\t%%ymm7, %%ymm6, %%ymm0\n\t" \
+    "vpunpckhwd\t%%ymm7, %%ymm6, %%ymm1\n\t" \
+    "vpunpcklwd\t%%ymm5, %%ymm4, %%ymm2\n\t" \
+    "vpunpckhwd\t%%ymm5, %%ymm4, %%ymm3\n\t"
+
+#define AVX2_STORE_32 \
+    "vmovdqu\t%%xmm0, (%[d])\n\t" \
+    "vmovdqu\t%%xmm1, 16(%[d])\n\t" \
+    "vmovdqu\t%%xmm2, 32(%[d])\n\t" \
+    "vmovdqu\t%%xmm3, 48(%[d])\n\t" \
+    "vextracti128\t$1, %%ymm0, 64(%[d])\n\t" \
+    "vextracti128\t$1, %%ymm1, 80(%[d])\n\t" \
+    "vextracti128\t$1, %%ymm2, 96(%[d])\n\t" \
+    "vextracti128\t$1, %%ymm3, 112(%[d])\n\t"
+
+#define AVX2_STORE_24 \
+    "vpshufb\t320(%[c]), %%ymm0, %%ymm0\n\t" \
+    "vpshufb\t320(%[c]), %%ymm1, %%ymm1\n\t" \
+    "vpshufb\t320(%[c]), %%ymm2, %%ymm2\n\t" \
+    "vpshufb\t320(%[c]), %%ymm3, %%ymm3\n\t" \
+    "vpslldq\t$12, %%ymm1, %%ymm4\n\t" \
+    "vpor\t%%ymm4, %%ymm0, %%ymm0\n\t" \
+    "vpsrldq\t$4, %%ymm1, %%ymm1\n\t" \
+    "vpslldq\t$8, %%ymm2, %%ymm4\n\t" \
+    "vpor\t%%ymm4, %%ymm1, %%ymm1\n\t" \
+    "vpsrldq\t$8, %%ymm2, %%ymm2\n\t" \
+    "vpslldq\t$4, %%ymm3, %%ymm3\n\t" \
+    "vpor\t%%ymm3, %%ymm2, %%ymm2\n\t" \
+    "vmovdqu\t%%xmm0, (%[d])\n\t" \
+    "vmovdqu\t%%xmm1, 16(%[d])\n\t" \
+    "vmovdqu\t%%xmm2, 32(%[d])\n\t" \
+    "vextracti128\t$1, %%ymm0, 48(%[d])\n\t" \
+    "vextracti128\t$1, %%ymm1, 64(%[d])\n\t" \
+    "vextracti128\t$1, %%ymm2, 80(%[d])\n\t"
+
+#define AVX2_STORE_16(GMASK,RSHIFT,GSHIFT) \
+    "vpand\t256(%[c]), %%ymm0, %%ymm0\n\t" \
+    "vpand\t" GMASK "(%[c]), %%ymm2, %%ymm2\n\t" \
+    "vpand\t256(%[c]), %%ymm1, %%ymm1\n\t" \
+    "vpsrlw\t$3, %%ymm0, %%ymm0\n\t" \
+    "vpsrlw\t$" RSHIFT ", %%ymm1, %%ymm1\n\t" \
+    "vpxor\t%%ymm4, %%ymm4, %%ymm4\n\t" \
+    "vpunpcklbw\t%%ymm4, %%ymm2, %%ymm5\n\t" \
+    "vpunpckhbw\t%%ymm4, %%ymm2, %%ymm2\n\t" \
+    "vpunpcklbw\t%%ymm1, %%ymm0, %%ymm3\n\t" \
+    "vpunpckhbw\t%%ymm1, %%ymm0, %%ymm0\n\t" \
+    "vpsllw\t$" GSHIFT ", %%ymm5, %%ymm5\n\t" \
+    "vpsllw\t$" GSHIFT ", %%ymm2, %%ymm2\n\t" \
+    "vpor\t%%ymm5, %%ymm3, %%ymm3\n\t" \
+    "vpor\t%%ymm2, %%ymm0, %%ymm0\n\t" \
+    "vmovdqu\t%%xmm3, (%[d])\n\t" \
+    "vmovdqu\t%%xmm0, 16(%[d])\n\t" \
+    "vextracti128\t$1, %%ymm3, 32(%[d])\n\t" \
+    "vextracti128\t$1, %%ymm0, 48(%[d])\n\t"
+
+SIMD_BLOCK (avx2_block_argb32, AVX2_YUV2RGB AVX2_TO_32 ("0", "1") AVX2_STORE_32)
+SIMD_BLOCK (avx2_block_abgr32, AVX2_YUV2RGB AVX2_TO_32 ("1", "0") AVX2_STORE_32)
+SIMD_BLOCK (avx2_block_rgb24,  AVX2_YUV2RGB AVX2_TO_32 ("1", "0") AVX2_STORE_24)
+SIMD_BLOCK (avx2_block_bgr24,  AVX2_YUV2RGB AVX2_TO_32 ("0", "1") AVX2_STORE_24)
+SIMD_BLOCK (avx2_block_rgb16,  AVX2_YUV2RGB AVX2_STORE_16 ("288", "0", "3"))
+SIMD_BLOCK (avx2_block_rgb15,  AVX2_YUV2RGB AVX2_STORE_16 ("256", "1", "2"))
+#endif /* HAVE_AVX2 */
+
+typedef void (*simd_block_t) (uint8_t *d, const uint8_t *y, const uint8_t *u, const uint8_t *v, const void *c);
+
+/* one line of width pixels. */
+static inline void simd_row (simd_block_t block, int pixels, int bpp, uint8_t *img,
+  const uint8_t *py, const uint8_t *pu, const uint8_t *pv, int width, const void *csc) {
+  int i;
+
+  for (i = width / pixels; i > 0; i--) {
+    block (img, py, pu, pv, csc);
+    img += pixels * bpp;
+    py += pixels;
+    pu += pixels >> 1;
+    pv += pixels >> 1;
+  }
+  width &= pixels - 1;
+  if (width) {
+    uint8_t ybuf[32], ubuf[16], vbuf[16], out[32 * 4];
+
+    memcpy (ybuf, py, width);
+    memcpy (ubuf, pu, (width + 1) >> 1);
+    memcpy (vbuf, pv, (width + 1) >> 1);
+    block (out, ybuf, ubuf, vbuf, csc);
+    memcpy (img, out, width * bpp);
+  }
+}
+
+static inline void simd_yuv420 (yuv2rgb_t *this_gen, uint8_t *image,
+  const uint8_t *py, const uint8_t *pu, const uint8_t *pv,
+  simd_block_t block, int pixels, int bpp)
+{
+    yuv2rgb_impl_t *this = (yuv2rgb_impl_t*)this_gen;
+    int height, dst_height;
+    int rgb_stride = this->rgb_stride;
+    int y_stride   = this->y_stride;
+    int uv_stride  = this->uv_stride;
+    const void *csc = &((const mmx_csc_t *)this->table_mmx)->wide;
+
+    if (!this->do_scale) {
+      height = this_gen->next_slice (this_gen, &image);
+      do {
+        simd_row (block, pixels, bpp, image, py, pu, pv, this->source_width, csc);
+        py += y_stride;
+        image += rgb_stride;
+        if (height & 1) {
+          pu += uv_stride;
+          pv += uv_stride;
+        }
+      } while (--height);
+    } else {
+      scale_line_func_t scale_line = this->scale_line;
+      int      dy = 0;
+
+      scale_line (pu, this->u_buffer,
+                  this->dest_width >> 1, this->step_dx);
+      scale_line (pv, this->v_buffer,
+                  this->dest_width >> 1, this->step_dx);
+      scale_line (py, this->y_buffer,
+                  this->dest_width, this->step_dx);
+
+      dst_height = this_gen->next_slice (this_gen, &image);
+
+      for (height = 0;; ) {
+        simd_row (block, pixels, bpp, image, this->y_buffer, this->u_buffer, this->v_buffer,
+          this->dest_width, csc);
+
+        dy += this->step_dy;
+        image += rgb_stride;
+
+        while (--dst_height > 0 && dy < 32768) {
+          xine_fast_memcpy (image, image-rgb_stride, this->dest_width * bpp);
+          dy += this->step_dy;
+          image += rgb_stride;
+        }
+
+        if (dst_height <= 0)
+          break;
+
+        do {
+          dy -= 32768;
+          py += y_stride;
+          scale_line (py, this->y_buffer,
+                      this->dest_width, this->step_dx);
+          if (height & 1) {
+            pu += uv_stride;
+            pv += uv_stride;
+            scale_line (pu, this->u_buffer,
+                        this->dest_width >> 1, this->step_dx);
+            scale_line (pv, this->v_buffer,
+                        this->dest_width >> 1, this->step_dx);
+          }
+          height++;
+        } while (dy >= 32768);
+      }
+    }
+}
+
+#define SIMD_FUN(name,block,pixels,bpp) \
+static void name (yuv2rgb_t *this, uint8_t *image, \
+                  const uint8_t *py, const uint8_t *pu, const uint8_t *pv) \
+{ \
+    simd_yuv420 (this, image, py, pu, pv, block, pixels, bpp); \
+}
+
+SIMD_FUN (sse2_rgb15,  sse2_block_rgb15,  16, 2)
+SIMD_FUN (sse2_rgb16,  sse2_block_rgb16,  16, 2)
+SIMD_FUN (sse2_rgb24,  sse2_block_rgb24,  16, 3)
+SIMD_FUN (sse2_bgr24,  sse2_block_bgr24,  16, 3)
+SIMD_FUN (sse2_argb32, sse2_block_argb32, 16, 4)
+SIMD_FUN (sse2_abgr32, sse2_block_abgr32, 16, 4)
+
+#ifdef HAVE_AVX2
+#define AVX2_FUN(name,block,bpp) \
+static void name (yuv2rgb_t *this, uint8_t *image, \
+                  const uint8_t *py, const uint8_t *pu, const uint8_t *pv) \
+{ \
+    simd_yuv420 (this, image, py, pu, pv, block, 32, bpp); \
+    __asm__ __volatile__ ("vzeroupper"); \
+}
+
+AVX2_FUN (avx2_rgb15,  avx2_block_rgb15,  2)
+AVX2_FUN (avx2_rgb16,  avx2_block_rgb16,  2)
+AVX2_FUN (avx2_rgb24,  avx2_block_rgb24,  3)
+AVX2_FUN (avx2_bgr24,  avx2_block_bgr24,  3)
+AVX2_FUN (avx2_argb32, avx2_block_argb32, 4)
+AVX2_FUN (avx2_abgr32, avx2_block_abgr32, 4)
+#endif /* HAVE_AVX2 */
+
+static void simd_init (yuv2rgb_factory_impl_t *this, const yuv2rgb_fun_t *funs, int have_24) {
+  /* order: rgb15, rgb16, rgb24, bgr24, argb32, abgr32 */
+  int mode = this->mode;
+
+  if (this->swapped) switch (mode) {
+  case MODE_24_RGB:
+    mode = MODE_24_BGR;
+    break;
+  case MODE_24_BGR:
+    mode = MODE_24_RGB;
+    break;
+  default:
+    return; /* other swapped formats yet unsupported */
+  }
+
+  switch (mode) {
+  case MODE_15_RGB:
+    this->yuv2rgb_fun = funs[0];
+    break;
+  case MODE_16_RGB:
+    this->yuv2rgb_fun = funs[1];
+    break;
+  case MODE_24_RGB:
+    if (have_24)
+      this->yuv2rgb_fun = funs[2];
+    break;
+  case MODE_24_BGR:
+    if (have_24)
+      this->yuv2rgb_fun = funs[3];
+    break;
+  case MODE_32_RGB:
+    this->yuv2rgb_fun = funs[4];
+    break;
+  case MODE_32_BGR:
+    this->yuv2rgb_fun = funs[5];
+    break;
+  }
+}
+
+void yuv2rgb_init_sse2 (yuv2rgb_factory_impl_t *this) {
+  static const yuv2rgb_fun_t funs[] = {
+    sse2_rgb15, sse2_rgb16, sse2_rgb24, sse2_bgr24, sse2_argb32, sse2_abgr32
+  };
+  /* 24 bit packing uses pshufb. */
+  simd_init (this, funs, !!(xine_mm_accel () & MM_ACCEL_X86_SSSE3));
+}
+
+void yuv2rgb_init_avx2 (yuv2rgb_factory_impl_t *this) {
+#ifdef HAVE_AVX2
+  static const yuv2rgb_fun_t funs[] = {
+    avx2_rgb15, avx2_rgb16, avx2_rgb24, avx2_bgr24, avx2_argb32, avx2_abgr32
+  };
+  simd_init (this, funs, 1);
+#else
+  (void)this;
+#endif
+}
+#endif /* !_MSC_VER */
+
 #endif
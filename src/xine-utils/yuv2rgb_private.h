@@ -98,6 +98,8 @@ struct yuv2rgb_factory_impl_s {
 void mmx_yuv2rgb_set_csc_levels(yuv2rgb_factory_t *this,
                                 int brightness, int contrast, int saturation,
                                 int colormatrix);
+void yuv2rgb_init_avx2 (yuv2rgb_factory_impl_t *this);
+void yuv2rgb_init_sse2 (yuv2rgb_factory_impl_t *this);
 void yuv2rgb_init_mmxext (yuv2rgb_factory_impl_t *this);
 void yuv2rgb_init_mmx (yuv2rgb_factory_impl_t *this);
 void yuv2rgb_init_mlib (yuv2rgb_factory_impl_t *this);